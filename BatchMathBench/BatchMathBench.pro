@@ -0,0 +1,19 @@
+TARGET = bench_batchmath
+TEMPLATE = app
+CONFIG += console c++14
+CONFIG -= qt app_bundle
+
+# include path for OGLRender & glm
+INCLUDEPATH += ..
+
+DESTDIR =$$_PRO_FILE_PWD_/../bin/
+
+# compile directement BatchMath: pas de dependance a Qt ni au contexte GL
+DEFINES += OGLRENDER_API=
+CONFIG(debug, debug|release): message("bench_batchmath: compiler en release pour des temps significatifs")
+
+
+SOURCES += main.cpp \
+	../OGLRender/batchmath.cpp
+
+HEADERS += ../OGLRender/batchmath.h
@@ -0,0 +1,106 @@
+#include <OGLRender/batchmath.h>
+
+#include <glm/gtx/transform.hpp>
+
+#include <chrono>
+#include <vector>
+#include <random>
+#include <iostream>
+#include <iomanip>
+#include <functional>
+#include <algorithm>
+#include <cstdlib>
+#include <cfloat>
+#include <cstring>
+
+
+/// meilleur temps (ms) sur nb repetitions
+static double chrono_ms(int nb, const std::function<void()>& f)
+{
+	double best = 1e30;
+	for (int r=0; r<nb; ++r)
+	{
+		const auto t0 = std::chrono::steady_clock::now();
+		f();
+		const auto t1 = std::chrono::steady_clock::now();
+		best = std::min(best, std::chrono::duration<double, std::milli>(t1-t0).count());
+	}
+	return best;
+}
+
+/// plus grand ecart entre 2 tableaux de float
+static float max_error(const float* a, const float* b, std::size_t n)
+{
+	float e = 0.0f;
+	for (std::size_t i=0; i<n; ++i)
+		e = std::max(e, std::abs(a[i]-b[i]));
+	return e;
+}
+
+/// empeche le compilateur de supprimer les boucles de reference
+static volatile float s_sink;
+
+
+int main(int argc, char* argv[])
+{
+	std::size_t n = 1000000;
+	int reps = 20;
+	for (int i=1; i<argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--points") == 0 && i+1 < argc)
+			n = std::strtoul(argv[++i], NULL, 10);
+		else if (std::strcmp(argv[i], "--reps") == 0 && i+1 < argc)
+			reps = std::atoi(argv[++i]);
+	}
+
+	std::mt19937 gen(42);
+	std::uniform_real_distribution<float> dist(-10.0f, 10.0f);
+	std::vector<glm::vec3> a(n), b(n), ref(n), res(n);
+	for (std::size_t i=0; i<n; ++i)
+	{
+		a[i] = glm::vec3(dist(gen), dist(gen), dist(gen));
+		b[i] = glm::vec3(dist(gen), dist(gen), dist(gen));
+	}
+	std::vector<float> dref(n), dres(n);
+	const glm::mat4 m = glm::translate(glm::vec3(1,2,3)) * glm::rotate(0.7f, glm::normalize(glm::vec3(1,1,0))) * glm::scale(glm::vec3(2,1,0.5f));
+
+	std::cout << n << " points, meilleur temps sur " << reps << " essais (ms)" << std::endl;
+	std::cout << std::setw(12) << "" << std::setw(10) << "glm";
+	const BatchMath::Isa best = BatchMath::best_isa();
+	for (int i=0; i<=best; ++i)
+		std::cout << std::setw(10) << BatchMath::isa_name(BatchMath::Isa(i));
+	std::cout << "   erreur max" << std::endl;
+
+	// une ligne par operation: boucle glm de reference puis chaque jeu d'instructions
+	auto line = [&] (const char* name, const std::function<void()>& glm_loop, const std::function<void()>& batch, const float* expected, const float* result, std::size_t count)
+	{
+		std::cout << std::setw(12) << name << std::fixed << std::setprecision(3);
+		std::cout << std::setw(10) << chrono_ms(reps, glm_loop);
+		float err = 0.0f;
+		for (int i=0; i<=best; ++i)
+		{
+			BatchMath::set_isa(BatchMath::Isa(i));
+			std::cout << std::setw(10) << chrono_ms(reps, batch);
+			err = std::max(err, max_error(expected, result, count));
+		}
+		std::cout << std::scientific << std::setprecision(2) << "   " << err << std::endl;
+	};
+
+	line("transform", [&] { for (std::size_t i=0; i<n; ++i) ref[i] = glm::vec3(m*glm::vec4(a[i],1.0f)); s_sink = ref[n/2].x; },
+		[&] { BatchMath::transform_points(m, a.data(), res.data(), n); }, &ref[0].x, &res[0].x, 3*n);
+
+	line("normalize", [&] { for (std::size_t i=0; i<n; ++i) ref[i] = glm::normalize(a[i]); s_sink = ref[n/2].x; },
+		[&] { BatchMath::normalize(a.data(), res.data(), n); }, &ref[0].x, &res[0].x, 3*n);
+
+	line("dot", [&] { for (std::size_t i=0; i<n; ++i) dref[i] = glm::dot(a[i], b[i]); s_sink = dref[n/2]; },
+		[&] { BatchMath::dot(a.data(), b.data(), dres.data(), n); }, dref.data(), dres.data(), n);
+
+	line("cross", [&] { for (std::size_t i=0; i<n; ++i) ref[i] = glm::cross(a[i], b[i]); s_sink = ref[n/2].x; },
+		[&] { BatchMath::cross(a.data(), b.data(), res.data(), n); }, &ref[0].x, &res[0].x, 3*n);
+
+	glm::vec3 lo, hi;
+	line("aabb", [&] { glm::vec3 l(FLT_MAX), h(-FLT_MAX); for (std::size_t i=0; i<n; ++i) { l = glm::min(l, a[i]); h = glm::max(h, a[i]); } ref[0] = l; ref[1] = h; },
+		[&] { BatchMath::aabb(a.data(), n, lo, hi); res[0] = lo; res[1] = hi; }, &ref[0].x, &res[0].x, 6);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,18 @@
+TARGET = test_culling
+TEMPLATE = app
+CONFIG += console c++14
+CONFIG -= qt app_bundle
+
+# include path for OGLRender, glm & GL/glew.h
+INCLUDEPATH += ..
+
+DESTDIR =$$_PRO_FILE_PWD_/../bin/
+
+# compile directement le culling: aucun appel OpenGL, pas de contexte
+DEFINES += OGLRENDER_API=
+
+
+SOURCES += main.cpp \
+	../OGLRender/culling.cpp
+
+HEADERS += ../OGLRender/culling.h
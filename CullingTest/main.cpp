@@ -0,0 +1,49 @@
+#include <OGLRender/culling.h>
+
+#include <iostream>
+#include <cstdlib>
+
+
+/// nombre de verifications en echec
+static int s_failures = 0;
+
+static void check(const char* name, bool ok)
+{
+	std::cout << (ok ? "ok     " : "ECHEC  ") << name << std::endl;
+	if (!ok)
+		++s_failures;
+}
+
+
+int main()
+{
+	// matrice identite: coordonnees monde = NDC, profondeur = z*0.5+0.5
+	// tampon 256x128: 1 texel = 1/128 en x, 1/64 en y
+	OcclusionBuffer occlusion(256, 128);
+	occlusion.begin(glm::mat4(1.0f));
+
+	// grand occulteur a z=0 (profondeur 0.5), bord droit au milieu d'un texel:
+	// x = 0.30234375 -> texel 166.7, le centre du texel 166 (166.5) est couvert
+	const float edge = 0.30234375f;
+	const glm::vec3 quad[4] = { glm::vec3(-1.0f, -1.0f, 0.0f), glm::vec3(edge, -1.0f, 0.0f), glm::vec3(edge, 1.0f, 0.0f), glm::vec3(-1.0f, 1.0f, 0.0f) };
+	const int indices[6] = { 0, 1, 2, 0, 2, 3 };
+	occlusion.add_occluder(quad, indices, 6);
+	occlusion.build_hiz();
+
+	// rayon de 0.1 texel
+	const float radius = 0.1f/128.0f;
+
+	// derriere l'occulteur, bien a l'interieur: cache
+	check("objet derriere l'occulteur", !occlusion.visible(glm::vec3(-0.5f, 0.0f, 0.5f), radius));
+
+	// devant l'occulteur: visible
+	check("objet devant l'occulteur", occlusion.visible(glm::vec3(-0.5f, 0.0f, -0.5f), radius));
+
+	// derriere, juste apres le bord (texel 166.75 a 166.95, partiellement couvert): visible
+	check("objet juste apres le bord", occlusion.visible(glm::vec3(166.85f/128.0f - 1.0f, 0.0f, 0.5f), radius));
+
+	// derriere, loin du bord: visible
+	check("objet hors de l'occulteur", occlusion.visible(glm::vec3(0.8f, 0.0f, 0.5f), radius));
+
+	return s_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -2,7 +2,7 @@
 QT += core gui opengl xml widgets
 TARGET = OGLRender
 TEMPLATE = lib
-CONFIG += dynamiclib shared create_prl
+CONFIG += dynamiclib shared create_prl c++14
 
 
 # include path for glm
@@ -10,7 +10,7 @@ INCLUDEPATH += ..
 
 DESTDIR =$$_PRO_FILE_PWD_/../bin
 
-# define path for shaders
+# define path for shaders (repli pour les sources non embarquees)
 QMAKE_CXXFLAGS += -DSHADERPATH=$$_PRO_FILE_PWD_ -DOGLRENDER_DLL_EXPORT -DGLEW_BUILD
 QMAKE_CFLAGS += -DGLEW_BUILD
 
@@ -23,9 +23,48 @@ QMAKE_LFLAGS_SONAME += -Wl,-install_name,@rpath/lib$${TARGET}.dylib
 win32 {
 CONFIG += embed_manifest_dll
 LIBS += -lopengl32
+# geometrie des primitives generee par constexpr
+QMAKE_CXXFLAGS += -constexpr:steps10000000
 }
 
 
-SOURCES += shader.cpp shaderprogram.cpp shaderprogramcolor.cpp shaderprogramflat.cpp shaderprogramphong.cpp glew.c
+SOURCES += shader.cpp shaderprogram.cpp shaderprogramcolor.cpp shaderprogramflat.cpp shaderprogramphong.cpp shaderprogramflatinstanced.cpp shaderprogramcolorinstanced.cpp shaderprogramregistry.cpp programcache.cpp camerauniforms.cpp glstate.cpp renderqueue.cpp culling.cpp primitives.cpp scenegraph.cpp meshbatch.cpp framestats.cpp profiler.cpp batchmath.cpp glew.c
 
-HEADERS  += shaderprogram.h shader.h shaderprogramcolor.h shaderprogramflat.h shaderprogramphong.h
+HEADERS  += shaderprogram.h shader.h shaderprogramcolor.h shaderprogramflat.h shaderprogramphong.h shaderprogramflatinstanced.h shaderprogramcolorinstanced.h shaderprogramregistry.h programcache.h camerauniforms.h glstate.h renderqueue.h animationthread.h culling.h primitives.h scenegraph.h meshbatch.h framestats.h profiler.h batchmath.h
+
+
+# sources GLSL embarquees dans la lib: table generee a chaque passage de qmake
+GLSL = colorshader.vert colorshader.frag flatshader.vert flatshader.frag phongshader.vert phongshader.frag \
+	flatinstshader.vert flatinstshader.frag colorinstshader.vert colorinstshader.frag
+
+GLSL_TABLE = $$OUT_PWD/shadersources.cpp
+GLSL_CODE = "// genere par OGLRender.pro a partir de: $$GLSL" \
+	"// ne pas modifier, relancer qmake" \
+	"$${LITERAL_HASH}include \"shader.h\"" \
+	"" \
+	"namespace" \
+	"{" \
+	"	struct Source { const char* name; const char* code; };" \
+	"	const Source s_sources[] =" \
+	"	{"
+for(f, GLSL) {
+	GLSL_CODE += "		{ \"$$f\", R\"glsl($$cat($$_PRO_FILE_PWD_/$$f, blob))glsl\" },"
+}
+GLSL_CODE += "		{ nullptr, nullptr }" \
+	"	};" \
+	"}" \
+	"" \
+	"const char* Shader::embedded(const std::string& filename)" \
+	"{" \
+	"	for (const Source* s = s_sources; s->name != nullptr; ++s)" \
+	"		if (filename == s->name)" \
+	"			return s->code;" \
+	"	return nullptr;" \
+	"}"
+write_file($$GLSL_TABLE, GLSL_CODE)|error("cannot write $$GLSL_TABLE")
+
+# modifier un shader relance qmake (donc regenere la table)
+for(f, GLSL): QMAKE_INTERNAL_INCLUDED_FILES += $$_PRO_FILE_PWD_/$$f
+
+SOURCES += $$GLSL_TABLE
+OTHER_FILES += $$GLSL
@@ -0,0 +1,190 @@
+#ifndef ANIMATIONTHREAD_H
+#define ANIMATIONTHREAD_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <functional>
+
+/**
+ * @brief Etat d'animation avance a pas fixe par un thread dedie
+ *
+ * Le thread appelle step(etat, dt) tous les dt secondes (rattrapage
+ * borne s'il prend du retard) puis publie le couple (etat precedent,
+ * etat courant). La publication passe par un triple tampon: le rendu
+ * lit toujours le dernier couple complet, sans verrou et sans bloquer
+ * le thread d'animation. snapshot() donne aussi le coefficient
+ * d'interpolation entre les deux etats a l'instant du rendu.
+ *
+ * Un seul thread lecteur (celui du rendu).
+ */
+template <typename State>
+class AnimationThread
+{
+public:
+	typedef std::function<void(State&, double)> StepFunc;
+	typedef std::chrono::steady_clock Clock;
+
+	/**
+	 * @brief constructeur
+	 * @param dt pas de temps fixe (secondes)
+	 */
+	explicit AnimationThread(double dt = 0.02):
+		m_dt(dt),
+		m_quit(false),
+		m_paused(false),
+		m_back(0),
+		m_ready(1),
+		m_front(2)
+	{}
+
+	~AnimationThread()
+	{
+		stop();
+	}
+
+	/**
+	 * @brief lance le thread
+	 * @param init etat initial
+	 * @param step avance l'etat d'un pas (appelee dans le thread)
+	 */
+	void start(const State& init, const StepFunc& step)
+	{
+		stop();
+		for (int i=0; i<3; ++i)
+		{
+			m_buffers[i].prev = init;
+			m_buffers[i].cur = init;
+			m_buffers[i].time = Clock::now();
+		}
+		m_step = step;
+		m_quit = false;
+		m_thread = std::thread(&AnimationThread::run, this, init);
+	}
+
+	/// arrete le thread (le dernier etat publie reste lisible)
+	void stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_pause_mutex);
+			m_quit = true;
+		}
+		m_resume.notify_all();
+		if (m_thread.joinable())
+			m_thread.join();
+	}
+
+	/// suspend/reprend l'animation (le temps ne s'ecoule pas pendant la pause)
+	void set_paused(bool p)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_pause_mutex);
+			m_paused = p;
+		}
+		m_resume.notify_all();
+	}
+
+	inline bool paused() const		{ return m_paused; }
+
+	inline double timestep() const	{ return m_dt; }
+
+	/**
+	 * @brief dernier couple d'etats publie (thread de rendu)
+	 * @param prev etat precedent [out]
+	 * @param cur etat courant [out]
+	 * @return coefficient d'interpolation prev -> cur, dans [0,1]
+	 */
+	float snapshot(State& prev, State& cur)
+	{
+		if (m_ready.load(std::memory_order_acquire) & FRESH)
+			m_front = m_ready.exchange(m_front, std::memory_order_acq_rel) & INDEX;
+
+		const Snapshot& s = m_buffers[m_front];
+		prev = s.prev;
+		cur = s.cur;
+
+		// rendu en retard d'un pas: l'etat courant est atteint dt apres sa date
+		const double elapsed = std::chrono::duration<double>(Clock::now() - s.time).count();
+		const double alpha = elapsed / m_dt;
+		return float(alpha < 0.0 ? 0.0 : (alpha > 1.0 ? 1.0 : alpha));
+	}
+
+protected:
+	/// nombre maximum de pas rattrapes d'un coup (au-dela le temps est perdu)
+	enum { MAX_CATCHUP = 5 };
+	/// bits de m_ready: indice du tampon et "nouveau"
+	enum { INDEX = 3, FRESH = 4 };
+
+	struct Snapshot
+	{
+		State prev;
+		State cur;
+		Clock::time_point time;
+	};
+
+	void run(State state)
+	{
+		const Clock::duration dt = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(m_dt));
+		Clock::time_point next = Clock::now();
+
+		while (!m_quit)
+		{
+			if (m_paused)
+			{
+				// endormi jusqu'a la reprise ou l'arret
+				std::unique_lock<std::mutex> lock(m_pause_mutex);
+				m_resume.wait(lock, [this] { return !m_paused || m_quit; });
+				next = Clock::now();
+				continue;
+			}
+
+			State prev = state;
+			int steps = 0;
+			while (Clock::now() >= next && steps < MAX_CATCHUP)
+			{
+				prev = state;
+				m_step(state, m_dt);
+				next += dt;
+				++steps;
+			}
+			// trop de retard: on repart de maintenant
+			if (steps == MAX_CATCHUP && Clock::now() >= next)
+				next = Clock::now();
+
+			if (steps > 0)
+			{
+				Snapshot& s = m_buffers[m_back];
+				s.prev = prev;
+				s.cur = state;
+				s.time = next - dt;
+				m_back = m_ready.exchange(m_back | FRESH, std::memory_order_acq_rel) & INDEX;
+			}
+
+			std::this_thread::sleep_until(next);
+		}
+	}
+
+	double m_dt;
+	StepFunc m_step;
+
+	std::thread m_thread;
+	std::atomic<bool> m_quit;
+	std::atomic<bool> m_paused;
+	/// reveil du thread en pause (m_paused et m_quit modifies sous m_pause_mutex)
+	std::mutex m_pause_mutex;
+	std::condition_variable m_resume;
+
+	/// triple tampon: ecrit par le thread (m_back), lu par le rendu (m_front)
+	Snapshot m_buffers[3];
+	int m_back;
+	std::atomic<int> m_ready;
+	int m_front;
+
+private:
+	AnimationThread(const AnimationThread&);
+	AnimationThread& operator=(const AnimationThread&);
+};
+
+#endif // ANIMATIONTHREAD_H
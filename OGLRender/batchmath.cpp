@@ -0,0 +1,485 @@
+#include "batchmath.h"
+
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#define BATCHMATH_X86 1
+#ifdef _MSC_VER
+#include <intrin.h>
+// pas d'attribut: les intrinsics AVX2 sont toujours disponibles
+#define BATCHMATH_AVX2
+#else
+#define BATCHMATH_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+
+namespace
+{
+	static_assert(sizeof(glm::vec3) == 3*sizeof(float), "glm::vec3 doit etre compact");
+
+	typedef void (*TransformFn)(const glm::mat4&, const glm::vec3*, glm::vec3*, std::size_t, float);
+	typedef void (*NormalizeFn)(const glm::vec3*, glm::vec3*, std::size_t);
+	typedef void (*DotFn)(const glm::vec3*, const glm::vec3*, float*, std::size_t);
+	typedef void (*CrossFn)(const glm::vec3*, const glm::vec3*, glm::vec3*, std::size_t);
+	typedef void (*AabbFn)(const glm::vec3*, std::size_t, glm::vec3&, glm::vec3&);
+
+	/// versions d'un jeu d'instructions
+	struct Kernels
+	{
+		TransformFn transform;
+		NormalizeFn normalize;
+		DotFn dot;
+		CrossFn cross;
+		AabbFn aabb;
+	};
+
+	const float NORMALIZE_EPSILON = 0.000001f;
+
+
+	//
+	// scalaire (et fin des tableaux des versions SIMD)
+	//
+
+	void transform_scalar(const glm::mat4& m, const glm::vec3* in, glm::vec3* out, std::size_t n, float w)
+	{
+		const glm::vec3 c0(m[0]), c1(m[1]), c2(m[2]), c3(glm::vec3(m[3])*w);
+		for (std::size_t i=0; i<n; ++i)
+		{
+			const glm::vec3 p = in[i];
+			out[i] = c0*p.x + c1*p.y + c2*p.z + c3;
+		}
+	}
+
+	void normalize_scalar(const glm::vec3* in, glm::vec3* out, std::size_t n)
+	{
+		for (std::size_t i=0; i<n; ++i)
+		{
+			const glm::vec3 v = in[i];
+			const float l = std::sqrt(v.x*v.x + v.y*v.y + v.z*v.z);
+			out[i] = (l < NORMALIZE_EPSILON) ? v : v/l;
+		}
+	}
+
+	void dot_scalar(const glm::vec3* a, const glm::vec3* b, float* out, std::size_t n)
+	{
+		for (std::size_t i=0; i<n; ++i)
+			out[i] = a[i].x*b[i].x + a[i].y*b[i].y + a[i].z*b[i].z;
+	}
+
+	void cross_scalar(const glm::vec3* a, const glm::vec3* b, glm::vec3* out, std::size_t n)
+	{
+		for (std::size_t i=0; i<n; ++i)
+		{
+			const glm::vec3 u = a[i];
+			const glm::vec3 v = b[i];
+			out[i] = glm::vec3(u.y*v.z - u.z*v.y, u.z*v.x - u.x*v.z, u.x*v.y - u.y*v.x);
+		}
+	}
+
+	void aabb_scalar(const glm::vec3* p, std::size_t n, glm::vec3& bmin, glm::vec3& bmax)
+	{
+		glm::vec3 lo(FLT_MAX), hi(-FLT_MAX);
+		for (std::size_t i=0; i<n; ++i)
+		{
+			lo = glm::min(lo, p[i]);
+			hi = glm::max(hi, p[i]);
+		}
+		bmin = lo;
+		bmax = hi;
+	}
+
+	const Kernels s_scalar = { transform_scalar, normalize_scalar, dot_scalar, cross_scalar, aabb_scalar };
+
+
+#ifdef BATCHMATH_X86
+
+	//
+	// SSE: 4 vec3 (3 registres) <-> x,y,z de 4 elements
+	//
+
+	inline void load4(const glm::vec3* p, __m128& x, __m128& y, __m128& z)
+	{
+		const float* f = &p[0].x;
+		const __m128 a = _mm_loadu_ps(f);		// x0 y0 z0 x1
+		const __m128 b = _mm_loadu_ps(f+4);		// y1 z1 x2 y2
+		const __m128 c = _mm_loadu_ps(f+8);		// z2 x3 y3 z3
+		const __m128 t0 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2,1,3,2));	// x2 y2 x3 y3
+		const __m128 t1 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1,0,2,1));	// y0 z0 y1 z1
+		x = _mm_shuffle_ps(a, t0, _MM_SHUFFLE(2,0,3,0));
+		y = _mm_shuffle_ps(t1, t0, _MM_SHUFFLE(3,1,2,0));
+		z = _mm_shuffle_ps(t1, c, _MM_SHUFFLE(3,0,3,1));
+	}
+
+	inline void store4(glm::vec3* p, __m128 x, __m128 y, __m128 z)
+	{
+		float* f = &p[0].x;
+		const __m128 xy01 = _mm_unpacklo_ps(x, y);						// x0 y0 x1 y1
+		const __m128 xy23 = _mm_unpackhi_ps(x, y);						// x2 y2 x3 y3
+		const __m128 zx01 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(1,1,0,0));	// z0 z0 x1 x1
+		const __m128 yz11 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(1,1,1,1));	// y1 y1 z1 z1
+		const __m128 zx23 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(3,3,2,2));	// z2 z2 x3 x3
+		const __m128 yz33 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(3,3,3,3));	// y3 y3 z3 z3
+		_mm_storeu_ps(f,   _mm_shuffle_ps(xy01, zx01, _MM_SHUFFLE(2,0,1,0)));
+		_mm_storeu_ps(f+4, _mm_shuffle_ps(yz11, xy23, _MM_SHUFFLE(1,0,2,0)));
+		_mm_storeu_ps(f+8, _mm_shuffle_ps(zx23, yz33, _MM_SHUFFLE(2,0,2,0)));
+	}
+
+	inline float hmin(__m128 v)
+	{
+		v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2,3,0,1)));
+		v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1,0,3,2)));
+		return _mm_cvtss_f32(v);
+	}
+
+	inline float hmax(__m128 v)
+	{
+		v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2,3,0,1)));
+		v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1,0,3,2)));
+		return _mm_cvtss_f32(v);
+	}
+
+	void transform_sse(const glm::mat4& m, const glm::vec3* in, glm::vec3* out, std::size_t n, float w)
+	{
+		__m128 c[3][4];
+		for (int r=0; r<3; ++r)
+		{
+			for (int k=0; k<3; ++k)
+				c[r][k] = _mm_set1_ps(m[k][r]);
+			c[r][3] = _mm_set1_ps(m[3][r]*w);
+		}
+
+		std::size_t i = 0;
+		for (; i+4<=n; i+=4)
+		{
+			__m128 x, y, z;
+			load4(in+i, x, y, z);
+			__m128 res[3];
+			for (int r=0; r<3; ++r)
+				res[r] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c[r][0], x), _mm_mul_ps(c[r][1], y)), _mm_add_ps(_mm_mul_ps(c[r][2], z), c[r][3]));
+			store4(out+i, res[0], res[1], res[2]);
+		}
+		transform_scalar(m, in+i, out+i, n-i, w);
+	}
+
+	void normalize_sse(const glm::vec3* in, glm::vec3* out, std::size_t n)
+	{
+		const __m128 eps = _mm_set1_ps(NORMALIZE_EPSILON);
+		std::size_t i = 0;
+		for (; i+4<=n; i+=4)
+		{
+			__m128 x, y, z;
+			load4(in+i, x, y, z);
+			const __m128 l = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x,x), _mm_mul_ps(y,y)), _mm_mul_ps(z,z)));
+			// longueur nulle: diviseur 1 (vecteur inchange)
+			const __m128 small = _mm_cmplt_ps(l, eps);
+			const __m128 d = _mm_or_ps(_mm_and_ps(small, _mm_set1_ps(1.0f)), _mm_andnot_ps(small, l));
+			store4(out+i, _mm_div_ps(x,d), _mm_div_ps(y,d), _mm_div_ps(z,d));
+		}
+		normalize_scalar(in+i, out+i, n-i);
+	}
+
+	void dot_sse(const glm::vec3* a, const glm::vec3* b, float* out, std::size_t n)
+	{
+		std::size_t i = 0;
+		for (; i+4<=n; i+=4)
+		{
+			__m128 ax, ay, az, bx, by, bz;
+			load4(a+i, ax, ay, az);
+			load4(b+i, bx, by, bz);
+			_mm_storeu_ps(out+i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax,bx), _mm_mul_ps(ay,by)), _mm_mul_ps(az,bz)));
+		}
+		dot_scalar(a+i, b+i, out+i, n-i);
+	}
+
+	void cross_sse(const glm::vec3* a, const glm::vec3* b, glm::vec3* out, std::size_t n)
+	{
+		std::size_t i = 0;
+		for (; i+4<=n; i+=4)
+		{
+			__m128 ax, ay, az, bx, by, bz;
+			load4(a+i, ax, ay, az);
+			load4(b+i, bx, by, bz);
+			store4(out+i,
+				_mm_sub_ps(_mm_mul_ps(ay,bz), _mm_mul_ps(az,by)),
+				_mm_sub_ps(_mm_mul_ps(az,bx), _mm_mul_ps(ax,bz)),
+				_mm_sub_ps(_mm_mul_ps(ax,by), _mm_mul_ps(ay,bx)));
+		}
+		cross_scalar(a+i, b+i, out+i, n-i);
+	}
+
+	void aabb_sse(const glm::vec3* p, std::size_t n, glm::vec3& bmin, glm::vec3& bmax)
+	{
+		__m128 lo[3], hi[3];
+		for (int k=0; k<3; ++k)
+		{
+			lo[k] = _mm_set1_ps(FLT_MAX);
+			hi[k] = _mm_set1_ps(-FLT_MAX);
+		}
+
+		std::size_t i = 0;
+		for (; i+4<=n; i+=4)
+		{
+			__m128 v[3];
+			load4(p+i, v[0], v[1], v[2]);
+			for (int k=0; k<3; ++k)
+			{
+				lo[k] = _mm_min_ps(lo[k], v[k]);
+				hi[k] = _mm_max_ps(hi[k], v[k]);
+			}
+		}
+
+		glm::vec3 tlo, thi;
+		aabb_scalar(p+i, n-i, tlo, thi);
+		for (int k=0; k<3; ++k)
+		{
+			bmin[k] = std::min(hmin(lo[k]), tlo[k]);
+			bmax[k] = std::max(hmax(hi[k]), thi[k]);
+		}
+	}
+
+	const Kernels s_sse = { transform_sse, normalize_sse, dot_sse, cross_sse, aabb_sse };
+
+
+	//
+	// AVX2+FMA: 8 elements, transposition SSE sur chaque moitie
+	//
+
+	BATCHMATH_AVX2 inline void load8(const glm::vec3* p, __m256& x, __m256& y, __m256& z)
+	{
+		__m128 x0, y0, z0, x1, y1, z1;
+		load4(p, x0, y0, z0);
+		load4(p+4, x1, y1, z1);
+		x = _mm256_insertf128_ps(_mm256_castps128_ps256(x0), x1, 1);
+		y = _mm256_insertf128_ps(_mm256_castps128_ps256(y0), y1, 1);
+		z = _mm256_insertf128_ps(_mm256_castps128_ps256(z0), z1, 1);
+	}
+
+	BATCHMATH_AVX2 inline void store8(glm::vec3* p, __m256 x, __m256 y, __m256 z)
+	{
+		store4(p, _mm256_castps256_ps128(x), _mm256_castps256_ps128(y), _mm256_castps256_ps128(z));
+		store4(p+4, _mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1), _mm256_extractf128_ps(z, 1));
+	}
+
+	BATCHMATH_AVX2 void transform_avx2(const glm::mat4& m, const glm::vec3* in, glm::vec3* out, std::size_t n, float w)
+	{
+		__m256 c[3][4];
+		for (int r=0; r<3; ++r)
+		{
+			for (int k=0; k<3; ++k)
+				c[r][k] = _mm256_set1_ps(m[k][r]);
+			c[r][3] = _mm256_set1_ps(m[3][r]*w);
+		}
+
+		std::size_t i = 0;
+		for (; i+8<=n; i+=8)
+		{
+			__m256 x, y, z;
+			load8(in+i, x, y, z);
+			__m256 res[3];
+			for (int r=0; r<3; ++r)
+				res[r] = _mm256_fmadd_ps(c[r][0], x, _mm256_fmadd_ps(c[r][1], y, _mm256_fmadd_ps(c[r][2], z, c[r][3])));
+			store8(out+i, res[0], res[1], res[2]);
+		}
+		transform_sse(m, in+i, out+i, n-i, w);
+	}
+
+	BATCHMATH_AVX2 void normalize_avx2(const glm::vec3* in, glm::vec3* out, std::size_t n)
+	{
+		const __m256 eps = _mm256_set1_ps(NORMALIZE_EPSILON);
+		const __m256 one = _mm256_set1_ps(1.0f);
+		std::size_t i = 0;
+		for (; i+8<=n; i+=8)
+		{
+			__m256 x, y, z;
+			load8(in+i, x, y, z);
+			const __m256 l = _mm256_sqrt_ps(_mm256_fmadd_ps(x, x, _mm256_fmadd_ps(y, y, _mm256_mul_ps(z, z))));
+			const __m256 d = _mm256_blendv_ps(l, one, _mm256_cmp_ps(l, eps, _CMP_LT_OQ));
+			store8(out+i, _mm256_div_ps(x,d), _mm256_div_ps(y,d), _mm256_div_ps(z,d));
+		}
+		normalize_sse(in+i, out+i, n-i);
+	}
+
+	BATCHMATH_AVX2 void dot_avx2(const glm::vec3* a, const glm::vec3* b, float* out, std::size_t n)
+	{
+		std::size_t i = 0;
+		for (; i+8<=n; i+=8)
+		{
+			__m256 ax, ay, az, bx, by, bz;
+			load8(a+i, ax, ay, az);
+			load8(b+i, bx, by, bz);
+			_mm256_storeu_ps(out+i, _mm256_fmadd_ps(ax, bx, _mm256_fmadd_ps(ay, by, _mm256_mul_ps(az, bz))));
+		}
+		dot_sse(a+i, b+i, out+i, n-i);
+	}
+
+	BATCHMATH_AVX2 void cross_avx2(const glm::vec3* a, const glm::vec3* b, glm::vec3* out, std::size_t n)
+	{
+		std::size_t i = 0;
+		for (; i+8<=n; i+=8)
+		{
+			__m256 ax, ay, az, bx, by, bz;
+			load8(a+i, ax, ay, az);
+			load8(b+i, bx, by, bz);
+			store8(out+i,
+				_mm256_fmsub_ps(ay, bz, _mm256_mul_ps(az, by)),
+				_mm256_fmsub_ps(az, bx, _mm256_mul_ps(ax, bz)),
+				_mm256_fmsub_ps(ax, by, _mm256_mul_ps(ay, bx)));
+		}
+		cross_sse(a+i, b+i, out+i, n-i);
+	}
+
+	BATCHMATH_AVX2 void aabb_avx2(const glm::vec3* p, std::size_t n, glm::vec3& bmin, glm::vec3& bmax)
+	{
+		__m256 lo[3], hi[3];
+		for (int k=0; k<3; ++k)
+		{
+			lo[k] = _mm256_set1_ps(FLT_MAX);
+			hi[k] = _mm256_set1_ps(-FLT_MAX);
+		}
+
+		std::size_t i = 0;
+		for (; i+8<=n; i+=8)
+		{
+			__m256 v[3];
+			load8(p+i, v[0], v[1], v[2]);
+			for (int k=0; k<3; ++k)
+			{
+				lo[k] = _mm256_min_ps(lo[k], v[k]);
+				hi[k] = _mm256_max_ps(hi[k], v[k]);
+			}
+		}
+
+		glm::vec3 tlo, thi;
+		aabb_sse(p+i, n-i, tlo, thi);
+		for (int k=0; k<3; ++k)
+		{
+			bmin[k] = std::min(hmin(_mm_min_ps(_mm256_castps256_ps128(lo[k]), _mm256_extractf128_ps(lo[k], 1))), tlo[k]);
+			bmax[k] = std::max(hmax(_mm_max_ps(_mm256_castps256_ps128(hi[k]), _mm256_extractf128_ps(hi[k], 1))), thi[k]);
+		}
+	}
+
+	const Kernels s_avx2 = { transform_avx2, normalize_avx2, dot_avx2, cross_avx2, aabb_avx2 };
+
+
+	/// AVX2 et FMA presents, et registres ymm sauves par l'OS
+	bool cpu_has_avx2()
+	{
+#ifdef _MSC_VER
+		int r[4];
+		__cpuid(r, 0);
+		if (r[0] < 7)
+			return false;
+		__cpuid(r, 1);
+		const bool fma = (r[2] & (1<<12)) != 0;
+		const bool osxsave = (r[2] & (1<<27)) != 0;
+		if (!fma || !osxsave || (_xgetbv(0) & 6) != 6)
+			return false;
+		__cpuidex(r, 7, 0);
+		return (r[1] & (1<<5)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+	}
+
+#endif // BATCHMATH_X86
+
+
+	BatchMath::Isa s_isa = BatchMath::SCALAR;
+	bool s_isa_init = false;
+
+	const Kernels& kernels()
+	{
+		if (!s_isa_init)
+		{
+			s_isa = BatchMath::best_isa();
+			s_isa_init = true;
+		}
+#ifdef BATCHMATH_X86
+		if (s_isa == BatchMath::AVX2)
+			return s_avx2;
+		if (s_isa == BatchMath::SSE)
+			return s_sse;
+#endif
+		return s_scalar;
+	}
+}
+
+
+BatchMath::Isa BatchMath::best_isa()
+{
+#ifdef BATCHMATH_X86
+	static const Isa best = cpu_has_avx2() ? AVX2 : SSE;
+	return best;
+#else
+	return SCALAR;
+#endif
+}
+
+
+BatchMath::Isa BatchMath::isa()
+{
+	kernels();
+	return s_isa;
+}
+
+
+void BatchMath::set_isa(Isa i)
+{
+	s_isa = std::min(i, best_isa());
+	s_isa_init = true;
+}
+
+
+const char* BatchMath::isa_name(Isa i)
+{
+	switch(i)
+	{
+		case AVX2:
+			return "avx2";
+		case SSE:
+			return "sse";
+		default:
+			return "scalar";
+	}
+}
+
+
+void BatchMath::transform_points(const glm::mat4& m, const glm::vec3* in, glm::vec3* out, std::size_t n)
+{
+	kernels().transform(m, in, out, n, 1.0f);
+}
+
+
+void BatchMath::transform_vectors(const glm::mat4& m, const glm::vec3* in, glm::vec3* out, std::size_t n)
+{
+	kernels().transform(m, in, out, n, 0.0f);
+}
+
+
+void BatchMath::normalize(const glm::vec3* in, glm::vec3* out, std::size_t n)
+{
+	kernels().normalize(in, out, n);
+}
+
+
+void BatchMath::dot(const glm::vec3* a, const glm::vec3* b, float* out, std::size_t n)
+{
+	kernels().dot(a, b, out, n);
+}
+
+
+void BatchMath::cross(const glm::vec3* a, const glm::vec3* b, glm::vec3* out, std::size_t n)
+{
+	kernels().cross(a, b, out, n);
+}
+
+
+void BatchMath::aabb(const glm::vec3* p, std::size_t n, glm::vec3& bmin, glm::vec3& bmax)
+{
+	kernels().aabb(p, n, bmin, bmax);
+}
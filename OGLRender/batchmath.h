@@ -0,0 +1,70 @@
+#ifndef BATCHMATH_H
+#define BATCHMATH_H
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+#include "shader.h"
+
+/**
+ * @brief Calculs sur des tableaux de points/vecteurs (glm::vec3 compacts)
+ *
+ * Chaque operation traite n elements d'un coup. Version choisie a
+ * l'execution selon le processeur: AVX2+FMA (8 elements), SSE (4),
+ * sinon scalaire. Les tableaux d'entree et de sortie peuvent etre les
+ * memes (calcul en place), pas se recouvrir partiellement.
+ */
+class OGLRENDER_API BatchMath
+{
+public:
+	/// jeu d'instructions utilise
+	enum Isa { SCALAR = 0, SSE, AVX2 };
+
+	/// jeu d'instructions courant (le meilleur disponible par defaut)
+	static Isa isa();
+
+	/// meilleur jeu d'instructions du processeur
+	static Isa best_isa();
+
+	/**
+	 * @brief force un jeu d'instructions (comparaisons, tests)
+	 * @param i jeu demande, ramene au meilleur disponible
+	 */
+	static void set_isa(Isa i);
+
+	/// "scalar", "sse", "avx2"
+	static const char* isa_name(Isa i);
+
+	/**
+	 * @brief out[i] = (m * vec4(in[i],1)).xyz
+	 * @param m matrice (affine)
+	 * @param in points
+	 * @param out resultats
+	 * @param n nombre de points
+	 */
+	static void transform_points(const glm::mat4& m, const glm::vec3* in, glm::vec3* out, std::size_t n);
+
+	/// out[i] = (m * vec4(in[i],0)).xyz
+	static void transform_vectors(const glm::mat4& m, const glm::vec3* in, glm::vec3* out, std::size_t n);
+
+	/// out[i] = in[i]/|in[i]| (in[i] inchange si |in[i]| < 1e-6, comme vec_normalize)
+	static void normalize(const glm::vec3* in, glm::vec3* out, std::size_t n);
+
+	/// out[i] = dot(a[i], b[i])
+	static void dot(const glm::vec3* a, const glm::vec3* b, float* out, std::size_t n);
+
+	/// out[i] = cross(a[i], b[i])
+	static void cross(const glm::vec3* a, const glm::vec3* b, glm::vec3* out, std::size_t n);
+
+	/**
+	 * @brief boite englobante
+	 * @param p points
+	 * @param n nombre de points (0: bmin=+FLT_MAX, bmax=-FLT_MAX)
+	 * @param bmin coin min
+	 * @param bmax coin max
+	 */
+	static void aabb(const glm::vec3* p, std::size_t n, glm::vec3& bmin, glm::vec3& bmax);
+};
+
+#endif // BATCHMATH_H
@@ -0,0 +1,97 @@
+#include "camerauniforms.h"
+
+#include <map>
+#include <cstring>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <QOpenGLContext>
+
+#include "glstate.h"
+
+
+namespace
+{
+	struct Block
+	{
+		GLuint ubo;
+		int references;
+		/// contenu du buffer: view, projection, view*projection
+		glm::mat4 data[3];
+		bool valid;
+	};
+
+	std::map<const void*, Block>& blocks()
+	{
+		static std::map<const void*, Block> b;
+		return b;
+	}
+
+	/// un buffer n'est valide que dans les contextes qui partagent leurs objets
+	const void* share_group()
+	{
+		QOpenGLContext* ctx = QOpenGLContext::currentContext();
+		return ctx != NULL ? static_cast<const void*>(ctx->shareGroup()) : NULL;
+	}
+}
+
+
+void CameraUniforms::acquire()
+{
+	auto it = blocks().find(share_group());
+	if (it != blocks().end())
+	{
+		++it->second.references;
+		return;
+	}
+
+	Block b;
+	b.references = 1;
+	b.valid = false;
+	glGenBuffers(1, &b.ubo);
+	GLState::bindBuffer(GL_UNIFORM_BUFFER, b.ubo);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(b.data), NULL, GL_DYNAMIC_DRAW);
+	blocks()[share_group()] = b;
+}
+
+
+void CameraUniforms::release()
+{
+	auto it = blocks().find(share_group());
+	if (it == blocks().end() || --it->second.references > 0)
+		return;
+
+	GLState::forgetBuffer(it->second.ubo);
+	glDeleteBuffers(1, &it->second.ubo);
+	blocks().erase(it);
+}
+
+
+void CameraUniforms::bind(const glm::mat4& view, const glm::mat4& projection)
+{
+	auto it = blocks().find(share_group());
+	if (it == blocks().end())
+		return;
+	Block& b = it->second;
+
+	if (!b.valid || std::memcmp(&b.data[0], &view, sizeof(glm::mat4)) != 0
+		|| std::memcmp(&b.data[1], &projection, sizeof(glm::mat4)) != 0)
+	{
+		b.data[0] = view;
+		b.data[1] = projection;
+		b.data[2] = projection*view;
+		b.valid = true;
+		GLState::bindBuffer(GL_UNIFORM_BUFFER, b.ubo);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(b.data), glm::value_ptr(b.data[0]));
+	}
+
+	GLState::bindBufferBase(GL_UNIFORM_BUFFER, BINDING, b.ubo);
+}
+
+
+void CameraUniforms::attach(GLuint program)
+{
+	const GLuint index = glGetUniformBlockIndex(program, "Camera");
+	if (index != GL_INVALID_INDEX)
+		glUniformBlockBinding(program, index, BINDING);
+}
@@ -0,0 +1,46 @@
+#ifndef CAMERAUNIFORMS_H
+#define CAMERAUNIFORMS_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "shader.h"
+
+/**
+ * @brief Uniform buffer des matrices de camera (bloc "Camera" des shaders)
+ *
+ * Un buffer par groupe de contextes partages, lie sur le point BINDING:
+ * view, projection et view*projection ne sont envoyes qu'a leur changement
+ * (une fois par frame) et partages par tous les programmes.
+ * Les programmes le creent/rendent (ShaderProgram: acquire/release).
+ *
+ * Bloc GLSL (layout std140):
+ *   uniform Camera { mat4 viewMatrix; mat4 projectionMatrix; mat4 viewProjMatrix; };
+ */
+class OGLRENDER_API CameraUniforms
+{
+public:
+	/// point de liaison du bloc Camera
+	static const GLuint BINDING = 0;
+
+	/// reference +1 sur le buffer du groupe de contextes courant (cree au 1er appel)
+	static void acquire();
+
+	/// reference -1, detruit au dernier appel: le contexte GL doit etre courant
+	static void release();
+
+	/**
+	 * @brief met a jour (si besoin) et lie le buffer du contexte courant
+	 * @param view matrice de vue
+	 * @param projection matrice de projection
+	 */
+	static void bind(const glm::mat4& view, const glm::mat4& projection);
+
+	/**
+	 * @brief associe le bloc Camera d'un programme lie au point BINDING
+	 * @param program programme (sans effet s'il n'utilise pas le bloc)
+	 */
+	static void attach(GLuint program);
+};
+
+#endif // CAMERAUNIFORMS_H
@@ -0,0 +1,10 @@
+#version 140
+
+out vec3 color_final;
+
+uniform vec3 color = vec3(1.0,0.0,0.0);
+
+void main()
+{
+	color_final = color;
+}
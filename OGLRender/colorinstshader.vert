@@ -0,0 +1,17 @@
+#version 140
+
+in vec3 vertex_in;
+in mat4 transfo_in;
+
+layout(std140) uniform Camera
+{
+	mat4 viewMatrix;
+	mat4 projectionMatrix;
+	mat4 viewProjMatrix;
+};
+
+
+void main()
+{
+	gl_Position = viewProjMatrix * transfo_in * vec4(vertex_in, 1.0);
+}
@@ -1,4 +1,4 @@
-#version 130
+#version 140
 
 out vec3 color_final;
 
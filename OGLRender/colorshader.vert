@@ -1,12 +1,18 @@
-#version 130
+#version 140
 
 in vec3 vertex_in;
 
-uniform mat4 projectionMatrix;
-uniform mat4 viewMatrix;
+layout(std140) uniform Camera
+{
+	mat4 viewMatrix;
+	mat4 projectionMatrix;
+	mat4 viewProjMatrix;
+};
+
+uniform mat4 modelMatrix = mat4(1.0);
 
 
 void main()
 {
-	gl_Position = projectionMatrix * viewMatrix * vec4(vertex_in, 1.0);
+	gl_Position = viewProjMatrix * modelMatrix * vec4(vertex_in, 1.0);
 }
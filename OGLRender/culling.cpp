@@ -0,0 +1,312 @@
+#include "culling.h"
+
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define CULLING_SSE 1
+#endif
+
+
+Frustum::Frustum()
+{
+	// pas de plan: tout est visible
+	for (int i=0; i<6; ++i)
+		m_planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, -1.0f);
+}
+
+
+void Frustum::set_planes(const double coef[6][4])
+{
+	for (int i=0; i<6; ++i)
+		m_planes[i] = glm::vec4(float(coef[i][0]), float(coef[i][1]), float(coef[i][2]), float(coef[i][3]));
+}
+
+
+void Frustum::set_matrix(const glm::mat4& viewProj)
+{
+	// Gribb & Hartmann: lignes de la matrice (normales vers l'interieur)
+	glm::vec4 row[4];
+	for (int i=0; i<4; ++i)
+		row[i] = glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]);
+
+	// meme ordre que QGLViewer: gauche, droite, near, far, haut, bas
+	glm::vec4 in[6] = { row[3]+row[0], row[3]-row[0], row[3]+row[2], row[3]-row[2], row[3]-row[1], row[3]+row[1] };
+
+	for (int i=0; i<6; ++i)
+	{
+		float l = glm::length(glm::vec3(in[i]));
+		if (l > 0.0f)
+			in[i] /= l;
+		// normales vers l'exterieur
+		m_planes[i] = -in[i];
+	}
+}
+
+
+bool Frustum::visible(const glm::vec3& center, float radius) const
+{
+	for (int i=0; i<6; ++i)
+	{
+		const glm::vec4& p = m_planes[i];
+		if (p.x*center.x + p.y*center.y + p.z*center.z + p.w > radius)
+			return false;
+	}
+	return true;
+}
+
+
+std::size_t Frustum::cull_spheres(const glm::vec4* spheres, std::size_t n, unsigned char* visible) const
+{
+	std::size_t nb_visible = 0;
+	std::size_t i = 0;
+
+#ifdef CULLING_SSE
+	__m128 pa[6], pb[6], pc[6], pd[6];
+	for (int k=0; k<6; ++k)
+	{
+		pa[k] = _mm_set1_ps(m_planes[k].x);
+		pb[k] = _mm_set1_ps(m_planes[k].y);
+		pc[k] = _mm_set1_ps(m_planes[k].z);
+		pd[k] = _mm_set1_ps(m_planes[k].w);
+	}
+
+	// 4 spheres a la fois: transposition xyzr -> xxxx yyyy zzzz rrrr
+	for (; i+4 <= n; i+=4)
+	{
+		__m128 x = _mm_loadu_ps(&spheres[i][0]);
+		__m128 y = _mm_loadu_ps(&spheres[i+1][0]);
+		__m128 z = _mm_loadu_ps(&spheres[i+2][0]);
+		__m128 r = _mm_loadu_ps(&spheres[i+3][0]);
+		_MM_TRANSPOSE4_PS(x, y, z, r);
+
+		__m128 out = _mm_setzero_ps();
+		for (int k=0; k<6; ++k)
+		{
+			__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(pa[k], x), _mm_mul_ps(pb[k], y)), _mm_add_ps(_mm_mul_ps(pc[k], z), pd[k]));
+			out = _mm_or_ps(out, _mm_cmpgt_ps(d, r));
+		}
+
+		int mask = _mm_movemask_ps(out);
+		for (int j=0; j<4; ++j)
+		{
+			visible[i+j] = ((mask >> j) & 1) ? 0 : 1;
+			nb_visible += visible[i+j];
+		}
+	}
+#endif
+
+	for (; i<n; ++i)
+	{
+		visible[i] = this->visible(glm::vec3(spheres[i]), spheres[i].w) ? 1 : 0;
+		nb_visible += visible[i];
+	}
+
+	return nb_visible;
+}
+
+
+
+OcclusionBuffer::OcclusionBuffer(int width, int height):
+	m_width(width),
+	m_height(height)
+{
+	int w = width;
+	int h = height;
+	for (;;)
+	{
+		m_level_w.push_back(w);
+		m_level_h.push_back(h);
+		m_levels.push_back(std::vector<float>(std::size_t(w)*h, 1.0f));
+		if (w == 1 && h == 1)
+			break;
+		w = std::max(1, (w+1)/2);
+		h = std::max(1, (h+1)/2);
+	}
+}
+
+
+void OcclusionBuffer::begin(const glm::mat4& viewProj)
+{
+	m_viewProj = viewProj;
+	std::fill(m_levels[0].begin(), m_levels[0].end(), 1.0f);
+}
+
+
+void OcclusionBuffer::add_occluder(const glm::vec3* points, const int* indices, std::size_t nb_indices, const glm::mat4& model)
+{
+	glm::mat4 mvp = m_viewProj * model;
+
+	for (std::size_t i=0; i+2<nb_indices; i+=3)
+	{
+		glm::vec3 s[3];
+		bool clipped = false;
+		for (int j=0; j<3; ++j)
+		{
+			glm::vec4 P = mvp * glm::vec4(points[indices[i+j]], 1.0f);
+			// un occulteur doit etre entierement devant la camera
+			if (P.w <= 1e-5f)
+			{
+				clipped = true;
+				break;
+			}
+			glm::vec3 ndc = glm::vec3(P) / P.w;
+			s[j] = glm::vec3((ndc.x*0.5f+0.5f)*m_width, (ndc.y*0.5f+0.5f)*m_height, ndc.z*0.5f+0.5f);
+		}
+		if (!clipped)
+			raster_triangle(s[0], s[1], s[2]);
+	}
+}
+
+
+void OcclusionBuffer::raster_triangle(const glm::vec3& a, const glm::vec3& b0, const glm::vec3& c0)
+{
+	glm::vec3 b = b0;
+	glm::vec3 c = c0;
+	float area = (b.x-a.x)*(c.y-a.y) - (b.y-a.y)*(c.x-a.x);
+	if (std::abs(area) < 1e-8f)
+		return;
+	if (area < 0.0f)
+	{
+		std::swap(b, c);
+		area = -area;
+	}
+
+	int x0 = std::max(0, int(std::floor(std::min(a.x, std::min(b.x, c.x)))));
+	int x1 = std::min(m_width-1, int(std::ceil(std::max(a.x, std::max(b.x, c.x)))));
+	int y0 = std::max(0, int(std::floor(std::min(a.y, std::min(b.y, c.y)))));
+	int y1 = std::min(m_height-1, int(std::ceil(std::max(a.y, std::max(b.y, c.y)))));
+	if (x0 > x1 || y0 > y1)
+		return;
+
+	// fonctions d'aretes E(x,y) = ex*x + ey*y + e0, positives a l'interieur
+	const glm::vec3* v[3] = { &a, &b, &c };
+	float ex[3], ey[3], e0[3];
+	for (int k=0; k<3; ++k)
+	{
+		const glm::vec3& p = *v[k];
+		const glm::vec3& q = *v[(k+1)%3];
+		ex[k] = -(q.y - p.y);
+		ey[k] = q.x - p.x;
+		e0[k] = -(ex[k]*p.x + ey[k]*p.y);
+		// teste le coin du texel le plus a l'exterieur de l'arete
+		e0[k] -= 0.5f*(std::abs(ex[k]) + std::abs(ey[k]));
+	}
+
+	// seuls les texels entierement couverts sont ecrits: un texel au bord de
+	// l'occulteur reste visible (le culling doit garder les objets en cas de
+	// doute, quitte a laisser des trous le long des aretes internes),
+	// plan de profondeur majore sur tout le pixel
+	float dzdx = ((b.z-a.z)*(c.y-a.y) - (c.z-a.z)*(b.y-a.y)) / area;
+	float dzdy = ((c.z-a.z)*(b.x-a.x) - (b.z-a.z)*(c.x-a.x)) / area;
+	float zmargin = 0.5f*(std::abs(dzdx) + std::abs(dzdy));
+
+	std::vector<float>& depth = m_levels[0];
+	for (int y=y0; y<=y1; ++y)
+	{
+		float py = y + 0.5f;
+		for (int x=x0; x<=x1; ++x)
+		{
+			float px = x + 0.5f;
+			bool inside = true;
+			for (int k=0; k<3 && inside; ++k)
+				inside = (ex[k]*px + ey[k]*py + e0[k] >= 0.0f);
+			if (!inside)
+				continue;
+
+			float z = a.z + dzdx*(px-a.x) + dzdy*(py-a.y) + zmargin;
+			float& d = depth[std::size_t(y)*m_width + x];
+			if (z < d)
+				d = std::max(z, 0.0f);
+		}
+	}
+}
+
+
+void OcclusionBuffer::build_hiz()
+{
+	for (std::size_t l=1; l<m_levels.size(); ++l)
+	{
+		const std::vector<float>& src = m_levels[l-1];
+		std::vector<float>& dst = m_levels[l];
+		int sw = m_level_w[l-1];
+		int sh = m_level_h[l-1];
+		int dw = m_level_w[l];
+		int dh = m_level_h[l];
+
+		for (int y=0; y<dh; ++y)
+		{
+			int sy0 = std::min(2*y, sh-1);
+			int sy1 = std::min(2*y+1, sh-1);
+			for (int x=0; x<dw; ++x)
+			{
+				int sx0 = std::min(2*x, sw-1);
+				int sx1 = std::min(2*x+1, sw-1);
+				float m = std::max(std::max(src[sy0*sw+sx0], src[sy0*sw+sx1]),
+								   std::max(src[sy1*sw+sx0], src[sy1*sw+sx1]));
+				dst[y*dw+x] = m;
+			}
+		}
+	}
+}
+
+
+bool OcclusionBuffer::visible(const glm::vec3& center, float radius) const
+{
+	// rectangle ecran et profondeur minimale de la boite englobante
+	float xmin = 1e30f, ymin = 1e30f, xmax = -1e30f, ymax = -1e30f;
+	float zmin = 1.0f;
+	for (int i=0; i<8; ++i)
+	{
+		glm::vec3 corner = center + radius*glm::vec3((i&1)?1.0f:-1.0f, (i&2)?1.0f:-1.0f, (i&4)?1.0f:-1.0f);
+		glm::vec4 P = m_viewProj * glm::vec4(corner, 1.0f);
+		// traverse le plan de la camera: on ne peut pas conclure
+		if (P.w <= 1e-5f)
+			return true;
+		glm::vec3 ndc = glm::vec3(P) / P.w;
+		float sx = (ndc.x*0.5f+0.5f)*m_width;
+		float sy = (ndc.y*0.5f+0.5f)*m_height;
+		xmin = std::min(xmin, sx);
+		xmax = std::max(xmax, sx);
+		ymin = std::min(ymin, sy);
+		ymax = std::max(ymax, sy);
+		zmin = std::min(zmin, ndc.z*0.5f+0.5f);
+	}
+
+	if (zmin <= 0.0f)
+		return true;
+
+	xmin = std::max(xmin, 0.0f);
+	ymin = std::max(ymin, 0.0f);
+	xmax = std::min(xmax, float(m_width) - 1e-3f);
+	ymax = std::min(ymax, float(m_height) - 1e-3f);
+	// hors ecran: laisse au test de la pyramide de vision
+	if (xmin > xmax || ymin > ymax)
+		return true;
+
+	// niveau ou le rectangle couvre au plus 2x2 texels
+	float extent = std::max(xmax-xmin, ymax-ymin);
+	int level = 0;
+	while (extent > 2.0f && level+1 < int(m_levels.size()))
+	{
+		extent *= 0.5f;
+		++level;
+	}
+
+	const std::vector<float>& depth = m_levels[level];
+	int w = m_level_w[level];
+	int h = m_level_h[level];
+	float scale = 1.0f / float(1 << level);
+	int tx0 = std::min(w-1, int(xmin*scale));
+	int tx1 = std::min(w-1, int(xmax*scale));
+	int ty0 = std::min(h-1, int(ymin*scale));
+	int ty1 = std::min(h-1, int(ymax*scale));
+
+	for (int y=ty0; y<=ty1; ++y)
+		for (int x=tx0; x<=tx1; ++x)
+			if (zmin < depth[y*w+x])
+				return true;
+
+	return false;
+}
@@ -0,0 +1,111 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+#include <vector>
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+#include "shader.h"
+
+/**
+ * @brief Pyramide de vision (6 plans) et test de spheres englobantes
+ *
+ * Plans au format de qglviewer::Camera::getFrustumPlanesCoefficients():
+ * a*x + b*y + c*z + d = 0, normales vers l'exterieur.
+ */
+class OGLRENDER_API Frustum
+{
+public:
+	Frustum();
+
+	/**
+	 * @brief plans donnes par camera()->getFrustumPlanesCoefficients(coef)
+	 * @param coef 6 plans (gauche, droite, near, far, haut, bas)
+	 */
+	void set_planes(const double coef[6][4]);
+
+	/**
+	 * @brief plans extraits d'une matrice projection*modelview
+	 * @param viewProj matrice projection*modelview
+	 */
+	void set_matrix(const glm::mat4& viewProj);
+
+	/**
+	 * @brief test d'une sphere
+	 * @param center centre (repere monde)
+	 * @param radius rayon
+	 * @return la sphere intersecte la pyramide
+	 */
+	bool visible(const glm::vec3& center, float radius) const;
+
+	/**
+	 * @brief test d'un tableau de spheres (SSE si disponible)
+	 * @param spheres centres (xyz) et rayons (w)
+	 * @param n nombre de spheres
+	 * @param visible resultat par sphere (1 visible, 0 hors champ) [out]
+	 * @return nombre de spheres visibles
+	 */
+	std::size_t cull_spheres(const glm::vec4* spheres, std::size_t n, unsigned char* visible) const;
+
+protected:
+	/// plans (a,b,c,d)
+	glm::vec4 m_planes[6];
+};
+
+
+/**
+ * @brief Tampon de profondeur basse resolution pour l'occlusion (CPU)
+ *
+ * Les occulteurs sont rasterises (centre des pixels, profondeur majoree sur
+ * le pixel) puis une pyramide hierarchique (Hi-Z) de profondeurs maximales
+ * permet de tester une sphere en quelques lectures.
+ */
+class OGLRENDER_API OcclusionBuffer
+{
+public:
+	OcclusionBuffer(int width=256, int height=128);
+
+	/**
+	 * @brief debut de frame: vide le tampon
+	 * @param viewProj matrice projection*modelview
+	 */
+	void begin(const glm::mat4& viewProj);
+
+	/**
+	 * @brief rasterise des triangles occulteurs
+	 * @param points sommets
+	 * @param indices indices de triangles (3 par triangle)
+	 * @param nb_indices nombre d'indices
+	 * @param model matrice de transformation des sommets
+	 */
+	void add_occluder(const glm::vec3* points, const int* indices, std::size_t nb_indices, const glm::mat4& model = glm::mat4());
+
+	/// construit la pyramide Hi-Z (apres les add_occluder)
+	void build_hiz();
+
+	/**
+	 * @brief test d'une sphere contre les occulteurs
+	 * @param center centre (repere monde)
+	 * @param radius rayon
+	 * @return la sphere n'est pas entierement cachee
+	 */
+	bool visible(const glm::vec3& center, float radius) const;
+
+	inline int width() const	{ return m_width; }
+	inline int height() const	{ return m_height; }
+
+protected:
+	void raster_triangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
+
+	int m_width;
+	int m_height;
+	glm::mat4 m_viewProj;
+
+	/// niveaux de la pyramide (0: pleine resolution), profondeurs [0,1]
+	std::vector< std::vector<float> > m_levels;
+	std::vector<int> m_level_w;
+	std::vector<int> m_level_h;
+};
+
+#endif // CULLING_H
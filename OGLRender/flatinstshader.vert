@@ -0,0 +1,23 @@
+#version 140
+
+in vec3 vertex_in;
+in mat4 transfo_in;
+in vec3 color_in;
+
+layout(std140) uniform Camera
+{
+	mat4 viewMatrix;
+	mat4 projectionMatrix;
+	mat4 viewProjMatrix;
+};
+
+out vec3 P;
+flat out vec3 C;
+
+void main()
+{
+	vec4 P4 = viewMatrix * transfo_in * vec4(vertex_in, 1.0);
+	P = P4.xyz;
+	C = color_in;
+	gl_Position = projectionMatrix * P4;
+}
@@ -1,15 +1,21 @@
-#version 130
+#version 140
 
 in vec3 vertex_in;
 
-uniform mat4 projectionMatrix;
-uniform mat4 viewMatrix;
+layout(std140) uniform Camera
+{
+	mat4 viewMatrix;
+	mat4 projectionMatrix;
+	mat4 viewProjMatrix;
+};
+
+uniform mat4 modelMatrix = mat4(1.0);
 
 out vec3 P;
 
 void main()
 {
-	vec4 P4 = viewMatrix * vec4(vertex_in, 1.0);
+	vec4 P4 = viewMatrix * modelMatrix * vec4(vertex_in, 1.0);
 	P = P4.xyz;
 	gl_Position = projectionMatrix * P4;
 }
@@ -0,0 +1,149 @@
+#include "framestats.h"
+#include "glstate.h"
+
+#include <algorithm>
+#include <sstream>
+#include <numeric>
+
+
+namespace
+{
+	/// percentile par interpolation lineaire entre rangs
+	double percentile(std::vector<double> v, double p)
+	{
+		if (v.empty())
+			return 0.0;
+		std::sort(v.begin(), v.end());
+		const double r = p/100.0 * (v.size()-1);
+		const std::size_t i = std::size_t(r);
+		if (i+1 >= v.size())
+			return v.back();
+		return v[i] + (v[i+1]-v[i])*(r-i);
+	}
+
+	template <typename T>
+	double mean(const std::vector<T>& v)
+	{
+		if (v.empty())
+			return 0.0;
+		return std::accumulate(v.begin(), v.end(), 0.0) / v.size();
+	}
+
+	/// {"mean":..,"min":..,"max":..,"p50":..,"p95":..,"p99":..}
+	void write_distribution(std::ostream& out, const std::vector<double>& v)
+	{
+		out << "{\"mean\": " << mean(v);
+		out << ", \"min\": " << (v.empty() ? 0.0 : *std::min_element(v.begin(), v.end()));
+		out << ", \"max\": " << (v.empty() ? 0.0 : *std::max_element(v.begin(), v.end()));
+		out << ", \"p50\": " << percentile(v, 50.0);
+		out << ", \"p95\": " << percentile(v, 95.0);
+		out << ", \"p99\": " << percentile(v, 99.0) << "}";
+	}
+}
+
+
+FrameStats::FrameStats():
+	m_running(false),
+	m_warmup_left(0),
+	m_frames_left(0),
+	m_has_last(false)
+{
+}
+
+
+void FrameStats::start(int warmup, int frames)
+{
+	m_running = frames > 0;
+	m_warmup_left = std::max(0, warmup);
+	m_frames_left = frames;
+	m_has_last = false;
+
+	m_cpu_ms.clear();
+	m_interval_ms.clear();
+	m_draw_calls.clear();
+	m_state_changes.clear();
+	m_state_skipped.clear();
+	m_culled.clear();
+
+	m_cpu_ms.reserve(frames);
+	m_interval_ms.reserve(frames);
+}
+
+
+void FrameStats::set_info(const std::string& key, const std::string& value)
+{
+	for (auto& kv : m_info)
+	{
+		if (kv.first == key)
+		{
+			kv.second = value;
+			return;
+		}
+	}
+	m_info.push_back(std::make_pair(key, value));
+}
+
+
+void FrameStats::begin_frame()
+{
+	if (!m_running)
+		return;
+
+	m_begin = Clock::now();
+	GLState::resetStats();
+}
+
+
+void FrameStats::end_frame()
+{
+	if (!m_running)
+		return;
+
+	const Clock::time_point end = Clock::now();
+
+	if (m_warmup_left > 0)
+		--m_warmup_left;
+	else
+	{
+		const GLState::Stats& st = GLState::stats();
+		m_cpu_ms.push_back(std::chrono::duration<double, std::milli>(end - m_begin).count());
+		if (m_has_last)
+			m_interval_ms.push_back(std::chrono::duration<double, std::milli>(m_begin - m_last_begin).count());
+		m_draw_calls.push_back(st.drawCalls);
+		m_state_changes.push_back(st.stateChanges());
+		m_state_skipped.push_back(st.stateSkipped());
+		m_culled.push_back(st.frustumCulled + st.occlusionCulled);
+
+		if (--m_frames_left <= 0)
+			m_running = false;
+	}
+
+	m_last_begin = m_begin;
+	m_has_last = true;
+}
+
+
+double FrameStats::cpu_percentile(double p) const
+{
+	return percentile(m_cpu_ms, p);
+}
+
+
+std::string FrameStats::to_json() const
+{
+	std::ostringstream out;
+	out << "{";
+	for (const auto& kv : m_info)
+		out << "\"" << kv.first << "\": " << kv.second << ", ";
+	out << "\"frames\": " << m_cpu_ms.size();
+	out << ", \"cpu_frame_ms\": ";
+	write_distribution(out, m_cpu_ms);
+	out << ", \"frame_interval_ms\": ";
+	write_distribution(out, m_interval_ms);
+	out << ", \"draw_calls_per_frame\": " << mean(m_draw_calls);
+	out << ", \"state_changes_per_frame\": " << mean(m_state_changes);
+	out << ", \"state_changes_skipped_per_frame\": " << mean(m_state_skipped);
+	out << ", \"culled_per_frame\": " << mean(m_culled);
+	out << "}";
+	return out.str();
+}
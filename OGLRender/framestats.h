@@ -0,0 +1,84 @@
+#ifndef FRAMESTATS_H
+#define FRAMESTATS_H
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <utility>
+
+#include "shader.h"
+
+/**
+ * @brief Mesure de temps de frame (CPU) et compteurs GLState
+ *
+ * start(w, n) ignore w frames de chauffe puis enregistre n frames:
+ * duree CPU entre begin_frame() et end_frame(), intervalle entre deux
+ * frames, draw calls et changements d'etat (GLState::Stats, remis a 0
+ * a chaque begin_frame()). Le resultat est exporte en JSON.
+ */
+class OGLRENDER_API FrameStats
+{
+public:
+	FrameStats();
+
+	/**
+	 * @brief lance une mesure
+	 * @param warmup nombre de frames ignorees
+	 * @param frames nombre de frames mesurees
+	 */
+	void start(int warmup, int frames);
+
+	/// a appeler en debut de draw()
+	void begin_frame();
+
+	/// a appeler en fin de draw()
+	void end_frame();
+
+	/// mesure en cours (chauffe comprise)
+	inline bool running() const		{ return m_running; }
+
+	/// mesure terminee depuis le dernier start()
+	inline bool finished() const	{ return !m_running && !m_cpu_ms.empty(); }
+
+	/// frames de chauffe restantes
+	inline int warmup_left() const	{ return m_warmup_left; }
+
+	/// nombre de frames mesurees
+	inline int nb_frames() const	{ return int(m_cpu_ms.size()); }
+
+	/**
+	 * @brief ajoute une information exportee dans le JSON
+	 * @param key nom du champ
+	 * @param value valeur (deja au format JSON: nombre, "chaine", ...)
+	 */
+	void set_info(const std::string& key, const std::string& value);
+
+	/// percentile p (0..100) des temps CPU (ms)
+	double cpu_percentile(double p) const;
+
+	/// resultats au format JSON
+	std::string to_json() const;
+
+protected:
+	typedef std::chrono::steady_clock Clock;
+
+	bool m_running;
+	int m_warmup_left;
+	int m_frames_left;
+
+	Clock::time_point m_begin;
+	Clock::time_point m_last_begin;
+	bool m_has_last;
+
+	/// echantillons par frame mesuree
+	std::vector<double> m_cpu_ms;
+	std::vector<double> m_interval_ms;
+	std::vector<unsigned long> m_draw_calls;
+	std::vector<unsigned long> m_state_changes;
+	std::vector<unsigned long> m_state_skipped;
+	std::vector<unsigned long> m_culled;
+
+	std::vector< std::pair<std::string,std::string> > m_info;
+};
+
+#endif // FRAMESTATS_H
@@ -0,0 +1,291 @@
+#include "glstate.h"
+
+#include <cstring>
+#include <unordered_map>
+#include <cstdint>
+
+GLuint GLState::s_program = GLState::UNKNOWN;
+GLuint GLState::s_vao = GLState::UNKNOWN;
+GLuint GLState::s_array_buffer = GLState::UNKNOWN;
+GLuint GLState::s_element_buffer = GLState::UNKNOWN;
+GLuint GLState::s_uniform_buffer = GLState::UNKNOWN;
+GLuint GLState::s_draw_indirect_buffer = GLState::UNKNOWN;
+GLuint GLState::s_uniform_bindings[GLState::NB_UNIFORM_BINDINGS] = { GLState::UNKNOWN, GLState::UNKNOWN, GLState::UNKNOWN, GLState::UNKNOWN };
+
+GLState::Stats GLState::s_stats;
+unsigned long GLState::s_frame = 0;
+
+namespace
+{
+	/// valeurs des uniforms envoyees, par (programme,location)
+	struct UniformValue
+	{
+		GLfloat v[16];
+	};
+
+	std::unordered_map<uint64_t, UniformValue>& uniformCache()
+	{
+		static std::unordered_map<uint64_t, UniformValue> cache;
+		return cache;
+	}
+
+	inline uint64_t uniformKey(GLuint program, GLint location)
+	{
+		return (uint64_t(program) << 32) | uint32_t(location);
+	}
+}
+
+
+void GLState::Stats::reset()
+{
+	programChanges = 0;
+	programSkipped = 0;
+	vaoChanges = 0;
+	vaoSkipped = 0;
+	bufferChanges = 0;
+	bufferSkipped = 0;
+	uniformUploads = 0;
+	uniformSkipped = 0;
+	drawCalls = 0;
+	objectsTested = 0;
+	frustumCulled = 0;
+	occlusionCulled = 0;
+}
+
+
+void GLState::begin_frame()
+{
+	++s_frame;
+	invalidate();
+}
+
+
+void GLState::end_frame()
+{
+	bindVertexArray(0);
+	bindBuffer(GL_ARRAY_BUFFER, 0);
+	// cible GL 4.0: seulement si elle a ete utilisee
+	if (s_draw_indirect_buffer != UNKNOWN && s_draw_indirect_buffer != 0)
+		bindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	useProgram(0);
+}
+
+
+void GLState::invalidate()
+{
+	s_program = UNKNOWN;
+	s_vao = UNKNOWN;
+	s_array_buffer = UNKNOWN;
+	s_element_buffer = UNKNOWN;
+	s_uniform_buffer = UNKNOWN;
+	s_draw_indirect_buffer = UNKNOWN;
+	for (GLuint i=0; i<NB_UNIFORM_BINDINGS; ++i)
+		s_uniform_bindings[i] = UNKNOWN;
+	// les ids de programmes peuvent designer d'autres objets dans un autre contexte
+	uniformCache().clear();
+}
+
+
+void GLState::useProgram(GLuint program)
+{
+	if (program == s_program)
+	{
+		++s_stats.programSkipped;
+		return;
+	}
+	glUseProgram(program);
+	s_program = program;
+	++s_stats.programChanges;
+}
+
+
+void GLState::bindVertexArray(GLuint vao)
+{
+	if (vao == s_vao)
+	{
+		++s_stats.vaoSkipped;
+		return;
+	}
+	glBindVertexArray(vao);
+	s_vao = vao;
+	s_element_buffer = UNKNOWN;
+	++s_stats.vaoChanges;
+}
+
+
+void GLState::bindBuffer(GLenum target, GLuint buffer)
+{
+	GLuint* cached = NULL;
+	switch(target)
+	{
+		case GL_ARRAY_BUFFER:
+			cached = &s_array_buffer;
+			break;
+		case GL_ELEMENT_ARRAY_BUFFER:
+			cached = &s_element_buffer;
+			break;
+		case GL_UNIFORM_BUFFER:
+			cached = &s_uniform_buffer;
+			break;
+		case GL_DRAW_INDIRECT_BUFFER:
+			cached = &s_draw_indirect_buffer;
+			break;
+		default:
+			break;
+	}
+
+	if (cached != NULL && *cached == buffer)
+	{
+		++s_stats.bufferSkipped;
+		return;
+	}
+	glBindBuffer(target, buffer);
+	if (cached != NULL)
+		*cached = buffer;
+	++s_stats.bufferChanges;
+}
+
+
+void GLState::bindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+	if (target != GL_UNIFORM_BUFFER || index >= NB_UNIFORM_BINDINGS)
+	{
+		glBindBufferBase(target, index, buffer);
+		++s_stats.bufferChanges;
+		return;
+	}
+
+	if (s_uniform_bindings[index] == buffer)
+	{
+		++s_stats.bufferSkipped;
+		return;
+	}
+	glBindBufferBase(target, index, buffer);
+	s_uniform_bindings[index] = buffer;
+	s_uniform_buffer = buffer;
+	++s_stats.bufferChanges;
+}
+
+
+void GLState::forgetBuffer(GLuint buffer)
+{
+	GLuint* cached[] = { &s_array_buffer, &s_element_buffer, &s_uniform_buffer, &s_draw_indirect_buffer };
+	for (GLuint* c : cached)
+		if (*c == buffer)
+			*c = UNKNOWN;
+	for (GLuint i=0; i<NB_UNIFORM_BINDINGS; ++i)
+		if (s_uniform_bindings[i] == buffer)
+			s_uniform_bindings[i] = UNKNOWN;
+}
+
+
+bool GLState::uniformCached(GLint location, const GLfloat* v, int n)
+{
+	// programme inconnu: pas de cache possible
+	if (s_program == UNKNOWN || s_program == 0)
+		return false;
+
+	auto it = uniformCache().find(uniformKey(s_program, location));
+	if (it != uniformCache().end() && std::memcmp(it->second.v, v, n*sizeof(GLfloat)) == 0)
+	{
+		++s_stats.uniformSkipped;
+		return true;
+	}
+
+	UniformValue& val = uniformCache()[uniformKey(s_program, location)];
+	std::memcpy(val.v, v, n*sizeof(GLfloat));
+	++s_stats.uniformUploads;
+	return false;
+}
+
+
+void GLState::uniformMatrix4fv(GLint location, const GLfloat* m)
+{
+	if (location < 0 || uniformCached(location, m, 16))
+		return;
+	glUniformMatrix4fv(location, 1, GL_FALSE, m);
+}
+
+
+void GLState::uniformMatrix3fv(GLint location, const GLfloat* m)
+{
+	if (location < 0 || uniformCached(location, m, 9))
+		return;
+	glUniformMatrix3fv(location, 1, GL_FALSE, m);
+}
+
+
+void GLState::uniform3fv(GLint location, const GLfloat* v)
+{
+	if (location < 0 || uniformCached(location, v, 3))
+		return;
+	glUniform3fv(location, 1, v);
+}
+
+
+void GLState::uniform1i(GLint location, GLint v)
+{
+	GLfloat f;
+	std::memcpy(&f, &v, sizeof(GLfloat));
+	if (location < 0 || uniformCached(location, &f, 1))
+		return;
+	glUniform1i(location, v);
+}
+
+
+void GLState::drawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices)
+{
+	glDrawElements(mode, count, type, indices);
+	++s_stats.drawCalls;
+}
+
+
+void GLState::drawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices, GLsizei nb)
+{
+	glDrawElementsInstanced(mode, count, type, indices, nb);
+	++s_stats.drawCalls;
+}
+
+
+void GLState::drawElementsInstancedBaseVertex(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices, GLsizei nb, GLint basevertex)
+{
+	glDrawElementsInstancedBaseVertex(mode, count, type, indices, nb, basevertex);
+	++s_stats.drawCalls;
+}
+
+
+void GLState::multiDrawElementsIndirect(GLenum mode, GLenum type, const GLvoid* indirect, GLsizei drawcount)
+{
+	glMultiDrawElementsIndirect(mode, type, indirect, drawcount, 0);
+	++s_stats.drawCalls;
+}
+
+
+void GLState::drawArrays(GLenum mode, GLint first, GLsizei count)
+{
+	glDrawArrays(mode, first, count);
+	++s_stats.drawCalls;
+}
+
+
+void GLState::countCulling(unsigned long tested, unsigned long frustumCulled, unsigned long occlusionCulled)
+{
+	s_stats.objectsTested += tested;
+	s_stats.frustumCulled += frustumCulled;
+	s_stats.occlusionCulled += occlusionCulled;
+}
+
+
+void GLState::forgetProgram(GLuint program)
+{
+	auto& cache = uniformCache();
+	for (auto it = cache.begin(); it != cache.end(); )
+	{
+		if ((it->first >> 32) == program)
+			it = cache.erase(it);
+		else
+			++it;
+	}
+	if (s_program == program)
+		s_program = UNKNOWN;
+}
@@ -0,0 +1,121 @@
+#ifndef GLSTATE_H
+#define GLSTATE_H
+
+#include <GL/glew.h>
+
+#include "shader.h"
+
+/**
+ * @brief Cache de l'etat OpenGL (programme, VAO, buffers, uniforms)
+ *
+ * Les changements redondants ne sont pas envoyes au driver.
+ * Le cache ne connait que les changements faits a travers lui :
+ * begin_frame() l'invalide (changement de contexte, code GL externe),
+ * end_frame() remet les liaisons a 0 pour le code qui suit (QGLViewer).
+ */
+class OGLRENDER_API GLState
+{
+public:
+	/// compteurs (changements effectues / evites)
+	struct Stats
+	{
+		unsigned long programChanges;
+		unsigned long programSkipped;
+		unsigned long vaoChanges;
+		unsigned long vaoSkipped;
+		unsigned long bufferChanges;
+		unsigned long bufferSkipped;
+		unsigned long uniformUploads;
+		unsigned long uniformSkipped;
+		unsigned long drawCalls;
+		/// culling: objets testes, rejetes (pyramide de vision / occlusion)
+		unsigned long objectsTested;
+		unsigned long frustumCulled;
+		unsigned long occlusionCulled;
+
+		Stats() { reset(); }
+		void reset();
+
+		/// total des changements d'etat envoyes au driver
+		inline unsigned long stateChanges() const	{ return programChanges + vaoChanges + bufferChanges + uniformUploads; }
+		/// total des changements d'etat evites
+		inline unsigned long stateSkipped() const	{ return programSkipped + vaoSkipped + bufferSkipped + uniformSkipped; }
+	};
+
+	/// a appeler en debut de draw(): oublie l'etat connu
+	static void begin_frame();
+
+	/// a appeler en fin de draw(): delie programme, VAO et buffers
+	static void end_frame();
+
+	/// oublie l'etat connu (apres des appels GL faits hors du cache)
+	static void invalidate();
+
+	static void useProgram(GLuint program);
+
+	/// le programme reste lie jusqu'au prochain useProgram() ou end_frame()
+	static void releaseProgram()				{}
+
+	static void bindVertexArray(GLuint vao);
+
+	static void bindBuffer(GLenum target, GLuint buffer);
+
+	/// liaison indexee (GL_UNIFORM_BUFFER), change aussi la liaison generique
+	static void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+
+	/// le buffer est detruit: oublie ses liaisons
+	static void forgetBuffer(GLuint buffer);
+
+	/// le programme doit etre lie (useProgram)
+	static void uniformMatrix4fv(GLint location, const GLfloat* m);
+	static void uniformMatrix3fv(GLint location, const GLfloat* m);
+	static void uniform3fv(GLint location, const GLfloat* v);
+	static void uniform1i(GLint location, GLint v);
+
+	/// draw calls (comptes)
+	static void drawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices);
+	static void drawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices, GLsizei nb);
+	static void drawArrays(GLenum mode, GLint first, GLsizei count);
+	/// GL 3.2
+	static void drawElementsInstancedBaseVertex(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices, GLsizei nb, GLint basevertex);
+	/// GL 4.3 / ARB_multi_draw_indirect: compte pour 1 draw call
+	static void multiDrawElementsIndirect(GLenum mode, GLenum type, const GLvoid* indirect, GLsizei drawcount);
+
+	/// resultats du culling (ajoutes aux compteurs)
+	static void countCulling(unsigned long tested, unsigned long frustumCulled, unsigned long occlusionCulled);
+
+	/// le programme est detruit: oublie ses uniforms
+	static void forgetProgram(GLuint program);
+
+	static inline GLuint currentProgram()		{ return s_program; }
+	static inline GLuint currentVertexArray()	{ return s_vao; }
+
+	/// numero de la frame courante (incremente par begin_frame)
+	static inline unsigned long frame()			{ return s_frame; }
+
+	static inline const Stats& stats()			{ return s_stats; }
+	static inline void resetStats()				{ s_stats.reset(); }
+
+protected:
+	/// valeur d'une liaison inconnue
+	static const GLuint UNKNOWN = ~0u;
+
+	/// true si la valeur est deja celle du cache, sinon met le cache a jour
+	static bool uniformCached(GLint location, const GLfloat* v, int n);
+
+	static GLuint s_program;
+	static GLuint s_vao;
+	static GLuint s_array_buffer;
+	/// l'EBO fait partie de l'etat du VAO: inconnu a chaque changement de VAO
+	static GLuint s_element_buffer;
+	static GLuint s_uniform_buffer;
+	static GLuint s_draw_indirect_buffer;
+	/// points de liaison des uniform buffers suivis par le cache
+	static const GLuint NB_UNIFORM_BINDINGS = 4;
+	static GLuint s_uniform_bindings[NB_UNIFORM_BINDINGS];
+
+	static Stats s_stats;
+	static unsigned long s_frame;
+};
+
+#endif // GLSTATE_H
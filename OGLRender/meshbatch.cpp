@@ -0,0 +1,321 @@
+#include "meshbatch.h"
+#include "glstate.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+
+MeshBatch::MeshBatch():
+	m_meshes_dirty(false),
+	m_frame(GLState::frame()-1),
+	m_edge_color(0.0f, 0.0f, 0.0f),
+	m_edges(true),
+	m_has_multi_draw(false),
+	m_multi_draw(false),
+	m_shader_fill(NULL),
+	m_shader_edges(NULL),
+	m_capacity_inst(0),
+	m_capacity_cmd(0),
+	m_queue(NULL)
+{
+}
+
+
+MeshBatch::~MeshBatch()
+{
+	ShaderProgramRegistry::release(m_shader_fill);
+	ShaderProgramRegistry::release(m_shader_edges);
+}
+
+
+void MeshBatch::gl_init()
+{
+	m_shader_fill = ShaderProgramRegistry::acquire<ShaderProgramFlatInstanced>();
+	m_shader_edges = ShaderProgramRegistry::acquire<ShaderProgramColorInstanced>();
+
+	// baseInstance des commandes: GL 4.2, multi-draw indirect: GL 4.3
+	m_has_multi_draw = GLEW_VERSION_4_3 || (GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance);
+	m_multi_draw = m_has_multi_draw;
+
+	glGenBuffers(1, &m_vbo);
+	glGenBuffers(1, &m_ebo);
+	glGenBuffers(1, &m_vbo_inst);
+	if (m_has_multi_draw)
+		glGenBuffers(1, &m_dbo);
+
+	// faces: sommets partages + transfo/couleur par instance
+	glGenVertexArrays(1, &m_vao_fill);
+	glBindVertexArray(m_vao_fill);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	glEnableVertexAttribArray(m_shader_fill->idOfVertexAttribute);
+	glVertexAttribPointer(m_shader_fill->idOfVertexAttribute, 3, GL_FLOAT, GL_FALSE, 0, 0);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo_inst);
+	for (int c=0; c<4; ++c)
+	{
+		glEnableVertexAttribArray(m_shader_fill->idOfTransfoAttribute+c);
+		glVertexAttribDivisor(m_shader_fill->idOfTransfoAttribute+c, 1);
+	}
+	glEnableVertexAttribArray(m_shader_fill->idOfColorAttribute);
+	glVertexAttribDivisor(m_shader_fill->idOfColorAttribute, 1);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+
+	// aretes: sommets partages + transfo par instance
+	glGenVertexArrays(1, &m_vao_edges);
+	glBindVertexArray(m_vao_edges);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	glEnableVertexAttribArray(m_shader_edges->idOfVertexAttribute);
+	glVertexAttribPointer(m_shader_edges->idOfVertexAttribute, 3, GL_FLOAT, GL_FALSE, 0, 0);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo_inst);
+	for (int c=0; c<4; ++c)
+	{
+		glEnableVertexAttribArray(m_shader_edges->idOfTransfoAttribute+c);
+		glVertexAttribDivisor(m_shader_edges->idOfTransfoAttribute+c, 1);
+	}
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+
+int MeshBatch::add_mesh(const std::vector<glm::vec3>& points, const std::vector<int>& triangles, const std::vector<int>& edges)
+{
+	m_meshes.push_back(Mesh());
+	m_ranges.push_back(Range());
+	set_mesh(int(m_meshes.size())-1, points, triangles, edges);
+	return int(m_meshes.size())-1;
+}
+
+
+void MeshBatch::set_mesh(int id, const std::vector<glm::vec3>& points, const std::vector<int>& triangles, const std::vector<int>& edges)
+{
+	Mesh& m = m_meshes[id];
+	m.points = points;
+	m.triangles = triangles;
+	m.edges = edges;
+	m_meshes_dirty = true;
+}
+
+
+void MeshBatch::clear()
+{
+	m_meshes.clear();
+	m_ranges.clear();
+	m_instances.clear();
+	m_instance_mesh.clear();
+	m_meshes_dirty = true;
+}
+
+
+void MeshBatch::set_matrices(const glm::mat4& view, const glm::mat4& projection)
+{
+	viewMatrix = view;
+	projectionMatrix = projection;
+}
+
+
+void MeshBatch::draw(int id, const glm::mat4& transfo, const glm::vec3& color)
+{
+	Instance inst;
+	inst.transfo = transfo;
+	inst.color = color;
+	m_instances.push_back(inst);
+	m_instance_mesh.push_back(id);
+}
+
+
+void MeshBatch::upload_meshes()
+{
+	// sommets puis indices de tous les maillages a la suite:
+	// indices locaux (baseVertex), triangles et aretes dans le meme EBO
+	std::vector<glm::vec3> points;
+	std::vector<int> indices;
+	for (std::size_t i=0; i<m_meshes.size(); ++i)
+	{
+		const Mesh& m = m_meshes[i];
+		Range& rg = m_ranges[i];
+		rg.baseVertex = GLint(points.size());
+		rg.firstTriangle = GLuint(indices.size());
+		rg.nbTriangles = GLuint(m.triangles.size());
+		indices.insert(indices.end(), m.triangles.begin(), m.triangles.end());
+		rg.firstEdge = GLuint(indices.size());
+		rg.nbEdges = GLuint(m.edges.size());
+		indices.insert(indices.end(), m.edges.begin(), m.edges.end());
+		points.insert(points.end(), m.points.begin(), m.points.end());
+	}
+
+	GLState::bindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	glBufferData(GL_ARRAY_BUFFER, points.size()*sizeof(glm::vec3), points.empty() ? NULL : &points[0][0], GL_STATIC_DRAW);
+
+	// l'EBO est lie aux VAOs
+	GLState::bindVertexArray(m_vao_fill);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size()*sizeof(int), indices.empty() ? NULL : &indices[0], GL_STATIC_DRAW);
+
+	m_meshes_dirty = false;
+}
+
+
+void MeshBatch::draw_fill_pass(void* object, const RenderQueue::Command& cmd)
+{
+	MeshBatch* batch = static_cast<MeshBatch*>(object);
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(1.0f, 1.0f);
+	batch->m_shader_fill->sendCamera(batch->viewMatrix, batch->projectionMatrix);
+	batch->draw_pass(GL_TRIANGLES, std::size_t(cmd.first), std::size_t(cmd.count), batch->m_shader_fill->idOfTransfoAttribute, batch->m_shader_fill->idOfColorAttribute);
+	glDisable(GL_POLYGON_OFFSET_FILL);
+}
+
+
+void MeshBatch::draw_edges_pass(void* object, const RenderQueue::Command& cmd)
+{
+	MeshBatch* batch = static_cast<MeshBatch*>(object);
+	batch->m_shader_edges->sendCamera(batch->viewMatrix, batch->projectionMatrix);
+	GLState::uniform3fv(batch->m_shader_edges->idOfColorUniform, glm::value_ptr(batch->m_edge_color));
+	batch->draw_pass(GL_LINES, std::size_t(cmd.first+cmd.count), std::size_t(cmd.count), batch->m_shader_edges->idOfTransfoAttribute, -1);
+}
+
+
+void MeshBatch::set_instance_pointers(GLint transfo_attrib, GLint color_attrib, std::size_t first)
+{
+	const std::size_t base = first*sizeof(Instance);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, m_vbo_inst);
+	for (int c=0; c<4; ++c)
+		glVertexAttribPointer(transfo_attrib+c, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (GLvoid*)(base + c*sizeof(glm::vec4)));
+	if (color_attrib >= 0)
+		glVertexAttribPointer(color_attrib, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (GLvoid*)(base + sizeof(glm::mat4)));
+}
+
+
+void MeshBatch::draw_pass(GLenum mode, std::size_t first_cmd, std::size_t n, GLint transfo_attrib, GLint color_attrib)
+{
+	if (m_multi_draw)
+	{
+		// baseInstance de chaque commande choisit l'objet
+		set_instance_pointers(transfo_attrib, color_attrib, 0);
+		GLState::bindBuffer(GL_DRAW_INDIRECT_BUFFER, m_dbo);
+		GLState::multiDrawElementsIndirect(mode, GL_UNSIGNED_INT, (GLvoid*)(first_cmd*sizeof(DrawCommand)), GLsizei(n));
+		return;
+	}
+
+	// boucle CPU: les attributs d'instance sont decales sur l'objet
+	// (pas de baseInstance avant GL 4.2)
+	for (std::size_t i=0; i<n; ++i)
+	{
+		const DrawCommand& cmd = m_commands[first_cmd+i];
+		if (cmd.count == 0)
+			continue;
+		set_instance_pointers(transfo_attrib, color_attrib, cmd.baseInstance);
+		GLState::drawElementsInstancedBaseVertex(mode, cmd.count, GL_UNSIGNED_INT, (GLvoid*)(cmd.firstIndex*sizeof(int)), 1, cmd.baseVertex);
+	}
+}
+
+
+void MeshBatch::flush()
+{
+	static_assert(sizeof(Instance) == sizeof(glm::mat4)+sizeof(glm::vec3), "Instance doit etre compacte (attributs entrelaces)");
+	static_assert(sizeof(DrawCommand) == 5*sizeof(GLuint), "DrawCommand doit suivre DrawElementsIndirectCommand");
+
+	if (m_meshes_dirty)
+		upload_meshes();
+
+	const std::size_t n = m_instances.size();
+	if (n == 0)
+		return;
+
+	// 1er flush depuis GLState::begin_frame(): nouvelle frame
+	const bool new_frame = (m_frame != GLState::frame());
+	if (new_frame)
+	{
+		m_frame = GLState::frame();
+		m_frame_instances.clear();
+		m_commands.clear();
+	}
+
+	// objets et commandes ajoutes a ceux de la frame: les passes deja
+	// dans une file restent valides si flush() est appele plusieurs fois
+	// commandes du flush: faces [c0,c0+n) puis aretes [c0+n,c0+2n)
+	const std::size_t i0 = m_frame_instances.size();
+	const std::size_t c0 = m_commands.size();
+	m_frame_instances.insert(m_frame_instances.end(), m_instances.begin(), m_instances.end());
+	m_commands.resize(c0+2*n);
+	for (std::size_t i=0; i<n; ++i)
+	{
+		const Range& rg = m_ranges[m_instance_mesh[i]];
+		DrawCommand& fill = m_commands[c0+i];
+		fill.count = rg.nbTriangles;
+		fill.instanceCount = 1;
+		fill.firstIndex = rg.firstTriangle;
+		fill.baseVertex = rg.baseVertex;
+		fill.baseInstance = GLuint(i0+i);
+
+		DrawCommand& edges = m_commands[c0+n+i];
+		edges = fill;
+		edges.count = m_edges ? rg.nbEdges : 0;
+		edges.firstIndex = rg.firstEdge;
+	}
+
+	GLState::bindBuffer(GL_ARRAY_BUFFER, m_vbo_inst);
+	if (m_frame_instances.size() > m_capacity_inst)
+	{
+		// agrandissement: on renvoie toute la frame
+		m_capacity_inst = 2*m_frame_instances.size();
+		glBufferData(GL_ARRAY_BUFFER, m_capacity_inst*sizeof(Instance), NULL, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, m_frame_instances.size()*sizeof(Instance), &m_frame_instances[0]);
+	}
+	else
+	{
+		// 1er flush de la frame: realloue (orphaning) pour ne pas attendre le GPU sur la frame precedente
+		if (new_frame)
+			glBufferData(GL_ARRAY_BUFFER, m_capacity_inst*sizeof(Instance), NULL, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, i0*sizeof(Instance), n*sizeof(Instance), &m_frame_instances[i0]);
+	}
+
+	if (m_multi_draw)
+	{
+		GLState::bindBuffer(GL_DRAW_INDIRECT_BUFFER, m_dbo);
+		if (m_commands.size() > m_capacity_cmd)
+		{
+			m_capacity_cmd = 2*m_commands.size();
+			glBufferData(GL_DRAW_INDIRECT_BUFFER, m_capacity_cmd*sizeof(DrawCommand), NULL, GL_STREAM_DRAW);
+			glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, m_commands.size()*sizeof(DrawCommand), &m_commands[0]);
+		}
+		else
+		{
+			if (new_frame)
+				glBufferData(GL_DRAW_INDIRECT_BUFFER, m_capacity_cmd*sizeof(DrawCommand), NULL, GL_STREAM_DRAW);
+			glBufferSubData(GL_DRAW_INDIRECT_BUFFER, c0*sizeof(DrawCommand), 2*n*sizeof(DrawCommand), &m_commands[c0]);
+		}
+	}
+
+	RenderQueue::Command fill = RenderQueue::command(m_shader_fill->programId(), m_vao_fill, &MeshBatch::draw_fill_pass, this);
+	fill.first = int(c0);
+	fill.count = int(n);
+	RenderQueue::Command edges = RenderQueue::command(m_shader_edges->programId(), m_vao_edges, &MeshBatch::draw_edges_pass, this);
+	edges.first = int(c0);
+	edges.count = int(n);
+
+	if (m_queue != NULL)
+	{
+		m_queue->push(fill);
+		if (m_edges)
+			m_queue->push(edges);
+	}
+	else
+	{
+		m_shader_fill->startUseProgram();
+		GLState::bindVertexArray(m_vao_fill);
+		draw_fill_pass(this, fill);
+		m_shader_fill->stopUseProgram();
+
+		if (m_edges)
+		{
+			m_shader_edges->startUseProgram();
+			GLState::bindVertexArray(m_vao_edges);
+			draw_edges_pass(this, edges);
+			m_shader_edges->stopUseProgram();
+		}
+	}
+
+	m_instances.clear();
+	m_instance_mesh.clear();
+}
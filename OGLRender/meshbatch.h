@@ -0,0 +1,204 @@
+#ifndef MESHBATCH_H
+#define MESHBATCH_H
+
+#include <vector>
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+#include "shaderprogramflatinstanced.h"
+#include "shaderprogramcolorinstanced.h"
+#include "shaderprogramregistry.h"
+#include "renderqueue.h"
+
+
+/**
+ * @brief Nombreux petits maillages dessines en multi-draw indirect
+ *
+ * Les maillages sont ranges dans un VBO et un EBO partages. Chaque objet
+ * dessine (maillage + transfo + couleur) devient une commande de dessin;
+ * flush() envoie une passe de faces et une passe d'aretes, chacune en un
+ * seul glMultiDrawElementsIndirect (GL 4.3). Sans l'extension (GL logiciel)
+ * les commandes sont executees une a une par une boucle CPU.
+ */
+class OGLRENDER_API MeshBatch
+{
+public:
+	MeshBatch();
+
+	/// rend les programmes au registre (contexte GL courant)
+	~MeshBatch();
+
+	/// init openGL (detecte le multi-draw indirect)
+	void gl_init();
+
+	/**
+	 * @brief ajoute un maillage aux buffers partages
+	 * @param points sommets
+	 * @param triangles indices de triangles
+	 * @param edges indices d'aretes (paires, optionnel)
+	 * @return identifiant du maillage
+	 */
+	int add_mesh(const std::vector<glm::vec3>& points, const std::vector<int>& triangles, const std::vector<int>& edges = std::vector<int>());
+
+	/**
+	 * @brief remplace un maillage (buffers partages renvoyes au prochain flush)
+	 * @param id identifiant renvoye par add_mesh
+	 */
+	void set_mesh(int id, const std::vector<glm::vec3>& points, const std::vector<int>& triangles, const std::vector<int>& edges = std::vector<int>());
+
+	/// supprime tous les maillages
+	void clear();
+
+	/// nombre de maillages
+	inline int nb_meshes() const { return int(m_meshes.size()); }
+
+	/**
+	 * @brief copie localement les matrices OGL (a faire 1x en debut de draw)
+	 * @param view matrice de model-view
+	 * @param projection matrice de projection
+	 */
+	void set_matrices(const glm::mat4& view, const glm::mat4& projection);
+
+	/**
+	 * @brief enregistre le dessin d'un maillage (dessine par flush)
+	 * @param id identifiant du maillage
+	 * @param transfo matrice de transformation a appliquer
+	 * @param color couleur des faces
+	 */
+	void draw(int id, const glm::mat4& transfo, const glm::vec3& color);
+
+	/**
+	 * @brief dessine les objets enregistres (faces puis aretes)
+	 * Peut etre appele plusieurs fois par frame: les objets sont ajoutes
+	 * a ceux de la frame (buffers realloues au 1er flush apres GLState::begin_frame()).
+	 */
+	void flush();
+
+	/// couleur des aretes (noir par defaut)
+	inline void set_edge_color(const glm::vec3& color) { m_edge_color = color; }
+
+	/// dessin des aretes on/off
+	inline void set_edges(bool on) { m_edges = on; }
+
+	/**
+	 * @brief choisit le chemin multi-draw indirect s'il est disponible
+	 * (false: boucle CPU, meme si l'extension est presente)
+	 */
+	inline void set_multi_draw(bool on) { m_multi_draw = on && m_has_multi_draw; }
+
+	/// chemin multi-draw indirect actif ?
+	inline bool multi_draw() const { return m_multi_draw; }
+
+	/**
+	 * @brief les draws sont ajoutes a la file (triee par programme/VAO)
+	 * au lieu d'etre executes (NULL: dessin immediat)
+	 * @param queue file de rendu de la frame
+	 */
+	inline void set_queue(RenderQueue* queue) { m_queue = queue; }
+
+protected:
+	/// maillage (copie CPU pour reconstruire les buffers partages)
+	struct Mesh
+	{
+		std::vector<glm::vec3> points;
+		std::vector<int> triangles;
+		std::vector<int> edges;
+	};
+
+	/// position d'un maillage dans les buffers partages
+	struct Range
+	{
+		GLint baseVertex;
+		GLuint firstTriangle;
+		GLuint nbTriangles;
+		GLuint firstEdge;
+		GLuint nbEdges;
+	};
+
+	/// donnees par objet (attributs d'instance)
+	struct Instance
+	{
+		glm::mat4 transfo;
+		glm::vec3 color;
+	};
+
+	/// format impose par glMultiDrawElementsIndirect
+	struct DrawCommand
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	/// range les maillages dans les buffers partages
+	void upload_meshes();
+
+	/**
+	 * @brief fait pointer les attributs d'instance sur un objet
+	 * @param transfo_attrib 1ere location de la matrice
+	 * @param color_attrib location de la couleur (-1: aucune)
+	 * @param first indice de l'objet
+	 */
+	void set_instance_pointers(GLint transfo_attrib, GLint color_attrib, std::size_t first);
+
+	/**
+	 * @brief execute une passe (faces ou aretes)
+	 * @param mode GL_TRIANGLES ou GL_LINES
+	 * @param first_cmd 1ere commande de la passe
+	 * @param n nombre de commandes
+	 * @param transfo_attrib 1ere location de la matrice
+	 * @param color_attrib location de la couleur (-1: aucune)
+	 */
+	void draw_pass(GLenum mode, std::size_t first_cmd, std::size_t n, GLint transfo_attrib, GLint color_attrib);
+
+	/// passe des faces d'un flush (first: 1ere commande, count: nombre d'objets)
+	static void draw_fill_pass(void* object, const RenderQueue::Command& cmd);
+
+	/// passe des aretes d'un flush (first: 1ere commande de faces, count: nombre d'objets)
+	static void draw_edges_pass(void* object, const RenderQueue::Command& cmd);
+
+	glm::mat4 viewMatrix;
+	glm::mat4 projectionMatrix;
+
+	std::vector<Mesh> m_meshes;
+	std::vector<Range> m_ranges;
+	/// maillages modifies depuis le dernier envoi
+	bool m_meshes_dirty;
+
+	/// frame (GLState::frame) de m_frame_instances et m_commands
+	unsigned long m_frame;
+	/// objets enregistres depuis le dernier flush
+	std::vector<Instance> m_instances;
+	std::vector<int> m_instance_mesh;
+	/// objets envoyes au VBO depuis le debut de la frame
+	std::vector<Instance> m_frame_instances;
+	/// commandes de la frame: pour chaque flush, faces [c0,c0+n) puis aretes [c0+n,c0+2n)
+	std::vector<DrawCommand> m_commands;
+
+	glm::vec3 m_edge_color;
+	bool m_edges;
+
+	bool m_has_multi_draw;
+	bool m_multi_draw;
+
+	/// OpenGL
+	ShaderProgramFlatInstanced* m_shader_fill;
+	ShaderProgramColorInstanced* m_shader_edges;
+	GLuint m_vao_fill;
+	GLuint m_vao_edges;
+	GLuint m_vbo;
+	GLuint m_ebo;
+	GLuint m_vbo_inst;
+	GLuint m_dbo;
+	/// taille allouee des buffers par frame (nombre d'objets / de commandes)
+	std::size_t m_capacity_inst;
+	std::size_t m_capacity_cmd;
+
+	/// file de rendu (optionnelle)
+	RenderQueue* m_queue;
+};
+
+#endif // MESHBATCH_H
@@ -1,22 +1,28 @@
-#version 130
+#version 140
 
 
 in vec3 vertex_in;
 in vec3 normal_in;
 
-uniform mat4 projectionMatrix;
-uniform mat4 viewMatrix;
-uniform mat4 normalMatrix;
+layout(std140) uniform Camera
+{
+	mat4 viewMatrix;
+	mat4 projectionMatrix;
+	mat4 viewProjMatrix;
+};
+
+uniform mat4 modelMatrix = mat4(1.0);
+// inverse transposee de modelMatrix (mat3(modelMatrix) si echelle uniforme)
+uniform mat3 normalMatrix = mat3(1.0);
 
 out vec3 P;
 out vec3 N;
 
 void main()
 {
-	vec4 N4 = normalMatrix * vec4(normal_in, 1.0);
-	N = N4.xyz;
+	N = mat3(viewMatrix) * (normalMatrix * normal_in);
 
-	vec4 P4 = viewMatrix * vec4(vertex_in, 1.0);
+	vec4 P4 = viewMatrix * modelMatrix * vec4(vertex_in, 1.0);
 	P = P4.xyz;
 
 	gl_Position = projectionMatrix * P4;
@@ -0,0 +1,683 @@
+#include <cmath>
+#include "primitives.h"
+
+
+/*
+ * Geometrie generee a la compilation
+ * (C++14: fonctions constexpr avec boucles, trigo par series de Taylor)
+ */
+namespace
+{
+	constexpr double PI = 3.14159265358979323846;
+
+	/// sinus constexpr (reduction a [-pi,pi] puis serie de Taylor)
+	constexpr double cst_sin(double x)
+	{
+		while (x > PI)
+			x -= 2.0*PI;
+		while (x < -PI)
+			x += 2.0*PI;
+
+		double term = x;
+		double sum = x;
+		for (int n=1; n<20; ++n)
+		{
+			term *= -x*x / ((2*n)*(2*n+1));
+			sum += term;
+		}
+		return sum;
+	}
+
+	constexpr double cst_cos(double x)
+	{
+		return cst_sin(x + PI/2.0);
+	}
+
+	/// meme ordre que Primitives::Shape
+	constexpr int SH_CUBE = 0;
+	constexpr int SH_CONE = 1;
+	constexpr int SH_SPHERE = 2;
+	constexpr int SH_CYLINDER = 3;
+
+	/// nombre de cotes de chaque niveau de detail
+	constexpr int LOD_SIDES[4] = { 32, 16, 8, 4 };
+
+	constexpr int cylinder_points(int sides)	{ return 2*sides+2; }
+	constexpr int cylinder_indices(int sides)	{ return 12*sides; }
+	constexpr int cone_points(int sides)		{ return sides+2; }
+	constexpr int cone_indices(int sides)		{ return 6*sides; }
+	constexpr int sphere_points(int sides)		{ return sides*sides+2; }
+	constexpr int sphere_indices(int sides)		{ return 6*sides*sides; }
+
+	constexpr int total_points()
+	{
+		int n = cylinder_points(4); // cube
+		for (int s: LOD_SIDES)
+			n += cylinder_points(s) + cone_points(s) + sphere_points(s);
+		return n;
+	}
+
+	constexpr int total_indices()
+	{
+		int n = cylinder_indices(4); // cube
+		for (int s: LOD_SIDES)
+			n += cylinder_indices(s) + cone_indices(s) + sphere_indices(s);
+		return n;
+	}
+
+	struct Point
+	{
+		float x;
+		float y;
+		float z;
+	};
+
+	struct Geometry
+	{
+		Point points[total_points()];
+		int indices[total_indices()];
+		/// [shape][lod] -> premier indice, nombre d'indices
+		int first[4][4];
+		int count[4][4];
+		int nb_points;
+		int nb_indices;
+
+		constexpr void add_point(double x, double y, double z)
+		{
+			points[nb_points].x = float(x);
+			points[nb_points].y = float(y);
+			points[nb_points].z = float(z);
+			++nb_points;
+		}
+
+		constexpr void add_index(int i)
+		{
+			indices[nb_indices++] = i;
+		}
+
+		constexpr void add_cylinder(int sides, double radius, double a0)
+		{
+			int beg = nb_points;
+			double b = 2.0*PI/sides;
+			for (int i=0;i<sides;++i)
+			{
+				double a = a0 + i*b;
+				add_point(radius*cst_cos(a),radius*cst_sin(a),-0.5);
+				add_point(radius*cst_cos(a),radius*cst_sin(a),0.5);
+			}
+
+			int cb = nb_points;
+			add_point(0.0,0.0,-0.5);
+			int ch = nb_points;
+			add_point(0.0,0.0, 0.5);
+
+			int sides2 = 2*sides;
+
+			for (int i=0;i<sides;++i)
+			{
+				add_index(beg+2*i);
+				add_index(beg+(2*i+2)%sides2);
+				add_index(beg+(2*i+1)%sides2);
+				add_index(beg+(2*i+3)%sides2);
+				add_index(beg+(2*i+1)%sides2);
+				add_index(beg+(2*i+2)%sides2);
+
+				add_index(beg+(2*i+2)%sides2);
+				add_index(beg+2*i);
+				add_index(cb);
+
+				add_index(beg+(2*i+1)%sides2);
+				add_index(beg+(2*i+3)%sides2);
+				add_index(ch);
+			}
+		}
+
+		constexpr void add_cone(int sides, double radius)
+		{
+			int beg = nb_points;
+			double b = 2.0*PI/sides;
+			for (int i=0;i<sides;++i)
+				add_point(radius*cst_cos(i*b),radius*cst_sin(i*b),-0.5);
+
+			int cb = nb_points;
+			add_point(0.0,0.0,-0.5);
+			int ch = nb_points;
+			add_point(0.0,0.0, 0.5);
+
+			for (int i=0;i<sides;++i)
+			{
+				add_index(beg+i);
+				add_index(beg+(i+1)%sides);
+				add_index(ch);
+
+				add_index(beg+(i+1)%sides);
+				add_index(beg+i);
+				add_index(cb);
+			}
+		}
+
+		constexpr void add_sphere(int sides, double radius)
+		{
+			int beg = nb_points;
+
+			int nbPara = sides;
+			int nbMeri = sides;
+
+			double a1 = PI/(nbPara+1);
+			double a2 = 2.0*PI/nbMeri;
+
+			// les paralleles
+			for (int i= 0; i< nbPara; ++i)
+			{
+				double angle = -PI/2.0 + a1*(i+1);
+				double z = radius*cst_sin(angle);
+				double rad = radius*cst_cos(angle);
+
+				for  (int j=0; j< nbMeri; ++j)
+					add_point(rad*cst_cos(a2*j), rad*cst_sin(a2*j),z);
+			}
+			// les poles
+			add_point(0.0,0.0,-radius);
+			add_point(0.0,0.0, radius);
+
+			// triangles
+			for (int i= 0; i< (nbPara-1); ++i)
+			{
+				for  (int j=0; j< nbMeri; ++j)
+				{
+					add_index(beg+nbMeri*i+j);
+					add_index(beg+nbMeri*i+(j+1)%nbMeri);
+					add_index(beg+nbMeri*(i+1)+(j+1)%nbMeri);
+					add_index(beg+nbMeri*((i+1))+(j+1)%nbMeri);
+					add_index(beg+nbMeri*((i+1))+j);
+					add_index(beg+nbMeri*i+j);
+				}
+			}
+			// poles
+			for  (int j=0; j< nbMeri; ++j)
+			{
+				add_index(beg+nbMeri*nbPara);
+				add_index(beg+(j+1)%nbMeri);
+				add_index(beg+j);
+			}
+			for  (int j=0; j< nbMeri; ++j)
+			{
+				add_index(beg+nbMeri*nbPara+1);
+				add_index(beg+nbMeri*(nbPara-1)+j);
+				add_index(beg+nbMeri*(nbPara-1)+(j+1)%nbMeri);
+			}
+		}
+
+		constexpr void set_range(int sh, int lod, int beg)
+		{
+			first[sh][lod] = beg;
+			count[sh][lod] = nb_indices - beg;
+		}
+	};
+
+	constexpr Geometry build_geometry()
+	{
+		Geometry g{};
+
+		for (int l=0; l<4; ++l)
+		{
+			int beg = g.nb_indices;
+			g.add_cylinder(LOD_SIDES[l], 0.5, PI/4.0);
+			g.set_range(SH_CYLINDER, l, beg);
+
+			beg = g.nb_indices;
+			g.add_cone(LOD_SIDES[l], 0.5);
+			g.set_range(SH_CONE, l, beg);
+
+			beg = g.nb_indices;
+			g.add_sphere(LOD_SIDES[l], 0.5);
+			g.set_range(SH_SPHERE, l, beg);
+		}
+
+		// le cube n'a qu'un niveau
+		int beg = g.nb_indices;
+		g.add_cylinder(4, 0.7071, PI/4.0);
+		for (int l=0; l<4; ++l)
+			g.set_range(SH_CUBE, l, beg);
+
+		return g;
+	}
+
+	constexpr Geometry s_geometry = build_geometry();
+
+	static_assert(s_geometry.nb_points == total_points(), "nombre de sommets incoherent");
+	static_assert(s_geometry.nb_indices == total_indices(), "nombre d'indices incoherent");
+}
+
+
+const float Primitives::s_lod_pixels[Primitives::NB_LODS] = { 48.0f, 16.0f, 4.0f, 0.0f };
+
+
+Primitives::Range Primitives::range(Shape sh, int lod)
+{
+	static_assert(CUBE == SH_CUBE && CONE == SH_CONE && SPHERE == SH_SPHERE && CYLINDER == SH_CYLINDER, "Shape et table statique desynchronises");
+	static_assert(NB_LODS == sizeof(LOD_SIDES)/sizeof(LOD_SIDES[0]), "nombre de niveaux de detail incoherent");
+
+	Range rg;
+	rg.first = s_geometry.first[sh][lod];
+	rg.count = s_geometry.count[sh][lod];
+	return rg;
+}
+
+
+void Primitives::set_matrices(const glm::mat4& view, const glm::mat4& projection)
+{
+	viewMatrix = view;
+	projectionMatrix = projection;
+
+	GLint vp[4];
+	glGetIntegerv(GL_VIEWPORT, vp);
+	m_viewport_height = float(vp[3]);
+}
+
+
+glm::vec4 Primitives::bounding_sphere(Shape sh, const glm::mat4& transfo)
+{
+	// rayon de la sphere englobante (repere local), centree a l'origine:
+	// cube: coins a (0.5,0.5,0.5), cylindre et cone: bord (0.5,0,0.5)
+	float radius;
+	switch (sh)
+	{
+		case CUBE:
+			radius = 0.8661f;
+			break;
+		case SPHERE:
+			radius = 0.5f;
+			break;
+		default:
+			radius = 0.7072f;
+			break;
+	}
+
+	// plus grand facteur d'echelle de la transfo
+	float s2 = glm::max(glm::dot(glm::vec3(transfo[0]),glm::vec3(transfo[0])), glm::max(glm::dot(glm::vec3(transfo[1]),glm::vec3(transfo[1])), glm::dot(glm::vec3(transfo[2]),glm::vec3(transfo[2]))));
+
+	return glm::vec4(glm::vec3(transfo[3]), radius*std::sqrt(s2));
+}
+
+
+bool Primitives::visible(Shape sh, const glm::mat4& transfo) const
+{
+	if (m_frustum == NULL && m_occlusion == NULL)
+		return true;
+
+	const glm::vec4 s = bounding_sphere(sh, transfo);
+	const glm::vec3 c(s);
+	if (m_frustum != NULL && !m_frustum->visible(c, s.w))
+	{
+		GLState::countCulling(1, 1, 0);
+		return false;
+	}
+	if (m_occlusion != NULL && !m_occlusion->visible(c, s.w))
+	{
+		GLState::countCulling(1, 0, 1);
+		return false;
+	}
+	GLState::countCulling(1, 0, 0);
+	return true;
+}
+
+
+void Primitives::cull_instances()
+{
+	if (m_frustum == NULL && m_occlusion == NULL)
+		return;
+
+	unsigned long tested = 0;
+	unsigned long out_frustum = 0;
+	unsigned long out_occlusion = 0;
+
+	for (int i=0; i<NB_SHAPES; ++i)
+	for (int l=0; l<NB_LODS; ++l)
+	{
+		std::vector<Instance>& inst = m_instances[i][l];
+		const std::size_t n = inst.size();
+		if (n == 0)
+			continue;
+
+		m_spheres.resize(n);
+		m_visible.assign(n, 1);
+		for (std::size_t k=0; k<n; ++k)
+			m_spheres[k] = bounding_sphere(Shape(i), inst[k].transfo);
+
+		// pyramide de vision par paquets (SSE), puis occlusion sur les survivants
+		std::size_t nb = n;
+		if (m_frustum != NULL)
+			nb = m_frustum->cull_spheres(m_spheres.data(), n, m_visible.data());
+		out_frustum += n - nb;
+
+		std::size_t kept = 0;
+		for (std::size_t k=0; k<n; ++k)
+		{
+			if (!m_visible[k])
+				continue;
+			if (m_occlusion != NULL && !m_occlusion->visible(glm::vec3(m_spheres[k]), m_spheres[k].w))
+			{
+				++out_occlusion;
+				continue;
+			}
+			inst[kept++] = inst[k];
+		}
+		inst.resize(kept);
+		tested += n;
+	}
+
+	GLState::countCulling(tested, out_frustum, out_occlusion);
+}
+
+
+int Primitives::select_lod(Shape sh, const glm::mat4& transfo) const
+{
+	if (!m_lod_enabled || sh == CUBE)
+		return 0;
+
+	float r = bounding_sphere(sh, transfo).w;
+
+	// rayon projete en pixels: r * P[1][1] * h/2 / distance (perspective)
+	float px = r * projectionMatrix[1][1] * 0.5f * m_viewport_height;
+	if (projectionMatrix[3][3] == 0.0f)
+	{
+		glm::vec4 c = viewMatrix * transfo[3];
+		float d = -c.z;
+		// la camera est dans la sphere: niveau le plus fin
+		if (d <= r)
+			return 0;
+		px /= d;
+	}
+
+	int lod = 0;
+	while (lod < NB_LODS-1 && px < s_lod_pixels[lod])
+		++lod;
+	return lod;
+}
+
+void Primitives::gl_init()
+{
+	m_shader_flat = ShaderProgramRegistry::acquire<ShaderProgramFlat>();
+
+	//VBO
+	glGenBuffers(1, &m_vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(s_geometry.points), s_geometry.points, GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	//VAO
+	glGenVertexArrays(1, &m_vao);
+	glBindVertexArray(m_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	glEnableVertexAttribArray(m_shader_flat->idOfVertexAttribute);
+	glVertexAttribPointer(m_shader_flat->idOfVertexAttribute, 3, GL_FLOAT, GL_FALSE, 0, 0);
+	glBindVertexArray(0);
+
+	//EBO indices (toutes les primitives, tous les niveaux)
+	glGenBuffers(1, &m_ebo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER,sizeof(s_geometry.indices), s_geometry.indices, GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	// rendu instancie: sommets partages + VBO d'instances (divisor 1)
+	m_shader_inst = ShaderProgramRegistry::acquire<ShaderProgramFlatInstanced>();
+
+	glGenBuffers(1, &m_vbo_inst);
+	glGenVertexArrays(1, &m_vao_inst);
+	glBindVertexArray(m_vao_inst);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	glEnableVertexAttribArray(m_shader_inst->idOfVertexAttribute);
+	glVertexAttribPointer(m_shader_inst->idOfVertexAttribute, 3, GL_FLOAT, GL_FALSE, 0, 0);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo_inst);
+	for (int c=0; c<4; ++c)
+	{
+		glEnableVertexAttribArray(m_shader_inst->idOfTransfoAttribute+c);
+		glVertexAttribDivisor(m_shader_inst->idOfTransfoAttribute+c, 1);
+	}
+	glEnableVertexAttribArray(m_shader_inst->idOfColorAttribute);
+	glVertexAttribDivisor(m_shader_inst->idOfColorAttribute, 1);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Primitives::draw_shape(Shape sh, const glm::mat4& transfo, const glm::vec3& color)
+{
+	// en mode batch le culling est fait par paquets dans flush()
+	if (!m_batching && !visible(sh, transfo))
+		return;
+
+	const int lod = select_lod(sh, transfo);
+
+	if (m_batching)
+	{
+		Instance inst;
+		inst.transfo = transfo;
+		inst.color = color;
+		m_instances[sh][lod].push_back(inst);
+		return;
+	}
+
+	const Range rg = range(sh, lod);
+
+	RenderQueue::Command cmd = RenderQueue::command(m_shader_flat->programId(), m_vao, &Primitives::draw_single, this);
+	cmd.transfo = transfo;
+	cmd.color = color;
+	cmd.first = rg.first;
+	cmd.count = rg.count;
+
+	if (m_queue != NULL)
+	{
+		m_queue->push(cmd);
+		return;
+	}
+
+	m_shader_flat->startUseProgram();
+	GLState::bindVertexArray(m_vao);
+	draw_single(this, cmd);
+	m_shader_flat->stopUseProgram();
+}
+
+void Primitives::draw_single(void* object, const RenderQueue::Command& cmd)
+{
+	Primitives* prim = static_cast<Primitives*>(object);
+	ShaderProgramFlat* shader = prim->m_shader_flat;
+
+	shader->sendCamera(prim->viewMatrix, prim->projectionMatrix);
+	shader->sendModelMatrix(cmd.transfo);
+
+	GLState::uniform3fv(shader->idOfColorUniform, glm::value_ptr(cmd.color));
+	GLState::uniform3fv(shader->idOfBColorUniform, glm::value_ptr(cmd.color));
+
+	GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, prim->m_ebo);
+	GLState::drawElements(GL_TRIANGLES, cmd.count, GL_UNSIGNED_INT, (GLvoid*)(cmd.first*sizeof(int)));
+}
+
+void Primitives::draw_instanced(void* object, const RenderQueue::Command& cmd)
+{
+	Primitives* prim = static_cast<Primitives*>(object);
+	ShaderProgramFlatInstanced* shader = prim->m_shader_inst;
+
+	shader->sendCamera(prim->viewMatrix, prim->projectionMatrix);
+
+	GLState::bindBuffer(GL_ARRAY_BUFFER, prim->m_vbo_inst);
+	for (int c=0; c<4; ++c)
+		glVertexAttribPointer(shader->idOfTransfoAttribute+c, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (GLvoid*)(cmd.offset + c*sizeof(glm::vec4)));
+	glVertexAttribPointer(shader->idOfColorAttribute, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (GLvoid*)(cmd.offset + sizeof(glm::mat4)));
+
+	GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, prim->m_ebo);
+	GLState::drawElementsInstanced(GL_TRIANGLES, cmd.count, GL_UNSIGNED_INT, (GLvoid*)(cmd.first*sizeof(int)), cmd.instances);
+}
+
+void Primitives::draw_cube(const glm::mat4& transfo, const glm::vec3& color)
+{
+	draw_shape(CUBE, transfo, color);
+}
+
+void Primitives::draw_cylinder(const glm::mat4& transfo, const glm::vec3& color)
+{
+	draw_shape(CYLINDER, transfo, color);
+}
+
+void Primitives::draw_cone(const glm::mat4& transfo, const glm::vec3& color)
+{
+	draw_shape(CONE, transfo, color);
+}
+
+void Primitives::draw_sphere(const glm::mat4& transfo, const glm::vec3& color)
+{
+	draw_shape(SPHERE, transfo, color);
+}
+
+void Primitives::draw_instances(Shape sh, const glm::mat4* transfos, const glm::vec3* colors, std::size_t n)
+{
+	if (!m_batching)
+	{
+		for (std::size_t i=0; i<n; ++i)
+			draw_shape(sh, transfos[i], colors[i]);
+		return;
+	}
+
+	for (std::size_t i=0; i<n; ++i)
+	{
+		Instance inst;
+		inst.transfo = transfos[i];
+		inst.color = colors[i];
+		m_instances[sh][select_lod(sh, transfos[i])].push_back(inst);
+	}
+}
+
+
+void Primitives::begin_batch()
+{
+	// 1er batch depuis GLState::begin_frame(): nouvelle frame
+	if (m_frame != GLState::frame())
+	{
+		m_frame = GLState::frame();
+		m_frame_instances.clear();
+	}
+	m_batching = true;
+}
+
+void Primitives::end_batch()
+{
+	flush();
+	m_batching = false;
+}
+
+void Primitives::flush()
+{
+	static_assert(sizeof(Instance) == sizeof(glm::mat4)+sizeof(glm::vec3), "Instance doit etre compacte (attributs entrelaces)");
+
+	{
+		Profiler::Scope prof(m_profiler, "primitives.cull");
+		cull_instances();
+	}
+
+	std::size_t total = 0;
+	for (int i=0; i<NB_SHAPES; ++i)
+		for (int l=0; l<NB_LODS; ++l)
+			total += m_instances[i][l].size();
+	if (total == 0)
+		return;
+
+	// toutes les instances de la frame dans un seul VBO, rangees par type de primitive et niveau
+	// (les draws d'une file restent valides si flush() est appele plusieurs fois)
+	if (m_profiler)
+		m_profiler->begin("primitives.upload");
+	const std::size_t start = m_frame_instances.size();
+	std::size_t first[NB_SHAPES][NB_LODS];
+	std::size_t count[NB_SHAPES][NB_LODS];
+	for (int i=0; i<NB_SHAPES; ++i)
+	{
+		for (int l=0; l<NB_LODS; ++l)
+		{
+			first[i][l] = m_frame_instances.size();
+			count[i][l] = m_instances[i][l].size();
+			m_frame_instances.insert(m_frame_instances.end(), m_instances[i][l].begin(), m_instances[i][l].end());
+			m_instances[i][l].clear();
+		}
+	}
+
+	GLState::bindBuffer(GL_ARRAY_BUFFER, m_vbo_inst);
+	if (m_frame_instances.size() > m_capacity_inst)
+	{
+		// agrandissement: on renvoie toute la frame
+		m_capacity_inst = 2*m_frame_instances.size();
+		glBufferData(GL_ARRAY_BUFFER, m_capacity_inst*sizeof(Instance), NULL, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, m_frame_instances.size()*sizeof(Instance), m_frame_instances.data());
+	}
+	else
+	{
+		// 1er flush de la frame: realloue (orphaning) pour ne pas attendre le GPU sur le buffer precedent
+		if (start == 0)
+			glBufferData(GL_ARRAY_BUFFER, m_capacity_inst*sizeof(Instance), NULL, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, start*sizeof(Instance), (m_frame_instances.size()-start)*sizeof(Instance), m_frame_instances.data()+start);
+	}
+
+	if (m_profiler)
+		m_profiler->end();
+	Profiler::Scope prof(m_profiler, "primitives.draw");
+
+	for (int i=0; i<NB_SHAPES; ++i)
+	for (int l=0; l<NB_LODS; ++l)
+	{
+		if (count[i][l] == 0)
+			continue;
+
+		// attributs d'instance decales sur la 1ere instance de la primitive
+		// (glDrawElementsInstancedBaseInstance n'existe qu'en 4.2)
+		const Range rg = range(Shape(i), l);
+		RenderQueue::Command cmd = RenderQueue::command(m_shader_inst->programId(), m_vao_inst, &Primitives::draw_instanced, this);
+		cmd.offset = first[i][l]*sizeof(Instance);
+		cmd.instances = int(count[i][l]);
+		cmd.first = rg.first;
+		cmd.count = rg.count;
+
+		if (m_queue != NULL)
+			m_queue->push(cmd);
+		else
+		{
+			m_shader_inst->startUseProgram();
+			GLState::bindVertexArray(m_vao_inst);
+			draw_instanced(this, cmd);
+			m_shader_inst->stopUseProgram();
+		}
+	}
+}
+
+
+void Primitives::set_queue(RenderQueue* queue)
+{
+	m_queue = queue;
+}
+
+
+void Primitives::set_culling(const Frustum* frustum, const OcclusionBuffer* occlusion)
+{
+	m_frustum = frustum;
+	m_occlusion = occlusion;
+}
+
+
+Primitives::Primitives():
+	m_lod_enabled(true),
+	m_viewport_height(1.0f),
+	m_batching(false),
+	m_frame(GLState::frame()-1),
+	m_shader_flat(NULL),
+	m_shader_inst(NULL),
+	m_capacity_inst(0),
+	m_queue(NULL),
+	m_frustum(NULL),
+	m_occlusion(NULL),
+	m_profiler(NULL)
+{
+}
+
+
+Primitives::~Primitives()
+{
+	ShaderProgramRegistry::release(m_shader_flat);
+	ShaderProgramRegistry::release(m_shader_inst);
+}
@@ -0,0 +1,227 @@
+#ifndef PRIMITIVES_H
+#define PRIMITIVES_H
+
+#include <vector>
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+#include "shaderprogramflat.h"
+#include "shaderprogramflatinstanced.h"
+#include "shaderprogramregistry.h"
+#include "renderqueue.h"
+#include "culling.h"
+#include "profiler.h"
+
+
+/**
+ * @brief Primitives (cube, cone, sphere, cylindre) partagees par les viewers
+ *
+ * Les tessellations sont generees a la compilation (tables statiques),
+ * le constructeur ne fait aucun calcul trigonometrique.
+ */
+class OGLRENDER_API Primitives
+{
+public:
+	/// types de primitives
+	enum Shape { CUBE=0, CONE, SPHERE, CYLINDER, NB_SHAPES };
+
+	Primitives();
+
+	/// rend les programmes au registre (contexte GL courant)
+	~Primitives();
+
+	/// init openGL
+	void gl_init();
+
+	/**
+	 * @brief copie localement les matrices OGL (a faire 1x en debut de draw)
+	 * @param view matrice de model-view
+	 * @param projection matrice de projection
+	 */
+	void set_matrices(const glm::mat4& view, const glm::mat4& projection);
+
+	/**
+	 * @brief dessine un cube (centre 0,0,0 / cote 1.0)
+	 * @param transfo matrice de transformation a appliquer
+	 * @param color couleur de rendu
+	 */
+	void draw_cube(const glm::mat4& transfo, const glm::vec3& color);
+
+	/**
+	 * @brief dessine un cone (centre 0,0,0 / rayon base 0.5 / hauteur 1.0)
+	 * @param transfo matrice de transformation a appliquer
+	 * @param color couleur de rendu
+	 */
+	void draw_cone(const glm::mat4& transfo, const glm::vec3& color);
+
+	/**
+	 * @brief dessine une sphere (centre 0,0,0 / rayon 0.5)
+	 * @param transfo matrice de transformation a appliquer
+	 * @param color couleur de rendu
+	 */
+	void draw_sphere(const glm::mat4& transfo, const glm::vec3& color);
+
+	/**
+	 * @brief dessine un cylindre (centre 0,0,0 / rayon 0.5 / hauteur 1.0)
+	 * @param transfo matrice de transformation a appliquer
+	 * @param color couleur de rendu
+	 */
+	void draw_cylinder(const glm::mat4& transfo, const glm::vec3& color);
+
+	/**
+	 * @brief dessine n primitives du meme type
+	 * (en mode batch les instances sont ajoutees directement au lot)
+	 * @param sh type de primitive
+	 * @param transfos matrices de transformation (contigues)
+	 * @param colors couleurs de rendu (contigues)
+	 * @param n nombre de primitives
+	 */
+	void draw_instances(Shape sh, const glm::mat4* transfos, const glm::vec3* colors, std::size_t n);
+
+	/**
+	 * @brief passe en mode batch: les draw_* suivants sont seulement enregistres
+	 * et dessines par flush() (1 draw instancie par type de primitive)
+	 * Le 1er appel apres GLState::begin_frame() commence une nouvelle frame
+	 * (les instances envoyees au VBO par la frame precedente sont oubliees).
+	 */
+	void begin_batch();
+
+	/**
+	 * @brief dessine les primitives enregistrees et quitte le mode batch
+	 */
+	void end_batch();
+
+	/**
+	 * @brief dessine les primitives enregistrees (reste en mode batch)
+	 */
+	void flush();
+
+	/// mode batch actif ?
+	inline bool is_batching() const { return m_batching; }
+
+	/**
+	 * @brief les draws sont ajoutes a la file (triee par programme/VAO)
+	 * au lieu d'etre executes (NULL: dessin immediat)
+	 * @param queue file de rendu de la frame
+	 */
+	void set_queue(RenderQueue* queue);
+
+	/**
+	 * @brief active/desactive le choix du niveau de detail selon la taille
+	 * a l'ecran (desactive: toujours le niveau le plus fin)
+	 */
+	inline void set_lod(bool on) { m_lod_enabled = on; }
+
+	/**
+	 * @brief primitives hors champ / cachees non dessinees (NULL: pas de test)
+	 * @param frustum pyramide de vision de la frame
+	 * @param occlusion tampon d'occlusion de la frame (optionnel)
+	 */
+	void set_culling(const Frustum* frustum, const OcclusionBuffer* occlusion = NULL);
+
+	/**
+	 * @brief zones mesurees dans flush(): cull, upload, draw (NULL: pas de mesure)
+	 * @param prof profiler du viewer
+	 */
+	inline void set_profiler(Profiler* prof) { m_profiler = prof; }
+
+
+protected:
+	/// donnees par instance (attributs du shader instancie)
+	struct Instance
+	{
+		glm::mat4 transfo;
+		glm::vec3 color;
+	};
+
+
+	glm::mat4 viewMatrix;
+	glm::mat4 projectionMatrix;
+
+	/// niveaux de detail: 32, 16, 8 et 4 cotes (le cube n'en a qu'un)
+	enum { NB_LODS = 4 };
+	/// rayon projete (en pixels) minimum de chaque niveau
+	static const float s_lod_pixels[NB_LODS];
+
+	/// portion du tableau d'indices d'une primitive a un niveau de detail
+	struct Range
+	{
+		int first;
+		int count;
+	};
+
+	/// portion d'indices de la primitive sh au niveau lod (table statique)
+	static Range range(Shape sh, int lod);
+
+	/**
+	 * @brief sphere englobante d'une primitive (repere monde)
+	 * @return centre (xyz) et rayon (w)
+	 */
+	static glm::vec4 bounding_sphere(Shape sh, const glm::mat4& transfo);
+
+	/// test de visibilite d'une primitive (frustum puis occlusion), compte dans GLState
+	bool visible(Shape sh, const glm::mat4& transfo) const;
+
+	/// retire des instances enregistrees celles qui ne sont pas visibles
+	void cull_instances();
+
+	/// dessin immediat d'une primitive
+	void draw_shape(Shape sh, const glm::mat4& transfo, const glm::vec3& color);
+
+	/// draw d'une primitive (transfo, couleur, plage d'indices first/count)
+	static void draw_single(void* object, const RenderQueue::Command& cmd);
+
+	/// draw instancie (plage d'indices, 1ere instance a offset octets, instances)
+	static void draw_instanced(void* object, const RenderQueue::Command& cmd);
+
+	/**
+	 * @brief choisit le niveau de detail d'apres la taille projetee a l'ecran
+	 * @param sh type de primitive
+	 * @param transfo matrice de transformation de la primitive
+	 * @return niveau (0: le plus fin)
+	 */
+	int select_lod(Shape sh, const glm::mat4& transfo) const;
+
+	/// selection du niveau de detail active
+	bool m_lod_enabled;
+	/// hauteur du viewport (pixels) lue dans set_matrices
+	float m_viewport_height;
+
+	/// mode batch
+	bool m_batching;
+	/// instances enregistrees par type de primitive et niveau de detail
+	std::vector<Instance> m_instances[NB_SHAPES][NB_LODS];
+	/// frame (GLState::frame) des instances de m_frame_instances
+	unsigned long m_frame;
+	/// instances envoyees au VBO depuis le debut de la frame
+	std::vector<Instance> m_frame_instances;
+
+	/// OpenGL
+	ShaderProgramFlat* m_shader_flat;
+	GLuint m_vao;
+	GLuint m_vbo;
+	GLuint m_ebo;
+
+	/// rendu instancie
+	ShaderProgramFlatInstanced* m_shader_inst;
+	GLuint m_vao_inst;
+	GLuint m_vbo_inst;
+	/// taille allouee du VBO d'instances (en nombre d'instances)
+	std::size_t m_capacity_inst;
+
+	/// file de rendu (optionnelle)
+	RenderQueue* m_queue;
+
+	/// culling (optionnel)
+	const Frustum* m_frustum;
+	const OcclusionBuffer* m_occlusion;
+
+	Profiler* m_profiler;
+	/// spheres englobantes et resultats (reutilises d'un flush a l'autre)
+	std::vector<glm::vec4> m_spheres;
+	std::vector<unsigned char> m_visible;
+
+};
+
+#endif // PRIMITIVES_H
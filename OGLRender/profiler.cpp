@@ -0,0 +1,283 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+
+
+void Profiler::Ring::push(double x, std::size_t window)
+{
+	if (v.size() < window)
+		v.resize(window, 0.0);
+	v[next] = x;
+	next = (next+1) % window;
+	size = std::min(size+1, window);
+}
+
+
+double Profiler::Ring::mean() const
+{
+	if (size == 0)
+		return 0.0;
+	double s = 0.0;
+	for (std::size_t i=0; i<size; ++i)
+		s += v[i];
+	return s / size;
+}
+
+
+double Profiler::Ring::max() const
+{
+	if (size == 0)
+		return 0.0;
+	return *std::max_element(v.begin(), v.begin()+size);
+}
+
+
+Profiler::Profiler(int window):
+	m_window(std::max(1, window)),
+	m_enabled(true),
+	m_gpu(true),
+	m_gpu_supported(false),
+	m_in_frame(false),
+	m_frame(0)
+{
+}
+
+
+Profiler::~Profiler()
+{
+	for (int i=0; i<2; ++i)
+		if (!m_queries[i].ids.empty())
+			glDeleteQueries(GLsizei(m_queries[i].ids.size()), m_queries[i].ids.data());
+}
+
+
+void Profiler::set_enabled(bool on)
+{
+	m_enabled = on;
+}
+
+
+void Profiler::set_gpu(bool on)
+{
+	m_gpu = on;
+}
+
+
+void Profiler::reset()
+{
+	for (Zone& z : m_zones)
+	{
+		z.cpu = Ring();
+		z.gpu = Ring();
+		z.calls = Ring();
+		z.cpu_frame = 0.0;
+		z.calls_frame = 0;
+	}
+	for (int i=0; i<2; ++i)
+	{
+		m_queries[i].used = 0;
+		m_queries[i].zones.clear();
+		m_queries[i].pending = false;
+	}
+}
+
+
+int Profiler::zone(const char* name)
+{
+	auto p = m_zone_ptr.find(name);
+	if (p != m_zone_ptr.end())
+		return p->second;
+
+	int z;
+	auto it = m_zone_index.find(name);
+	if (it != m_zone_index.end())
+		z = it->second;
+	else
+	{
+		Zone nz;
+		nz.name = name;
+		nz.depth = int(m_stack.size());
+		nz.cpu_frame = 0.0;
+		nz.calls_frame = 0;
+		z = int(m_zones.size());
+		m_zones.push_back(nz);
+		m_zone_index[nz.name] = z;
+	}
+	m_zone_ptr[name] = z;
+	return z;
+}
+
+
+void Profiler::begin_frame()
+{
+	// GL_TIMESTAMP: GL 3.3 (absent de certains GL logiciels)
+	GLint bits = 0;
+	if (GLEW_VERSION_3_3 || GLEW_ARB_timer_query)
+		glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+	m_gpu_supported = bits > 0;
+
+	m_in_frame = true;
+	QuerySet& qs = m_queries[m_frame % 2];
+	if (qs.pending)
+		collect(qs);
+	qs.used = 0;
+	qs.zones.clear();
+	qs.pending = false;
+}
+
+
+void Profiler::collect(QuerySet& qs)
+{
+	if (qs.used == 0)
+		return;
+
+	// les requetes se terminent dans l'ordre: la derniere suffit
+	GLint available = 0;
+	glGetQueryObjectiv(qs.ids[qs.used-1], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available)
+		return;
+
+	m_gpu_frame.assign(m_zones.size(), -1.0);
+	for (std::size_t i=0; i+1<qs.used; i+=2)
+	{
+		GLuint64 t0 = 0, t1 = 0;
+		glGetQueryObjectui64v(qs.ids[i], GL_QUERY_RESULT, &t0);
+		glGetQueryObjectui64v(qs.ids[i+1], GL_QUERY_RESULT, &t1);
+		double& g = m_gpu_frame[qs.zones[i/2]];
+		g = std::max(g, 0.0) + double(t1 - t0) * 1e-6;
+	}
+	for (std::size_t z=0; z<m_zones.size(); ++z)
+		if (m_gpu_frame[z] >= 0.0)
+			m_zones[z].gpu.push(m_gpu_frame[z], m_window);
+}
+
+
+void Profiler::begin(const char* name)
+{
+	if (!m_enabled)
+		return;
+
+	Record r;
+	r.zone = zone(name);
+	r.query = -1;
+
+	if (gpu())
+	{
+		QuerySet& qs = m_queries[m_frame % 2];
+		if (qs.ids.size() < qs.used+2)
+		{
+			GLuint q[2];
+			glGenQueries(2, q);
+			qs.ids.push_back(q[0]);
+			qs.ids.push_back(q[1]);
+		}
+		r.query = int(qs.used);
+		qs.zones.push_back(r.zone);
+		qs.used += 2;
+		glQueryCounter(qs.ids[r.query], GL_TIMESTAMP);
+	}
+
+	m_stack.push_back(r);
+	m_stack.back().start = Clock::now();
+}
+
+
+void Profiler::end()
+{
+	if (!m_enabled || m_stack.empty())
+		return;
+
+	const Record r = m_stack.back();
+	m_stack.pop_back();
+
+	Zone& z = m_zones[r.zone];
+	z.cpu_frame += std::chrono::duration<double, std::milli>(Clock::now() - r.start).count();
+	++z.calls_frame;
+
+	if (r.query >= 0)
+		glQueryCounter(m_queries[m_frame % 2].ids[r.query+1], GL_TIMESTAMP);
+}
+
+
+void Profiler::end_frame()
+{
+	// zones restees ouvertes
+	while (!m_stack.empty())
+		end();
+
+	if (!m_in_frame)
+		return;
+	m_in_frame = false;
+
+	for (Zone& z : m_zones)
+	{
+		z.cpu.push(z.cpu_frame, m_window);
+		z.calls.push(z.calls_frame, m_window);
+		z.cpu_frame = 0.0;
+		z.calls_frame = 0;
+	}
+
+	QuerySet& qs = m_queries[m_frame % 2];
+	qs.pending = qs.used > 0;
+	++m_frame;
+}
+
+
+std::vector<Profiler::Stat> Profiler::stats() const
+{
+	std::vector<Stat> res;
+	res.reserve(m_zones.size());
+	for (const Zone& z : m_zones)
+	{
+		Stat s;
+		s.name = z.name;
+		s.depth = z.depth;
+		s.calls = z.calls.mean();
+		s.cpu_mean = z.cpu.mean();
+		s.cpu_max = z.cpu.max();
+		s.gpu_mean = (z.gpu.size > 0) ? z.gpu.mean() : -1.0;
+		s.gpu_max = (z.gpu.size > 0) ? z.gpu.max() : -1.0;
+		res.push_back(s);
+	}
+	return res;
+}
+
+
+std::vector<std::string> Profiler::to_text() const
+{
+	std::vector<std::string> lines;
+	for (const Stat& s : stats())
+	{
+		std::ostringstream out;
+		out << std::fixed << std::setprecision(2);
+		out << std::string(2*s.depth, ' ') << s.name << "  cpu " << s.cpu_mean << " ms (max " << s.cpu_max << ")";
+		if (s.gpu_mean >= 0.0)
+			out << "  gpu " << s.gpu_mean << " ms (max " << s.gpu_max << ")";
+		if (s.calls > 1.0)
+			out << "  x" << std::setprecision(0) << s.calls;
+		lines.push_back(out.str());
+	}
+	return lines;
+}
+
+
+std::string Profiler::to_json() const
+{
+	std::ostringstream out;
+	out << "{\"window_frames\": " << m_window << ", \"gpu_timing\": " << (gpu() ? "true" : "false") << ", \"scopes\": [";
+	bool first = true;
+	for (const Stat& s : stats())
+	{
+		out << (first ? "" : ", ");
+		first = false;
+		out << "{\"name\": \"" << s.name << "\", \"depth\": " << s.depth << ", \"calls_per_frame\": " << s.calls;
+		out << ", \"cpu_ms\": {\"mean\": " << s.cpu_mean << ", \"max\": " << s.cpu_max << "}";
+		if (s.gpu_mean >= 0.0)
+			out << ", \"gpu_ms\": {\"mean\": " << s.gpu_mean << ", \"max\": " << s.gpu_max << "}";
+		out << "}";
+	}
+	out << "]}";
+	return out.str();
+}
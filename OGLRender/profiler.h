@@ -0,0 +1,169 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <map>
+#include <unordered_map>
+
+#include <GL/glew.h>
+
+#include "shader.h"
+
+/**
+ * @brief Temps CPU/GPU par zone nommee, moyennes glissantes
+ *
+ * begin("nom")/end() (ou Profiler::Scope) delimitent une zone, les zones
+ * s'emboitent. Le temps CPU est mesure a l'horloge; le temps GPU par
+ * 2 glQueryCounter(GL_TIMESTAMP) (GL 3.3 / ARB_timer_query) lus 2 frames
+ * plus tard: jamais d'attente du GPU, un resultat pas encore disponible
+ * est ignore. Sans timer query (GL logiciel, ...) seul le CPU est mesure.
+ *
+ * Les temps d'une zone sont cumules sur la frame puis moyennes sur les
+ * `window` dernieres frames. Resultats en texte (overlay) ou en JSON.
+ */
+class OGLRENDER_API Profiler
+{
+public:
+	/// zone mesuree tant que l'objet existe (profiler NULL accepte)
+	class Scope
+	{
+	public:
+		inline Scope(Profiler* prof, const char* name): m_prof(prof)	{ if (m_prof) m_prof->begin(name); }
+		inline ~Scope()													{ if (m_prof) m_prof->end(); }
+	private:
+		Profiler* m_prof;
+	};
+
+	/// statistiques d'une zone (ms par frame)
+	struct Stat
+	{
+		std::string name;
+		/// profondeur d'emboitement (0: zone racine)
+		int depth;
+		/// appels par frame (moyenne)
+		double calls;
+		double cpu_mean;
+		double cpu_max;
+		/// -1 si le temps GPU n'est pas mesure
+		double gpu_mean;
+		double gpu_max;
+	};
+
+	/**
+	 * @param window nombre de frames des moyennes glissantes
+	 */
+	Profiler(int window = 120);
+
+	/// le contexte GL doit etre courant (destruction des requetes)
+	~Profiler();
+
+	/// mesures on/off (off: begin/end ne font rien)
+	void set_enabled(bool on);
+	inline bool enabled() const			{ return m_enabled; }
+
+	/// mesure GPU demandee (effective si le contexte a des timer queries)
+	void set_gpu(bool on);
+	/// temps GPU mesures (contexte courant au dernier begin_frame)
+	inline bool gpu() const				{ return m_gpu && m_gpu_supported; }
+
+	/// a appeler en debut de draw(): recupere les temps GPU de la frame N-2
+	void begin_frame();
+
+	/// a appeler en fin de draw()
+	void end_frame();
+
+	/// debut de zone (name doit rester valide: chaine litterale)
+	void begin(const char* name);
+
+	/// fin de la derniere zone ouverte
+	void end();
+
+	/// oublie toutes les mesures
+	void reset();
+
+	/// statistiques des zones, dans l'ordre de 1ere rencontre
+	std::vector<Stat> stats() const;
+
+	/// une ligne par zone (indentee), pour l'overlay
+	std::vector<std::string> to_text() const;
+
+	/// statistiques au format JSON
+	std::string to_json() const;
+
+protected:
+	typedef std::chrono::steady_clock Clock;
+
+	/// echantillons des `window` dernieres frames (anneau)
+	struct Ring
+	{
+		std::vector<double> v;
+		std::size_t next;
+		std::size_t size;
+
+		Ring(): next(0), size(0) {}
+		void push(double x, std::size_t window);
+		double mean() const;
+		double max() const;
+	};
+
+	struct Zone
+	{
+		std::string name;
+		int depth;
+		/// cumul de la frame courante
+		double cpu_frame;
+		int calls_frame;
+		Ring cpu;
+		Ring gpu;
+		Ring calls;
+	};
+
+	/// zone ouverte pendant la frame
+	struct Record
+	{
+		int zone;
+		Clock::time_point start;
+		/// requetes GL_TIMESTAMP debut/fin (indices dans le jeu de la frame)
+		int query;
+	};
+
+	/// requetes d'une frame: 2 par zone ouverte
+	struct QuerySet
+	{
+		std::vector<GLuint> ids;
+		/// zone de chaque paire de requetes
+		std::vector<int> zones;
+		std::size_t used;
+		bool pending;
+
+		QuerySet(): used(0), pending(false) {}
+	};
+
+	/// zone de nom name (creee au 1er appel)
+	int zone(const char* name);
+
+	/// lit les resultats d'un jeu de requetes, sans attente
+	void collect(QuerySet& qs);
+
+	std::size_t m_window;
+	bool m_enabled;
+	bool m_gpu;
+	bool m_gpu_supported;
+	bool m_in_frame;
+
+	std::vector<Zone> m_zones;
+	std::map<std::string,int> m_zone_index;
+	/// acces rapide par adresse du nom (chaine litterale)
+	std::unordered_map<const char*,int> m_zone_ptr;
+	std::vector<Record> m_stack;
+
+	/// double buffer: la frame N utilise m_queries[N%2]
+	QuerySet m_queries[2];
+	int m_frame;
+	/// temps GPU cumules par zone pour le jeu lu
+	std::vector<double> m_gpu_frame;
+};
+
+#endif // PROFILER_H
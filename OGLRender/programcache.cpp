@@ -0,0 +1,193 @@
+#include "programcache.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+#include <QDir>
+#include <QStandardPaths>
+
+
+int ProgramCache::s_enabled = -1;
+
+namespace
+{
+	/// en-tete des fichiers du cache
+	struct Header
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t format;
+		uint32_t length;
+		uint64_t hash;
+	};
+
+	const char MAGIC[4] = { 'O', 'G', 'L', 'B' };
+	const uint32_t VERSION = 1;
+
+	/// FNV-1a 64 bits
+	uint64_t hash(const std::string& s, uint64_t h = 14695981039346656037ull)
+	{
+		for (unsigned char c : s)
+		{
+			h ^= c;
+			h *= 1099511628211ull;
+		}
+		return h;
+	}
+
+	std::string gl_string(GLenum name)
+	{
+		const GLubyte* s = glGetString(name);
+		return s ? std::string(reinterpret_cast<const char*>(s)) : std::string();
+	}
+
+	uint64_t parse_key(const std::string& key)
+	{
+		uint64_t h = 0;
+		std::istringstream in(key);
+		in >> std::hex >> h;
+		return h;
+	}
+}
+
+
+void ProgramCache::set_enabled(bool on)
+{
+	s_enabled = on ? 1 : 0;
+}
+
+
+std::string ProgramCache::directory()
+{
+	const QByteArray env = qgetenv("OGLRENDER_SHADER_CACHE");
+	if (!env.isEmpty())
+		return std::string(env.constData());
+	return (QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/OGLRender/programs").toStdString();
+}
+
+
+bool ProgramCache::supported()
+{
+	if (s_enabled < 0)
+		s_enabled = (qgetenv("OGLRENDER_SHADER_CACHE") == "off") ? 0 : 1;
+	if (s_enabled == 0)
+		return false;
+
+	if (!(GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary))
+		return false;
+
+	GLint nb_formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &nb_formats);
+	return nb_formats > 0;
+}
+
+
+std::string ProgramCache::key(const std::string& vert_src, const std::string& frag_src)
+{
+	// un autre driver (ou une autre version) ne relit pas les memes binaires
+	uint64_t h = hash(vert_src);
+	h = hash(std::string(1, '\0') + frag_src, h);
+	h = hash(std::string(1, '\0') + gl_string(GL_VENDOR) + '\n' + gl_string(GL_RENDERER) + '\n' + gl_string(GL_VERSION), h);
+
+	std::ostringstream out;
+	out << std::hex << std::setw(16) << std::setfill('0') << h;
+	return out.str();
+}
+
+
+std::string ProgramCache::filename(const std::string& key)
+{
+	return directory() + "/" + key + ".bin";
+}
+
+
+bool ProgramCache::load(GLuint program, const std::string& key)
+{
+	if (!supported())
+		return false;
+
+	std::ifstream file(filename(key).c_str(), std::ios::binary);
+	if (!file)
+		return false;
+
+	Header h;
+	std::vector<char> data;
+	if (file.read(reinterpret_cast<char*>(&h), sizeof(h)) &&
+		std::memcmp(h.magic, MAGIC, 4) == 0 && h.version == VERSION && h.hash == parse_key(key))
+	{
+		data.resize(h.length);
+		if (!file.read(data.data(), h.length))
+			data.clear();
+	}
+	file.close();
+
+	GLint ok = GL_FALSE;
+	if (!data.empty())
+	{
+		glProgramBinary(program, h.format, data.data(), GLsizei(data.size()));
+		glGetProgramiv(program, GL_LINK_STATUS, &ok);
+	}
+
+	// binaire perime ou corrompu: recompilation depuis les sources
+	if (ok != GL_TRUE)
+		std::remove(filename(key).c_str());
+	return ok == GL_TRUE;
+}
+
+
+void ProgramCache::prepare(GLuint program)
+{
+	if (supported())
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+
+void ProgramCache::save(GLuint program, const std::string& key)
+{
+	if (!supported())
+		return;
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
+
+	std::vector<char> data(length);
+	GLenum format = 0;
+	GLsizei written = 0;
+	glGetProgramBinary(program, length, &written, &format, data.data());
+	if (written <= 0)
+		return;
+
+	if (!QDir().mkpath(QString::fromStdString(directory())))
+		return;
+
+	Header h;
+	std::memcpy(h.magic, MAGIC, 4);
+	h.version = VERSION;
+	h.format = format;
+	h.length = uint32_t(written);
+	h.hash = parse_key(key);
+
+	// ecriture dans un fichier temporaire puis renommage: pas de fichier
+	// partiel lu par un autre processus
+	const std::string tmp = filename(key) + ".tmp";
+	{
+		std::ofstream file(tmp.c_str(), std::ios::binary);
+		file.write(reinterpret_cast<const char*>(&h), sizeof(h));
+		file.write(data.data(), written);
+		if (!file)
+		{
+			file.close();
+			std::remove(tmp.c_str());
+			return;
+		}
+	}
+	QDir().remove(QString::fromStdString(filename(key)));
+	QDir().rename(QString::fromStdString(tmp), QString::fromStdString(filename(key)));
+}
@@ -0,0 +1,64 @@
+#ifndef PROGRAMCACHE_H
+#define PROGRAMCACHE_H
+
+#include <string>
+
+#include <GL/glew.h>
+
+#include "shader.h"
+
+/**
+ * @brief Cache disque des programmes lies (glGetProgramBinary, GL 4.1)
+ *
+ * Cle: hash des sources (defines compris) et de la chaine du driver
+ * (vendeur, renderer, version). Un binaire refuse par le driver est
+ * supprime et le programme est recompile depuis les sources.
+ * Repertoire: $OGLRENDER_SHADER_CACHE sinon le cache utilisateur (Qt);
+ * OGLRENDER_SHADER_CACHE=off desactive le cache.
+ */
+class OGLRENDER_API ProgramCache
+{
+public:
+	/// le driver peut sauver/recharger des binaires (contexte courant)
+	static bool supported();
+
+	/**
+	 * @brief cle d'un programme
+	 * @param vert_src source du vertex shader
+	 * @param frag_src source du fragment shader
+	 * @return cle (hexadecimal)
+	 */
+	static std::string key(const std::string& vert_src, const std::string& frag_src);
+
+	/**
+	 * @brief charge un binaire dans un programme
+	 * @param program programme (vide)
+	 * @param key cle du programme
+	 * @return le programme est lie et utilisable
+	 */
+	static bool load(GLuint program, const std::string& key);
+
+	/// a appeler avant glLinkProgram: le binaire sera recuperable
+	static void prepare(GLuint program);
+
+	/**
+	 * @brief sauve le binaire d'un programme lie
+	 * @param program programme lie
+	 * @param key cle du programme
+	 */
+	static void save(GLuint program, const std::string& key);
+
+	/// active/desactive le cache (actif par defaut sauf OGLRENDER_SHADER_CACHE=off)
+	static void set_enabled(bool on);
+
+	/// repertoire du cache
+	static std::string directory();
+
+protected:
+	static std::string filename(const std::string& key);
+
+	/// -1: pas encore determine
+	static int s_enabled;
+};
+
+#endif // PROGRAMCACHE_H
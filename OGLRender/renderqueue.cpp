@@ -0,0 +1,57 @@
+#include "renderqueue.h"
+
+#include <algorithm>
+
+
+RenderQueue::RenderQueue()
+{
+}
+
+
+RenderQueue::Command RenderQueue::command(GLuint program, GLuint vao, DrawFunc draw, void* object)
+{
+	Command cmd;
+	cmd.program = program;
+	cmd.vao = vao;
+	cmd.draw = draw;
+	cmd.object = object;
+	cmd.transfo = glm::mat4(1.0f);
+	cmd.color = glm::vec3(0.0f);
+	cmd.first = 0;
+	cmd.count = 0;
+	cmd.instances = 0;
+	cmd.offset = 0;
+	return cmd;
+}
+
+
+void RenderQueue::push(const Command& cmd)
+{
+	m_items.push_back(cmd);
+}
+
+
+void RenderQueue::flush()
+{
+	std::stable_sort(m_items.begin(), m_items.end(), [] (const Command& a, const Command& b) -> bool
+	{
+		if (a.program != b.program)
+			return a.program < b.program;
+		return a.vao < b.vao;
+	});
+
+	for (const Command& cmd: m_items)
+	{
+		GLState::useProgram(cmd.program);
+		GLState::bindVertexArray(cmd.vao);
+		cmd.draw(cmd.object, cmd);
+	}
+
+	m_items.clear();
+}
+
+
+void RenderQueue::clear()
+{
+	m_items.clear();
+}
@@ -0,0 +1,80 @@
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include <vector>
+#include <cstddef>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "glstate.h"
+
+/**
+ * @brief File de draws d'une frame, triee par programme puis par VAO
+ *
+ * Chaque entree lie son programme et son VAO a travers GLState, puis
+ * appelle sa fonction de dessin (uniforms, EBO, draw call).
+ * L'ordre d'insertion est conserve a programme et VAO egaux.
+ *
+ * Les entrees sont des enregistrements simples (pointeur de fonction,
+ * objet et parametres du draw): pas d'allocation par draw.
+ */
+class OGLRENDER_API RenderQueue
+{
+public:
+	struct Command;
+
+	/// fonction de dessin (programme et VAO deja lies)
+	typedef void (*DrawFunc)(void* object, const Command& cmd);
+
+	/// un draw de la file
+	struct Command
+	{
+		GLuint program;
+		GLuint vao;
+		DrawFunc draw;
+		/// objet qui dessine (passe a draw)
+		void* object;
+		/// parametres libres du draw, interpretes par draw
+		glm::mat4 transfo;
+		glm::vec3 color;
+		int first;
+		int count;
+		int instances;
+		std::size_t offset;
+	};
+
+	RenderQueue();
+
+	/**
+	 * @brief commande sans parametre (transfo identite, couleur et plages nulles)
+	 * @param program programme utilise
+	 * @param vao VAO utilise
+	 * @param draw fonction de dessin
+	 * @param object objet passe a draw
+	 */
+	static Command command(GLuint program, GLuint vao, DrawFunc draw, void* object);
+
+	/**
+	 * @brief ajoute un draw
+	 * @param cmd commande (copiee)
+	 */
+	void push(const Command& cmd);
+
+	/**
+	 * @brief trie et execute les draws puis vide la file
+	 */
+	void flush();
+
+	/// vide la file sans dessiner
+	void clear();
+
+	inline std::size_t size() const		{ return m_items.size(); }
+
+	inline bool empty() const			{ return m_items.empty(); }
+
+protected:
+	std::vector<Command> m_items;
+};
+
+#endif // RENDERQUEUE_H
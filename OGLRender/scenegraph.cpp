@@ -0,0 +1,242 @@
+#include "scenegraph.h"
+
+#include <algorithm>
+
+
+SceneGraph::SceneGraph():
+	m_levels_dirty(false),
+	m_any_dirty(false),
+	m_threads(0),
+	m_job(0),
+	m_job_begin(0),
+	m_job_end(0),
+	m_chunk(1),
+	m_nb_chunks(0),
+	m_next_chunk(0),
+	m_chunks_done(0),
+	m_quit(false)
+{
+}
+
+
+SceneGraph::~SceneGraph()
+{
+	stop_workers();
+}
+
+
+int SceneGraph::add_node(int parent, const glm::mat4& local)
+{
+	const int id = int(m_parent.size());
+	m_parent.push_back(parent);
+	m_local.push_back(local);
+	m_world.push_back(local);
+	m_dirty.push_back(1);
+	m_depth.push_back(parent < 0 ? 0 : m_depth[parent]+1);
+	m_shape.push_back(-1);
+	m_slot.push_back(-1);
+	m_levels_dirty = true;
+	m_any_dirty = true;
+	return id;
+}
+
+
+int SceneGraph::add_shape(int parent, const glm::mat4& local, Primitives::Shape sh, const glm::vec3& color)
+{
+	const int id = add_node(parent, local);
+	m_shape[id] = sh;
+	m_slot[id] = int(m_draw_transfos[sh].size());
+	m_draw_transfos[sh].push_back(local);
+	m_draw_colors[sh].push_back(color);
+	return id;
+}
+
+
+void SceneGraph::set_local(int node, const glm::mat4& local)
+{
+	m_local[node] = local;
+	m_dirty[node] = 1;
+	m_any_dirty = true;
+}
+
+
+void SceneGraph::set_color(int node, const glm::vec3& color)
+{
+	if (m_shape[node] >= 0)
+		m_draw_colors[m_shape[node]][m_slot[node]] = color;
+}
+
+
+void SceneGraph::clear()
+{
+	m_parent.clear();
+	m_local.clear();
+	m_world.clear();
+	m_dirty.clear();
+	m_depth.clear();
+	m_shape.clear();
+	m_slot.clear();
+	m_order.clear();
+	m_level_begin.clear();
+	for (int i=0; i<Primitives::NB_SHAPES; ++i)
+	{
+		m_draw_transfos[i].clear();
+		m_draw_colors[i].clear();
+	}
+	m_levels_dirty = false;
+	m_any_dirty = false;
+}
+
+
+void SceneGraph::set_threads(unsigned int nb)
+{
+	m_threads = nb;
+}
+
+
+void SceneGraph::build_levels()
+{
+	// tri par comptage sur la profondeur (stable: l'ordre d'ajout est garde)
+	const int nb_levels = m_depth.empty() ? 0 : 1 + *std::max_element(m_depth.begin(), m_depth.end());
+	m_level_begin.assign(nb_levels+1, 0);
+	for (int d : m_depth)
+		++m_level_begin[d+1];
+	for (int l=0; l<nb_levels; ++l)
+		m_level_begin[l+1] += m_level_begin[l];
+
+	std::vector<std::size_t> pos(m_level_begin.begin(), m_level_begin.end()-1);
+	m_order.resize(m_depth.size());
+	for (std::size_t i=0; i<m_depth.size(); ++i)
+		m_order[pos[m_depth[i]]++] = int(i);
+
+	m_levels_dirty = false;
+}
+
+
+void SceneGraph::update_range(std::size_t b, std::size_t e)
+{
+	for (std::size_t k=b; k<e; ++k)
+	{
+		const int i = m_order[k];
+		const int p = m_parent[i];
+
+		// un parent modifie invalide tout son sous-arbre
+		if (p >= 0 && m_dirty[p])
+			m_dirty[i] = 1;
+		if (!m_dirty[i])
+			continue;
+
+		m_world[i] = (p >= 0) ? m_world[p] * m_local[i] : m_local[i];
+		if (m_shape[i] >= 0)
+			m_draw_transfos[m_shape[i]][m_slot[i]] = m_world[i];
+	}
+}
+
+
+void SceneGraph::start_workers(unsigned int nb)
+{
+	stop_workers();
+	m_quit = false;
+	for (unsigned int i=0; i<nb; ++i)
+		m_workers.push_back(std::thread(&SceneGraph::worker_loop, this));
+}
+
+
+void SceneGraph::stop_workers()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_pool_mutex);
+		m_quit = true;
+	}
+	m_work_ready.notify_all();
+	for (std::thread& t : m_workers)
+		t.join();
+	m_workers.clear();
+}
+
+
+void SceneGraph::worker_loop()
+{
+	unsigned long seen = 0;
+	std::unique_lock<std::mutex> lock(m_pool_mutex);
+	for (;;)
+	{
+		m_work_ready.wait(lock, [&] { return m_quit || m_job != seen; });
+		if (m_quit)
+			return;
+		seen = m_job;
+		run_chunks(lock);
+	}
+}
+
+
+void SceneGraph::run_chunks(std::unique_lock<std::mutex>& lock)
+{
+	// un thread en retard sur un niveau deja termine aide au niveau suivant:
+	// les paquets ne sont pris que sous le verrou
+	while (m_next_chunk < m_nb_chunks)
+	{
+		const std::size_t b = m_job_begin + (m_next_chunk++)*m_chunk;
+		const std::size_t e = std::min(b + m_chunk, m_job_end);
+		lock.unlock();
+		update_range(b, e);
+		lock.lock();
+		if (++m_chunks_done == m_nb_chunks)
+			m_work_done.notify_one();
+	}
+}
+
+
+void SceneGraph::update()
+{
+	if (!m_any_dirty)
+		return;
+	if (m_levels_dirty)
+		build_levels();
+
+	unsigned int nb_threads = m_threads;
+	if (nb_threads == 0)
+		nb_threads = std::max(1u, std::thread::hardware_concurrency());
+	if (m_workers.size() != nb_threads-1)
+		start_workers(nb_threads-1);
+
+	// les parents d'un niveau sont tous dans les niveaux precedents
+	for (std::size_t l=0; l+1<m_level_begin.size(); ++l)
+	{
+		const std::size_t b = m_level_begin[l];
+		const std::size_t e = m_level_begin[l+1];
+		const std::size_t n = e - b;
+
+		// un paquet par thread, sans descendre sous s_chunk_min noeuds
+		const std::size_t chunk = std::max(s_chunk_min, (n + nb_threads - 1) / nb_threads);
+		if (m_workers.empty() || n <= chunk)
+		{
+			update_range(b, e);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_pool_mutex);
+		m_job_begin = b;
+		m_job_end = e;
+		m_chunk = chunk;
+		m_nb_chunks = (n + chunk - 1) / chunk;
+		m_next_chunk = 0;
+		m_chunks_done = 0;
+		++m_job;
+		m_work_ready.notify_all();
+
+		run_chunks(lock);
+		m_work_done.wait(lock, [this] { return m_chunks_done == m_nb_chunks; });
+	}
+
+	std::fill(m_dirty.begin(), m_dirty.end(), 0);
+	m_any_dirty = false;
+}
+
+
+void SceneGraph::draw(Primitives& prim) const
+{
+	for (int i=0; i<Primitives::NB_SHAPES; ++i)
+		if (!m_draw_transfos[i].empty())
+			prim.draw_instances(Primitives::Shape(i), &m_draw_transfos[i][0], &m_draw_colors[i][0], m_draw_transfos[i].size());
+}
@@ -0,0 +1,154 @@
+#ifndef SCENEGRAPH_H
+#define SCENEGRAPH_H
+
+#include <vector>
+#include <cstddef>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <glm/glm.hpp>
+
+#include "primitives.h"
+
+/**
+ * @brief Hierarchie de noeuds (transfo locale) avec matrices monde en cache
+ *
+ * Les noeuds sont stockes dans des tableaux plats; un noeud est ajoute
+ * apres son parent. update() ne recalcule que les sous-arbres modifies
+ * (set_local), niveau par niveau: les niveaux sont decoupes en paquets
+ * repartis entre le thread appelant et des threads de travail
+ * persistants (crees au 1er update(), arretes par le destructeur).
+ * Les noeuds associes a une primitive ecrivent leur matrice monde
+ * directement dans des tableaux contigus par type, envoyes tels quels
+ * au rendu instancie de Primitives (draw()).
+ */
+class OGLRENDER_API SceneGraph
+{
+public:
+	SceneGraph();
+
+	/// arrete les threads de travail
+	~SceneGraph();
+
+	/**
+	 * @brief ajoute un noeud
+	 * @param parent noeud parent (-1: racine)
+	 * @param local transfo dans le repere du parent
+	 * @return identifiant du noeud
+	 */
+	int add_node(int parent, const glm::mat4& local);
+
+	/**
+	 * @brief ajoute un noeud dessine par une primitive
+	 * @param parent noeud parent (-1: racine)
+	 * @param local transfo dans le repere du parent
+	 * @param sh type de primitive
+	 * @param color couleur de rendu
+	 * @return identifiant du noeud
+	 */
+	int add_shape(int parent, const glm::mat4& local, Primitives::Shape sh, const glm::vec3& color);
+
+	/**
+	 * @brief modifie la transfo locale (le sous-arbre sera recalcule)
+	 * @param node identifiant du noeud
+	 * @param local transfo dans le repere du parent
+	 */
+	void set_local(int node, const glm::mat4& local);
+
+	/// couleur d'un noeud dessine
+	void set_color(int node, const glm::vec3& color);
+
+	inline const glm::mat4& local(int node) const	{ return m_local[node]; }
+
+	/// matrice monde (a jour apres update())
+	inline const glm::mat4& world(int node) const	{ return m_world[node]; }
+
+	/// recalcule les matrices monde des sous-arbres modifies
+	void update();
+
+	/**
+	 * @brief dessine les noeuds associes a une primitive (1 appel par type)
+	 * @param prim primitives (de preference en mode batch)
+	 */
+	void draw(Primitives& prim) const;
+
+	/// supprime tous les noeuds
+	void clear();
+
+	inline int nb_nodes() const { return int(m_parent.size()); }
+
+	/// nombre de threads de update(), appelant compris (0: nombre de coeurs)
+	void set_threads(unsigned int nb);
+
+protected:
+	/// met a jour les noeuds m_order[b..e[ (parents deja a jour)
+	void update_range(std::size_t b, std::size_t e);
+
+	/// range les noeuds par profondeur (apres ajout de noeuds)
+	void build_levels();
+
+	/// (re)lance nb threads de travail
+	void start_workers(unsigned int nb);
+
+	/// arrete et attend les threads de travail
+	void stop_workers();
+
+	/// boucle d'un thread de travail: traite les paquets de chaque niveau publie
+	void worker_loop();
+
+	/**
+	 * @brief traite les paquets restants du niveau courant
+	 * @param lock verrou de m_pool_mutex (pris a l'entree et a la sortie)
+	 */
+	void run_chunks(std::unique_lock<std::mutex>& lock);
+
+	/// nombre minimum de noeuds par paquet (en dessous le reveil coute plus que le calcul)
+	static const std::size_t s_chunk_min = 256;
+
+	std::vector<int> m_parent;
+	std::vector<glm::mat4> m_local;
+	std::vector<glm::mat4> m_world;
+	std::vector<unsigned char> m_dirty;
+	std::vector<int> m_depth;
+
+	/// primitive (-1: aucune) et place dans les tableaux de dessin
+	std::vector<int> m_shape;
+	std::vector<int> m_slot;
+
+	/// ordre de parcours: noeuds ranges par profondeur croissante
+	std::vector<int> m_order;
+	/// debut de chaque niveau dans m_order (+ la fin)
+	std::vector<std::size_t> m_level_begin;
+	bool m_levels_dirty;
+	/// au moins un noeud modifie depuis update()
+	bool m_any_dirty;
+
+	/// matrices monde et couleurs des noeuds dessines, par type de primitive
+	std::vector<glm::mat4> m_draw_transfos[Primitives::NB_SHAPES];
+	std::vector<glm::vec3> m_draw_colors[Primitives::NB_SHAPES];
+
+	unsigned int m_threads;
+
+	/// threads de travail (le thread appelant traite aussi des paquets)
+	std::vector<std::thread> m_workers;
+	/// niveau en cours: noeuds m_order[m_job_begin..m_job_end[ par paquets de m_chunk
+	/// (tout l'etat du travail est protege par m_pool_mutex)
+	std::mutex m_pool_mutex;
+	std::condition_variable m_work_ready;
+	std::condition_variable m_work_done;
+	unsigned long m_job;
+	std::size_t m_job_begin;
+	std::size_t m_job_end;
+	std::size_t m_chunk;
+	std::size_t m_nb_chunks;
+	std::size_t m_next_chunk;
+	std::size_t m_chunks_done;
+	bool m_quit;
+
+private:
+	SceneGraph(const SceneGraph&);
+	SceneGraph& operator=(const SceneGraph&);
+};
+
+#endif // SCENEGRAPH_H
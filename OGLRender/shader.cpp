@@ -8,14 +8,21 @@
 std::string* Shader::s_shaderPath=NULL;
 
 Shader::Shader(GLenum type)
+{
+	m_shaderId = glCreateShader(type);
+}
+
+
+const std::string& Shader::shaderPath()
 {
 	if (s_shaderPath==NULL)
 	{
-		s_shaderPath = new std::string(STRINGIFY(SHADERPATH));
-		std::cout << "SHADER PATH = " <<*s_shaderPath<< std::endl;
+		const char* dir = getenv("OGLRENDER_SHADER_DIR");
+		s_shaderPath = new std::string(dir ? dir : "");
+		if (!s_shaderPath->empty())
+			std::cout << "SHADER PATH = " <<*s_shaderPath<< std::endl;
 	}
-
-	m_shaderId = glCreateShader(type);
+	return *s_shaderPath;
 }
 
 
@@ -27,23 +34,63 @@ Shader::~Shader()
 
 
 /**
- * @brief Shader::compileShader
+ * @brief Shader::source
  * @param filename fichier source
+ * @param defines lignes inserees apres #version
  * @return
  */
-bool Shader::compileShader(const std::string& filename)
+std::string Shader::source(const std::string& filename, const std::string& defines)
 {
-	//Charge le fichier source
-	std::string src = readFileSrc(*s_shaderPath+'/'+filename);
-
+	// surcharge de developpement, sinon source embarquee (pas d'acces disque)
+	std::string src;
+	const char* code = embedded(filename);
+	if (!shaderPath().empty())
+		src = readFileSrc(shaderPath()+'/'+filename);
+	else if (code != nullptr)
+		src = code;
+	else
+		src = readFileSrc(std::string(STRINGIFY(SHADERPATH))+'/'+filename);
+
+	// defines apres la ligne #version (qui doit rester la 1ere)
+	if (!defines.empty())
+	{
+		std::size_t v = src.find("#version");
+		std::size_t eol = (v == std::string::npos) ? std::string::npos : src.find('\n', v);
+		std::size_t at = (eol == std::string::npos) ? 0 : eol+1;
+		src.insert(at, defines[defines.size()-1] == '\n' ? defines : defines+'\n');
+	}
 
-// # version 130 pour que ça marche en 2.1 sauf sur mac !
+// # version 140 pour que ça marche en 3.1 sauf sur mac (profil core: 330) !
 #ifdef __APPLE__
-	std::size_t k = src.find_first_of("130");
+	std::size_t k = src.find("#version 1");
 	if (k != std::string::npos)
-		src[k]='3';
+		src.replace(k, 12, "#version 330");
 #endif
 
+	return src;
+}
+
+
+/**
+ * @brief Shader::compileShader
+ * @param filename fichier source
+ * @param defines lignes inserees apres #version
+ * @return
+ */
+bool Shader::compileShader(const std::string& filename, const std::string& defines)
+{
+	return compileSource(source(filename, defines), filename);
+}
+
+
+/**
+ * @brief Shader::compileSource
+ * @param src code source
+ * @param name nom pour les messages
+ * @return
+ */
+bool Shader::compileSource(const std::string& src, const std::string& name)
+{
 	// envoit du code du shader au driver
 	const char *shaderSource = src.c_str();
 	glShaderSource(m_shaderId, 1, &shaderSource, NULL);
@@ -52,7 +99,7 @@ bool Shader::compileShader(const std::string& filename)
 	glCompileShader(m_shaderId);
 
 	// info de compilation
-	printInfoCompileShader(filename);
+	printInfoCompileShader(name);
 
 	return true;
 }
@@ -40,9 +40,28 @@ public:
 	/**
 	 * @brief compileShader
 	 * @param filename filename containing the source
+	 * @param defines lignes inserees apres #version (ex: "#define X 1\n")
 	 * @return
 	 */
-	bool compileShader(const std::string& filename);
+	bool compileShader(const std::string& filename, const std::string& defines = std::string());
+
+	/**
+	 * @brief compile une source deja lue (voir source())
+	 * @param src code source
+	 * @param name nom pour les messages d'erreur
+	 * @return
+	 */
+	bool compileSource(const std::string& src, const std::string& name);
+
+	/**
+	 * @brief source d'un shader prete a compiler (defines inseres)
+	 * Source embarquee dans la lib, sauf si $OGLRENDER_SHADER_DIR est defini
+	 * (developpement: fichiers relus a chaque creation de programme).
+	 * @param filename nom du fichier source
+	 * @param defines lignes inserees apres #version
+	 * @return le code source, vide si introuvable
+	 */
+	static std::string source(const std::string& filename, const std::string& defines = std::string());
 
 
 protected:
@@ -54,7 +73,17 @@ protected:
 	 * @param filename
 	 * @return
 	 */
-	std::string readFileSrc(const std::string& filename);
+	static std::string readFileSrc(const std::string& filename);
+
+	/**
+	 * @brief source embarquee a la compilation (table generee par OGLRender.pro)
+	 * @param filename nom du fichier source
+	 * @return le code source, nullptr si absent de la table
+	 */
+	static const char* embedded(const std::string& filename);
+
+	/// repertoire de surcharge ($OGLRENDER_SHADER_DIR), vide si non defini
+	static const std::string& shaderPath();
 
 	/**
 	 * @brief printInfoCompileShader
@@ -63,7 +92,7 @@ protected:
 	 */
 	bool printInfoCompileShader(const std::string& msg);
 
-	/// path for shader source file reading in static
+	/// path for shader source file overriding, in static
 	static std::string* s_shaderPath;
 };
 
@@ -1,12 +1,16 @@
 #include "shaderprogram.h"
+#include "programcache.h"
 
 
 
 ShaderProgram::ShaderProgram():
+	idOfModelMatrix(-1),
+	idOfNormalMatrix(-1),
     m_vertShader(NULL),
     m_fragShader(NULL)
 {
 	m_programId = glCreateProgram();
+	CameraUniforms::acquire();
 }
 
 
@@ -17,7 +21,9 @@ ShaderProgram::~ShaderProgram()
     if (m_fragShader)
         delete m_fragShader;
 
+	GLState::forgetProgram(m_programId);
 	glDeleteProgram(m_programId);
+	CameraUniforms::release();
 }
 
 
@@ -44,22 +50,42 @@ bool ShaderProgram::printInfoLinkProgram()
 }
 
 
-void ShaderProgram::load(const std::string& vert_name, const std::string& frag_name)
+void ShaderProgram::load(const std::string& vert_name, const std::string& frag_name, const std::string& defines)
 {
+    const std::string vert_src = Shader::source(vert_name, defines);
+    const std::string frag_src = Shader::source(frag_name, defines);
+
+    // binaire deja lie par un lancement precedent: pas de compilation
+    const std::string key = ProgramCache::key(vert_src, frag_src);
+    if (ProgramCache::load(m_programId, key))
+    {
+        CameraUniforms::attach(m_programId);
+        return;
+    }
+
     //Création du vertex shader
     m_vertShader = new Shader(GL_VERTEX_SHADER);
-    m_vertShader->compileShader(vert_name);
+    m_vertShader->compileSource(vert_src, vert_name);
 
     //Création du fragment shader
     m_fragShader = new Shader(GL_FRAGMENT_SHADER);
-    m_fragShader->compileShader(frag_name);
+    m_fragShader->compileSource(frag_src, frag_name);
 
     //Attachement des shaders au programme et link
     glAttachShader(m_programId, m_vertShader->shaderId());
     glAttachShader(m_programId, m_fragShader->shaderId());
+    ProgramCache::prepare(m_programId);
     glLinkProgram(m_programId);
     // puis detache (?)
     glDetachShader(m_programId, m_fragShader->shaderId());
     glDetachShader(m_programId, m_vertShader->shaderId());
-}
 
+    GLint linked = GL_FALSE;
+    glGetProgramiv(m_programId, GL_LINK_STATUS, &linked);
+    if (linked == GL_TRUE)
+        ProgramCache::save(m_programId, key);
+    else
+        printInfoLinkProgram();
+
+    CameraUniforms::attach(m_programId);
+}
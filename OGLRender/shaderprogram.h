@@ -3,6 +3,7 @@
 
 #include <iostream>
 #include <string>
+#include <cmath>
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
@@ -11,6 +12,8 @@
 #include <glm/gtc/matrix_inverse.hpp>
 
 #include "shader.h"
+#include "glstate.h"
+#include "camerauniforms.h"
 
 
 
@@ -20,38 +23,53 @@ class OGLRENDER_API ShaderProgram
 public:
     ShaderProgram();
 
-    ~ShaderProgram();
+    virtual ~ShaderProgram();
 
 	GLuint programId() const				{ return m_programId; }
 	Shader* vertShader() const				{ return m_vertShader; }
 	Shader* fragShader() const				{ return m_fragShader; }
 
-    inline void startUseProgram()					{ glUseProgram(m_programId); }
-    inline void stopUseProgram()					{ glUseProgram(0);	}
+	/// liaisons a travers GLState (changements redondants evites)
+    inline void startUseProgram()					{ GLState::useProgram(m_programId); }
+    inline void stopUseProgram()					{ GLState::releaseProgram(); }
 
-	inline void sendViewMatrix(const glm::mat4& viewMatrix)
+	/**
+	 * @brief matrices de camera (bloc Camera, partage par tous les programmes)
+	 * envoyees seulement si elles ont change depuis le dernier appel
+	 */
+	inline void sendCamera(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix)
 	{
-		glUniformMatrix4fv(idOfViewMatrix, 1, GL_FALSE, glm::value_ptr(viewMatrix));
+		CameraUniforms::bind(viewMatrix, projectionMatrix);
+	}
+
+	/// matrice de l'objet (et matrice des normales si le programme en a une)
+	inline void sendModelMatrix(const glm::mat4& modelMatrix)
+	{
+		GLState::uniformMatrix4fv(idOfModelMatrix, glm::value_ptr(modelMatrix));
 		if (idOfNormalMatrix >= 0)
 		{
-			glm::mat4 nm = glm::inverseTranspose(viewMatrix);
-			glUniformMatrix4fv(idOfNormalMatrix, 1, GL_FALSE, glm::value_ptr(nm));
+			// rotation*echelle uniforme: la normale renormalisee est deja juste
+			glm::mat3 nm(modelMatrix);
+			if (!uniformScale(nm))
+				nm = glm::inverseTranspose(nm);
+			GLState::uniformMatrix3fv(idOfNormalMatrix, glm::value_ptr(nm));
 		}
 	}
 
-	inline void sendProjectionMatrix(const glm::mat4& projectionMatrix)
+	/// colonnes orthogonales et de meme norme
+	static inline bool uniformScale(const glm::mat3& m)
 	{
-		glUniformMatrix4fv(idOfProjectionMatrix, 1, GL_FALSE, glm::value_ptr(projectionMatrix));
+		const float l0 = glm::dot(m[0],m[0]);
+		const float eps = 1e-5f * l0;
+		return std::abs(glm::dot(m[1],m[1]) - l0) <= eps && std::abs(glm::dot(m[2],m[2]) - l0) <= eps
+			&& std::abs(glm::dot(m[0],m[1])) <= eps && std::abs(glm::dot(m[0],m[2])) <= eps && std::abs(glm::dot(m[1],m[2])) <= eps;
 	}
 
 
-	/// uniform id pour matrice de projection
-	GLint idOfProjectionMatrix;
-
-	/// uniform id pour matrice de model-view
-	GLint idOfViewMatrix;
+	/// uniform id pour matrice de l'objet
+	GLint idOfModelMatrix;
 
-	/// uniform id pour matrice de normal
+	/// uniform id pour matrice des normales (mat3)
 	GLint idOfNormalMatrix;
 
 protected:
@@ -67,8 +85,9 @@ protected:
      * @brief load & compile shaders
      * @param vert_name vertex shader file name
      * @param frag_name fragment shader file name
+     * @param defines lignes "#define ..." inserees dans les 2 shaders
      */
-    void load(const std::string& vert_name, const std::string& frag_name);
+    void load(const std::string& vert_name, const std::string& frag_name, const std::string& defines = std::string());
 
 
 };
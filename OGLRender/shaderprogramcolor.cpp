@@ -1,14 +1,13 @@
 #include "shaderprogramcolor.h"
 
 
-ShaderProgramColor::ShaderProgramColor()
+ShaderProgramColor::ShaderProgramColor(const std::string& defines)
 {
     // load & compile & link shaders
-	load("colorshader.vert","colorshader.frag");
+	load("colorshader.vert","colorshader.frag", defines);
 
     // get id of uniforms
-    idOfProjectionMatrix = glGetUniformLocation(m_programId, "projectionMatrix");
-    idOfViewMatrix = glGetUniformLocation(m_programId, "viewMatrix");
+    idOfModelMatrix = glGetUniformLocation(m_programId, "modelMatrix");
 
     // get id of attribute
     idOfVertexAttribute = glGetAttribLocation(m_programId, "vertex_in");
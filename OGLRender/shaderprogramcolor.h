@@ -17,7 +17,8 @@ public:
 
 	GLint idOfColorUniform;
 
-    ShaderProgramColor();
+    /// defines: lignes "#define ..." inserees apres #version
+    explicit ShaderProgramColor(const std::string& defines = std::string());
 };
 
 #endif
@@ -0,0 +1,15 @@
+#include "shaderprogramcolorinstanced.h"
+
+ShaderProgramColorInstanced::ShaderProgramColorInstanced(const std::string& defines)
+{
+	// load & compile & link shaders
+	load("colorinstshader.vert","colorinstshader.frag", defines);
+
+	// get id of uniforms
+	// matrices de camera: bloc Camera (attache dans load)
+	idOfColorUniform = glGetUniformLocation(m_programId, "color");
+
+	// get id of attributes
+	idOfVertexAttribute = glGetAttribLocation(m_programId, "vertex_in");
+	idOfTransfoAttribute = glGetAttribLocation(m_programId, "transfo_in");
+}
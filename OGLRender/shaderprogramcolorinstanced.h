@@ -0,0 +1,27 @@
+#ifndef SHADERPROGRAMCOLORINSTANCED_H
+#define SHADERPROGRAMCOLORINSTANCED_H
+
+#include "shaderprogram.h"
+
+/**
+ * @brief rendu couleur unie d'instances: la matrice de transfo
+ * est un attribut par instance (glVertexAttribDivisor)
+ */
+class OGLRENDER_API ShaderProgramColorInstanced: public ShaderProgram
+{
+public:
+
+	/// attribute id
+	GLint idOfVertexAttribute;
+
+	/// attribute id de la matrice (occupe 4 locations consecutives)
+	GLint idOfTransfoAttribute;
+
+	GLint idOfColorUniform;
+
+	/// defines: lignes "#define ..." inserees apres #version
+	explicit ShaderProgramColorInstanced(const std::string& defines = std::string());
+
+};
+
+#endif // SHADERPROGRAMCOLORINSTANCED_H
@@ -1,13 +1,12 @@
 #include "shaderprogramflat.h"
 
-ShaderProgramFlat::ShaderProgramFlat()
+ShaderProgramFlat::ShaderProgramFlat(const std::string& defines)
 {
 	// load & compile & link shaders
-	load("flatshader.vert","flatshader.frag");
+	load("flatshader.vert","flatshader.frag", defines);
 
 	// get id of uniforms
-	idOfProjectionMatrix = glGetUniformLocation(m_programId, "projectionMatrix");
-	idOfViewMatrix = glGetUniformLocation(m_programId, "viewMatrix");
+	idOfModelMatrix = glGetUniformLocation(m_programId, "modelMatrix");
 
 	// get id of attribute
 	idOfVertexAttribute = glGetAttribLocation(m_programId, "vertex_in");
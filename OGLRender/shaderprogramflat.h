@@ -13,7 +13,8 @@ public:
 	GLint idOfColorUniform;
 	GLint idOfBColorUniform;
 
-	ShaderProgramFlat();
+	/// defines: lignes "#define ..." inserees apres #version
+	explicit ShaderProgramFlat(const std::string& defines = std::string());
 
 };
 
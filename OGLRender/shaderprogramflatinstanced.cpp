@@ -0,0 +1,15 @@
+#include "shaderprogramflatinstanced.h"
+
+ShaderProgramFlatInstanced::ShaderProgramFlatInstanced(const std::string& defines)
+{
+	// load & compile & link shaders
+	load("flatinstshader.vert","flatinstshader.frag", defines);
+
+	// get id of uniforms
+	// matrices de camera: bloc Camera (attache dans load)
+
+	// get id of attributes
+	idOfVertexAttribute = glGetAttribLocation(m_programId, "vertex_in");
+	idOfTransfoAttribute = glGetAttribLocation(m_programId, "transfo_in");
+	idOfColorAttribute = glGetAttribLocation(m_programId, "color_in");
+}
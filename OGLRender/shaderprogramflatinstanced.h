@@ -0,0 +1,27 @@
+#ifndef SHADERPROGRAMFLATINSTANCED_H
+#define SHADERPROGRAMFLATINSTANCED_H
+
+#include "shaderprogram.h"
+
+/**
+ * @brief rendu flat d'instances: matrice de transfo et couleur
+ * sont des attributs par instance (glVertexAttribDivisor)
+ */
+class OGLRENDER_API ShaderProgramFlatInstanced: public ShaderProgram
+{
+public:
+
+	/// attribute id
+	GLint idOfVertexAttribute;
+
+	/// attribute id de la matrice (occupe 4 locations consecutives)
+	GLint idOfTransfoAttribute;
+
+	GLint idOfColorAttribute;
+
+	/// defines: lignes "#define ..." inserees apres #version
+	explicit ShaderProgramFlatInstanced(const std::string& defines = std::string());
+
+};
+
+#endif // SHADERPROGRAMFLATINSTANCED_H
@@ -1,13 +1,12 @@
 #include "shaderprogramphong.h"
 
-ShaderProgramPhong::ShaderProgramPhong()
+ShaderProgramPhong::ShaderProgramPhong(const std::string& defines)
 {
 	// load & compile & link shaders
-	load("phongshader.vert","phongshader.frag");
+	load("phongshader.vert","phongshader.frag", defines);
 
 	// get id of uniforms
-	idOfProjectionMatrix = glGetUniformLocation(m_programId, "projectionMatrix");
-	idOfViewMatrix = glGetUniformLocation(m_programId, "viewMatrix");
+	idOfModelMatrix = glGetUniformLocation(m_programId, "modelMatrix");
 	idOfNormalMatrix = glGetUniformLocation(m_programId, "normalMatrix");
 
 	// get id of attribute
@@ -15,7 +15,8 @@ public:
 	GLint idOfColorUniform;
 	GLint idOfBColorUniform;
 
-	ShaderProgramPhong();
+	/// defines: lignes "#define ..." inserees apres #version
+	explicit ShaderProgramPhong(const std::string& defines = std::string());
 };
 
 #endif // SHADERPROGRAMPHONG_H
@@ -0,0 +1,86 @@
+#include "shaderprogramregistry.h"
+
+#include <map>
+#include <sstream>
+
+#include <QOpenGLContext>
+
+
+namespace
+{
+	struct Entry
+	{
+		ShaderProgram* program;
+		int references;
+	};
+
+	std::map<std::string, Entry>& entries()
+	{
+		static std::map<std::string, Entry> e;
+		return e;
+	}
+}
+
+
+std::string ShaderProgramRegistry::key(const char* type, const std::string& defines)
+{
+	// un programme n'est valide que dans les contextes qui partagent leurs objets
+	QOpenGLContext* ctx = QOpenGLContext::currentContext();
+	std::ostringstream k;
+	k << static_cast<const void*>(ctx != NULL ? ctx->shareGroup() : NULL) << '\n' << type << '\n' << defines;
+	return k.str();
+}
+
+
+ShaderProgram* ShaderProgramRegistry::find(const std::string& k)
+{
+	auto it = entries().find(k);
+	if (it == entries().end())
+		return NULL;
+	++it->second.references;
+	return it->second.program;
+}
+
+
+void ShaderProgramRegistry::insert(const std::string& k, ShaderProgram* program)
+{
+	Entry e;
+	e.program = program;
+	e.references = 1;
+	entries()[k] = e;
+}
+
+
+void ShaderProgramRegistry::release(ShaderProgram* program)
+{
+	if (program == NULL)
+		return;
+
+	auto& e = entries();
+	for (auto it = e.begin(); it != e.end(); ++it)
+	{
+		if (it->second.program != program)
+			continue;
+		if (--it->second.references == 0)
+		{
+			delete it->second.program;
+			e.erase(it);
+		}
+		return;
+	}
+}
+
+
+std::size_t ShaderProgramRegistry::size()
+{
+	return entries().size();
+}
+
+
+int ShaderProgramRegistry::references(const ShaderProgram* program)
+{
+	for (const auto& kv : entries())
+		if (kv.second.program == program)
+			return kv.second.references;
+	return 0;
+}
@@ -0,0 +1,60 @@
+#ifndef SHADERPROGRAMREGISTRY_H
+#define SHADERPROGRAMREGISTRY_H
+
+#include <string>
+#include <typeinfo>
+
+#include "shaderprogram.h"
+
+/**
+ * @brief Programmes partages, comptes par reference
+ *
+ * Un programme est identifie par son type (ShaderProgramFlat, ...), ses
+ * defines et le groupe de contextes partages courant: il n'est compile
+ * qu'une fois quel que soit le nombre de maillages/viewers qui l'utilisent,
+ * et detruit au dernier release().
+ */
+class OGLRENDER_API ShaderProgramRegistry
+{
+public:
+	/**
+	 * @brief programme de type T (cree au 1er appel)
+	 * @param defines lignes "#define ..." passees au constructeur de T
+	 * @return le programme partage (a rendre avec release)
+	 */
+	template <typename T>
+	static T* acquire(const std::string& defines = std::string())
+	{
+		const std::string k = key(typeid(T).name(), defines);
+		ShaderProgram* p = find(k);
+		if (p == NULL)
+		{
+			p = new T(defines);
+			insert(k, p);
+		}
+		return static_cast<T*>(p);
+	}
+
+	/**
+	 * @brief rend un programme obtenu par acquire (NULL accepte)
+	 * detruit au dernier release: le contexte GL doit etre courant
+	 */
+	static void release(ShaderProgram* program);
+
+	/// nombre de programmes vivants
+	static std::size_t size();
+
+	/// nombre d'utilisateurs d'un programme (0 s'il n'est pas dans le registre)
+	static int references(const ShaderProgram* program);
+
+protected:
+	static std::string key(const char* type, const std::string& defines);
+
+	/// programme de cle k, reference +1 (NULL s'il n'existe pas)
+	static ShaderProgram* find(const std::string& k);
+
+	/// nouveau programme, 1 reference
+	static void insert(const std::string& k, ShaderProgram* program);
+};
+
+#endif // SHADERPROGRAMREGISTRY_H
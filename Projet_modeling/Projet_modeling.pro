@@ -28,10 +28,8 @@ LIBS += -L$$_PRO_FILE_PWD_/../bin -lOGLRender -lQGLViewer33 -lopengl32
 
 SOURCES += main.cpp \
     viewer.cpp \
-primitives.cpp \
 meshquad.cpp
 
 HEADERS  += viewer.h \
     matrices.h \
-primitives.h \
     meshquad.h
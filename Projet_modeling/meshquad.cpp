@@ -1,18 +1,32 @@
 #include "meshquad.h"
 #include "matrices.h"
+#include <OGLRender/batchmath.h>
 #include <QDebug>
+#include <algorithm>
 
 MeshQuad::MeshQuad():
-	m_nb_ind_edges(0)
+	m_shader_flat(NULL),
+	m_shader_color(NULL),
+	m_nb_ind_edges(0),
+	m_bs_radius(0.0f),
+	m_batch(NULL),
+	m_batch_id(-1),
+	m_batch_dirty(false)
 {
 
 }
 
+MeshQuad::~MeshQuad()
+{
+	ShaderProgramRegistry::release(m_shader_flat);
+	ShaderProgramRegistry::release(m_shader_color);
+}
+
 
 void MeshQuad::gl_init()
 {
-    m_shader_flat = new ShaderProgramFlat();
-	m_shader_color = new ShaderProgramColor();
+    m_shader_flat = ShaderProgramRegistry::acquire<ShaderProgramFlat>();
+	m_shader_color = ShaderProgramRegistry::acquire<ShaderProgramColor>();
 
 	//VBO
 	glGenBuffers(1, &m_vbo);
@@ -48,27 +62,45 @@ void MeshQuad::gl_update()
         glBindBuffer(GL_ARRAY_BUFFER, 0);
     }
 
-    std::vector<int> tri_indices;
-    convert_quads_to_tris(m_quad_indices,tri_indices);
+    convert_quads_to_tris(m_quad_indices,m_tri_indices);
 
     //EBO indices
-    if (!tri_indices.empty())
+    if (!m_tri_indices.empty())
     {
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER,tri_indices.size() * sizeof(int), &(tri_indices[0]), GL_STATIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER,m_tri_indices.size() * sizeof(int), &(m_tri_indices[0]), GL_STATIC_DRAW);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     }
 
-    std::vector<int> edge_indices;
-    convert_quads_to_edges(m_quad_indices,edge_indices);
-    m_nb_ind_edges = edge_indices.size();
+    convert_quads_to_edges(m_quad_indices,m_edge_indices);
+    m_nb_ind_edges = m_edge_indices.size();
 
     if (m_nb_ind_edges > 0)
     {
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo2);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER,m_nb_ind_edges * sizeof(int), &(edge_indices[0]), GL_STATIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER,m_nb_ind_edges * sizeof(int), &(m_edge_indices[0]), GL_STATIC_DRAW);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     }
+
+    // sphere englobante (centre de la boite englobante)
+    m_bs_center = Vec3(0,0,0);
+    m_bs_radius = 0.0f;
+    if (!m_points.empty())
+    {
+        Vec3 bmin, bmax;
+        BatchMath::aabb(m_points.data(), m_points.size(), bmin, bmax);
+        m_bs_center = 0.5f*(bmin+bmax);
+        for (const Vec3& P : m_points)
+            m_bs_radius = std::max(m_bs_radius, glm::length(P-m_bs_center));
+    }
+
+    m_batch_dirty = true;
+}
+
+void MeshQuad::add_as_occluder(OcclusionBuffer& occlusion) const
+{
+    if (!m_tri_indices.empty())
+        occlusion.add_occluder(&m_points[0], &m_tri_indices[0], m_tri_indices.size());
 }
 
 void MeshQuad::set_matrices(const Mat4& view, const Mat4& projection)
@@ -79,33 +111,71 @@ void MeshQuad::set_matrices(const Mat4& view, const Mat4& projection)
 
 void MeshQuad::draw(const Vec3& color)
 {
+	m_shader_flat->startUseProgram();
+	GLState::bindVertexArray(m_vao);
+	draw_fill(color);
+
+	m_shader_color->startUseProgram();
+	GLState::bindVertexArray(m_vao2);
+	draw_edges();
+	m_shader_color->stopUseProgram();
+}
+
+void MeshQuad::submit(RenderQueue& queue, const Vec3& color)
+{
+	RenderQueue::Command fill = RenderQueue::command(m_shader_flat->programId(), m_vao, &MeshQuad::queued_fill, this);
+	fill.color = color;
+	queue.push(fill);
+	queue.push(RenderQueue::command(m_shader_color->programId(), m_vao2, &MeshQuad::queued_edges, this));
+}
 
+void MeshQuad::queued_fill(void* mesh, const RenderQueue::Command& cmd)
+{
+	static_cast<MeshQuad*>(mesh)->draw_fill(cmd.color);
+}
+
+void MeshQuad::queued_edges(void* mesh, const RenderQueue::Command&)
+{
+	static_cast<MeshQuad*>(mesh)->draw_edges();
+}
+
+void MeshQuad::submit(MeshBatch& batch, const Vec3& color)
+{
+	if (m_batch != &batch)
+	{
+		m_batch = &batch;
+		m_batch_id = batch.add_mesh(m_points, m_tri_indices, m_edge_indices);
+	}
+	else if (m_batch_dirty)
+		batch.set_mesh(m_batch_id, m_points, m_tri_indices, m_edge_indices);
+	m_batch_dirty = false;
+
+	batch.draw(m_batch_id, Mat4(), color);
+}
+
+void MeshQuad::draw_fill(const Vec3& color)
+{
 	glEnable(GL_POLYGON_OFFSET_FILL);
 	glPolygonOffset(1.0f, 1.0f);
 
-	m_shader_flat->startUseProgram();
-	m_shader_flat->sendViewMatrix(viewMatrix);
-	m_shader_flat->sendProjectionMatrix(projectionMatrix);
-	glUniform3fv(m_shader_flat->idOfColorUniform, 1, glm::value_ptr(color));
-	glBindVertexArray(m_vao);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,m_ebo);
-	glDrawElements(GL_TRIANGLES, 3*m_quad_indices.size()/2,GL_UNSIGNED_INT,0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,0);
-	glBindVertexArray(0);
-	m_shader_flat->stopUseProgram();
+	m_shader_flat->sendCamera(viewMatrix, projectionMatrix);
+	m_shader_flat->sendModelMatrix(Mat4());
+	GLState::uniform3fv(m_shader_flat->idOfColorUniform, glm::value_ptr(color));
+	GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER,m_ebo);
+	GLState::drawElements(GL_TRIANGLES, 3*m_quad_indices.size()/2,GL_UNSIGNED_INT,0);
 
 	glDisable(GL_POLYGON_OFFSET_FILL);
+}
 
-	m_shader_color->startUseProgram();
-	m_shader_color->sendViewMatrix(viewMatrix);
-	m_shader_color->sendProjectionMatrix(projectionMatrix);
-	glUniform3f(m_shader_color->idOfColorUniform, 0.0f,0.0f,0.0f);
-	glBindVertexArray(m_vao2);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,m_ebo2);
-	glDrawElements(GL_LINES, m_nb_ind_edges,GL_UNSIGNED_INT,0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,0);
-	glBindVertexArray(0);
-	m_shader_color->stopUseProgram();
+void MeshQuad::draw_edges()
+{
+	const Vec3 noir(0.0f,0.0f,0.0f);
+
+	m_shader_color->sendCamera(viewMatrix, projectionMatrix);
+	m_shader_color->sendModelMatrix(Mat4());
+	GLState::uniform3fv(m_shader_color->idOfColorUniform, glm::value_ptr(noir));
+	GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER,m_ebo2);
+	GLState::drawElements(GL_LINES, m_nb_ind_edges,GL_UNSIGNED_INT,0);
 }
 
 void MeshQuad::clear()
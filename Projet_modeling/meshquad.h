@@ -4,6 +4,10 @@
 #include <vector>
 #include <OGLRender/shaderprogramflat.h>
 #include <OGLRender/shaderprogramcolor.h>
+#include <OGLRender/shaderprogramregistry.h>
+#include <OGLRender/renderqueue.h>
+#include <OGLRender/culling.h>
+#include <OGLRender/meshbatch.h>
 
 #include <matrices.h>
 
@@ -31,9 +35,36 @@ class MeshQuad
 	/// nombre d'aretes
 	int m_nb_ind_edges;
 
+	/// indices de triangles et d'aretes, maj par gl_update
+	std::vector<int> m_tri_indices;
+	std::vector<int> m_edge_indices;
+
+	/// lot partage ou le maillage est range (submit(MeshBatch&))
+	MeshBatch* m_batch;
+	int m_batch_id;
+	/// maillage modifie depuis le dernier envoi au lot
+	bool m_batch_dirty;
+
+	/// sphere englobante, maj par gl_update
+	Vec3 m_bs_center;
+	float m_bs_radius;
+
+	/// dessin des faces (programme flat et m_vao lies)
+	void draw_fill(const Vec3& color);
+
+	/// dessin des aretes (programme color et m_vao2 lies)
+	void draw_edges();
+
+	/// draws de la file de rendu (cmd.color: couleur des faces)
+	static void queued_fill(void* mesh, const RenderQueue::Command& cmd);
+	static void queued_edges(void* mesh, const RenderQueue::Command& cmd);
+
 public:
     MeshQuad();
 
+	/// rend les programmes au registre (contexte GL courant)
+	~MeshQuad();
+
     inline int nb_quads() const { return m_quad_indices.size()/4;}
 
 	inline int nb_edges() const { return m_nb_ind_edges/2;}
@@ -62,6 +93,33 @@ public:
 	 */
 	void draw(const Vec3& color);
 
+	/**
+	 * @brief ajoute le dessin du maillage (faces + aretes) a une file de rendu
+	 * @param queue file de rendu de la frame
+	 * @param color couleur de rendu
+	 */
+	void submit(RenderQueue& queue, const Vec3& color);
+
+	/**
+	 * @brief dessine le maillage (faces + aretes) a travers un lot partage
+	 * (le maillage y est range au 1er appel et apres chaque modification)
+	 * @param batch lot de la scene
+	 * @param color couleur de rendu
+	 */
+	void submit(MeshBatch& batch, const Vec3& color);
+
+	/// centre de la sphere englobante
+	inline const Vec3& bounding_center() const { return m_bs_center; }
+
+	/// rayon de la sphere englobante
+	inline float bounding_radius() const { return m_bs_radius; }
+
+	/**
+	 * @brief rasterise les faces du maillage dans un tampon d'occlusion
+	 * @param occlusion tampon de la frame (begin() deja appele)
+	 */
+	void add_as_occluder(OcclusionBuffer& occlusion) const;
+
 	/**
 	 * @brief nettoyage des donnees
 	 */
@@ -3,6 +3,7 @@
 #include <QGLViewer/vec.h>
 
 #include <QKeyEvent>
+#include <glm/gtc/type_ptr.hpp>
 #include <iomanip>
 #include <QDebug>
 
@@ -18,10 +19,19 @@ Viewer::Viewer():
 	BLANC(1,1,1),
 	GRIS(0.5,0.5,0.5),
 	NOIR(0,0,0),
+	m_frustum_version(0),
+	m_occlusion_on(false),
+	m_use_batch(false),
 	m_selected_quad(-1)
 {}
 
 
+Viewer::~Viewer()
+{
+	makeCurrent();
+}
+
+
 void Viewer::init()
 {
 	makeCurrent();
@@ -48,6 +58,7 @@ void Viewer::init()
 	m_prim.gl_init();
 
 	m_mesh.gl_init();
+	m_batch.gl_init();
 }
 
 
@@ -70,13 +81,55 @@ void Viewer::draw_repere(const Mat4& global)
 void Viewer::draw()
 {
 	makeCurrent();
+	GLState::begin_frame();
 
 	m_mesh.set_matrices(getCurrentModelViewMatrix(),getCurrentProjectionMatrix());
 	m_prim.set_matrices(getCurrentModelViewMatrix(),getCurrentProjectionMatrix());
 
-	m_mesh.draw(CYAN);
+	// culling: pyramide de vision de la camera (repere monde), recalculee si la camera a bouge
+	if (camera()->matricesVersion() != m_frustum_version)
+	{
+		m_frustum_version = camera()->matricesVersion();
+		GLdouble coef[6][4];
+		camera()->getFrustumPlanesCoefficients(coef);
+		m_frustum.set_planes(coef);
+	}
+
+	const bool mesh_visible = m_frustum.visible(m_mesh.bounding_center(), m_mesh.bounding_radius());
+	GLState::countCulling(1, mesh_visible ? 0 : 1, 0);
+
+	// le maillage cache les primitives situees derriere lui
+	if (m_occlusion_on && mesh_visible)
+	{
+		m_occlusion.begin(getCurrentProjectionMatrix()*getCurrentModelViewMatrix());
+		m_mesh.add_as_occluder(m_occlusion);
+		m_occlusion.build_hiz();
+		m_prim.set_culling(&m_frustum, &m_occlusion);
+	}
+	else
+		m_prim.set_culling(&m_frustum);
+
+	// maillage et primitives dans la meme file: tri par programme/VAO
+	if (mesh_visible && m_use_batch)
+	{
+		m_batch.set_matrices(getCurrentModelViewMatrix(),getCurrentProjectionMatrix());
+		m_mesh.submit(m_batch, CYAN);
+		m_batch.set_queue(&m_queue);
+		m_batch.flush();
+		m_batch.set_queue(NULL);
+	}
+	else if (mesh_visible)
+		m_mesh.submit(m_queue, CYAN);
 
+	m_prim.set_queue(&m_queue);
+	m_prim.begin_batch();
 	draw_repere(m_selected_frame);
+	m_prim.end_batch();
+	m_prim.set_queue(NULL);
+
+	m_queue.flush();
+
+	GLState::end_frame();
 }
 
 
@@ -208,6 +261,22 @@ void Viewer::keyPressEvent(QKeyEvent *event)
                 }
             }
 
+		// dessin du maillage par lot partage on/off
+		case Qt::Key_I:
+			m_use_batch = !m_use_batch;
+			qDebug() << "lot partage :" << (m_use_batch ? "on" : "off") << (m_batch.multi_draw() ? "(multi-draw indirect)" : "(boucle CPU)");
+			break;
+
+		// occlusion des primitives par le maillage on/off
+		case Qt::Key_O:
+		{
+			m_occlusion_on = !m_occlusion_on;
+			const GLState::Stats& st = GLState::stats();
+			qDebug() << "occlusion :" << (m_occlusion_on ? "on" : "off") << "- rejetes" << st.frustumCulled << "(champ)" << st.occlusionCulled << "(occlusion) sur" << st.objectsTested;
+			GLState::resetStats();
+			break;
+		}
+
 		default:
 			break;
 	}
@@ -245,27 +314,12 @@ void Viewer::mousePressEvent(QMouseEvent* event)
 
 Mat4 Viewer::getCurrentModelViewMatrix() const
 {
-	GLdouble gl_mvm[16];
-	camera()->getModelViewMatrix(gl_mvm);
-	Mat4 mvm;
-	for(unsigned int i = 0; i < 4; ++i)
-	{
-		for(unsigned int j = 0; j < 4; ++j)
-			mvm[i][j] = float(gl_mvm[i*4+j]);
-	}
-	return mvm;
+	// copie de la matrice float en cache dans la camera (pas de conversion)
+	return glm::make_mat4(camera()->modelViewMatrixf());
 }
 
 
 Mat4 Viewer::getCurrentProjectionMatrix() const
 {
-	GLdouble gl_pm[16];
-	camera()->getProjectionMatrix(gl_pm);
-	Mat4 pm;
-	for(unsigned int i = 0; i < 4; ++i)
-	{
-		for(unsigned int j = 0; j < 4; ++j)
-			pm[i][j] = float(gl_pm[i*4+j]);
-	}
-	return pm;
+	return glm::make_mat4(camera()->projectionMatrixf());
 }
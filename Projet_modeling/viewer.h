@@ -4,9 +4,10 @@
 #include <GL/glew.h>
 #include <QGLViewer/qglviewer.h>
 #include <OGLRender/shaderprogramcolor.h>
+#include <OGLRender/glstate.h>
+#include <OGLRender/primitives.h>
 
 #include <matrices.h>
-#include <primitives.h>
 #include <meshquad.h>
 
 
@@ -22,6 +23,9 @@ class Viewer : public QGLViewer
 public:
     Viewer();
 
+	/// contexte GL courant pendant la destruction des membres (programmes partages)
+	~Viewer();
+
 protected:
 	/// OpenGL intialisation appelee par la QGLViewer
     void init();
@@ -58,6 +62,20 @@ protected:
 
 	Primitives m_prim;
 
+	/// file de rendu de la frame
+	RenderQueue m_queue;
+
+	/// culling: pyramide de vision et occlusion par le maillage (touche O)
+	Frustum m_frustum;
+	/// version des matrices de la camera lors du calcul de m_frustum
+	unsigned long m_frustum_version;
+	OcclusionBuffer m_occlusion;
+	bool m_occlusion_on;
+
+	/// maillage dessine a travers un lot partage (multi-draw indirect, touche I)
+	MeshBatch m_batch;
+	bool m_use_batch;
+
     /// compteur animation
 	int m_compteur;
 
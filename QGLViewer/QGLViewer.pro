@@ -30,10 +30,14 @@ SOURCES = qglviewer.cpp \
 	  constraint.cpp \
 	  keyFrameInterpolator.cpp \
 	  mouseGrabber.cpp \
+	  mouseGrabberIndex.cpp \
+	  retainedGeometry.cpp \
+	  textRenderer.cpp \
+	  frameCapture.cpp \
 	  quaternion.cpp \
 	  vec.cpp
 
-HEADERS *= $${QGL_HEADERS}
+HEADERS *= $${QGL_HEADERS} mouseGrabberIndex.h retainedGeometry.h textRenderer.h frameCapture.h
 DISTFILES *= qglviewer-icon.xpm
 DESTDIR =$$_PRO_FILE_PWD_/../bin
 
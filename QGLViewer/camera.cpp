@@ -36,7 +36,8 @@ using namespace qglviewer;
  See IODistance(), physicalDistanceToScreen(), physicalScreenWidth() and focusDistance()
  documentations for default stereo parameter values. */
 Camera::Camera()
-	: frame_(NULL), fieldOfView_(M_PI/4.0), modelViewMatrixIsUpToDate_(false), projectionMatrixIsUpToDate_(false)
+	: frame_(NULL), fieldOfView_(M_PI/4.0), modelViewMatrixIsUpToDate_(false), projectionMatrixIsUpToDate_(false),
+	  floatMatricesAreUpToDate_(false), matricesVersion_(0)
 {
 	// #CONNECTION# Camera copy constructor
 	interpolationKfi_ = new KeyFrameInterpolator;
@@ -75,6 +76,7 @@ Camera::Camera()
 		modelViewMatrix_[j] = ((j%5 == 0) ? 1.0 : 0.0);
 		// #CONNECTION# computeProjectionMatrix() is lazy and assumes 0.0 almost everywhere.
 		projectionMatrix_[j] = 0.0;
+		modelViewMatrixf_[j] = projectionMatrixf_[j] = modelViewProjectionMatrixf_[j] = 0.0f;
 	}
 	computeProjectionMatrix();
 }
@@ -92,7 +94,7 @@ Camera::~Camera()
 
 /*! Copy constructor. Performs a deep copy using operator=(). */
 Camera::Camera(const Camera& camera)
-	: QObject(), frame_(NULL)
+	: QObject(), frame_(NULL), floatMatricesAreUpToDate_(false), matricesVersion_(0)
 {
 	// #CONNECTION# Camera constructor
 	interpolationKfi_ = new KeyFrameInterpolator;
@@ -104,6 +106,7 @@ Camera::Camera(const Camera& camera)
 		modelViewMatrix_[j] = ((j%5 == 0) ? 1.0 : 0.0);
 		// #CONNECTION# computeProjectionMatrix() is lazy and assumes 0.0 almost everywhere.
 		projectionMatrix_[j] = 0.0;
+		modelViewMatrixf_[j] = projectionMatrixf_[j] = modelViewProjectionMatrixf_[j] = 0.0f;
 	}
 
 	(*this)=camera;
@@ -385,6 +388,7 @@ void Camera::computeProjectionMatrix() const
 	}
 
 	projectionMatrixIsUpToDate_ = true;
+	floatMatricesAreUpToDate_ = false;
 }
 
 /*! Computes the modelView matrix associated with the Camera's position() and orientation().
@@ -439,6 +443,7 @@ void Camera::computeModelViewMatrix() const
 	modelViewMatrix_[15] = 1.0;
 
 	modelViewMatrixIsUpToDate_ = true;
+	floatMatricesAreUpToDate_ = false;
 }
 
 
@@ -601,6 +606,7 @@ void Camera::loadModelViewMatrixStereo(bool leftBuffer) const
 		modelViewMatrix_[12] -= shift;
 	else
 		modelViewMatrix_[12] += shift;
+	floatMatricesAreUpToDate_ = false;
 	glLoadMatrixd(modelViewMatrix_);
 }
 
@@ -625,13 +631,14 @@ void Camera::getProjectionMatrix(GLdouble m[16]) const
 		m[i] = projectionMatrix_[i];
 }
 
-/*! Overloaded getProjectionMatrix(GLdouble m[16]) method using a \c GLfloat array instead. */
+/*! Overloaded getProjectionMatrix(GLdouble m[16]) method using a \c GLfloat array instead.
+
+ Copies the cached projectionMatrixf(). */
 void Camera::getProjectionMatrix(GLfloat m[16]) const
 {
-	static GLdouble mat[16];
-	getProjectionMatrix(mat);
+	const GLfloat* mat = projectionMatrixf();
 	for (unsigned short i=0; i<16; ++i)
-		m[i] = float(mat[i]);
+		m[i] = mat[i];
 }
 
 /*! Fills \p m with the Camera modelView matrix values.
@@ -658,13 +665,14 @@ void Camera::getModelViewMatrix(GLdouble m[16]) const
 }
 
 
-/*! Overloaded getModelViewMatrix(GLdouble m[16]) method using a \c GLfloat array instead. */
+/*! Overloaded getModelViewMatrix(GLdouble m[16]) method using a \c GLfloat array instead.
+
+ Copies the cached modelViewMatrixf(). */
 void Camera::getModelViewMatrix(GLfloat m[16]) const
 {
-	static GLdouble mat[16];
-	getModelViewMatrix(mat);
+	const GLfloat* mat = modelViewMatrixf();
 	for (unsigned short i=0; i<16; ++i)
-		m[i] = float(mat[i]);
+		m[i] = mat[i];
 }
 
 /*! Fills \p m with the product of the ModelView and Projection matrices.
@@ -689,13 +697,105 @@ void Camera::getModelViewProjectionMatrix(GLdouble m[16]) const
 	}
 }
 
-/*! Overloaded getModelViewProjectionMatrix(GLdouble m[16]) method using a \c GLfloat array instead. */
+/*! Overloaded getModelViewProjectionMatrix(GLdouble m[16]) method using a \c GLfloat array instead.
+
+ Copies the cached modelViewProjectionMatrixf(). */
 void Camera::getModelViewProjectionMatrix(GLfloat m[16]) const
 {
-	static GLdouble mat[16];
-	getModelViewProjectionMatrix(mat);
+	const GLfloat* mat = modelViewProjectionMatrixf();
+	for (unsigned short i=0; i<16; ++i)
+		m[i] = mat[i];
+}
+
+/*! Converts the modelView and projection matrices to float and computes their product.
+
+ Only done when one of the double matrices was recomputed since the last call. matricesVersion() is
+ incremented when the float values actually differ from the previous ones. */
+void Camera::computeFloatMatrices() const
+{
+	computeModelViewMatrix();
+	computeProjectionMatrix();
+	if (floatMatricesAreUpToDate_)
+		return;
+	floatMatricesAreUpToDate_ = true;
+
+	GLfloat mv[16], proj[16];
+	bool changed = false;
 	for (unsigned short i=0; i<16; ++i)
-		m[i] = float(mat[i]);
+	{
+		mv[i] = GLfloat(modelViewMatrix_[i]);
+		proj[i] = GLfloat(projectionMatrix_[i]);
+		changed = changed || (mv[i] != modelViewMatrixf_[i]) || (proj[i] != projectionMatrixf_[i]);
+	}
+	if (!changed && matricesVersion_ != 0)
+		return;
+
+	for (unsigned short i=0; i<16; ++i)
+	{
+		modelViewMatrixf_[i] = mv[i];
+		projectionMatrixf_[i] = proj[i];
+	}
+
+	// Product in double precision, as in getModelViewProjectionMatrix()
+	for (unsigned short i=0; i<4; ++i)
+		for (unsigned short j=0; j<4; ++j)
+		{
+			qreal sum = 0.0;
+			for (unsigned short k=0; k<4; ++k)
+				sum += projectionMatrix_[i+4*k]*modelViewMatrix_[k+4*j];
+			modelViewProjectionMatrixf_[i+4*j] = GLfloat(sum);
+		}
+
+	++matricesVersion_;
+}
+
+/*! Returns the Camera modelView matrix as 16 floats, in column-major order.
+
+ Same values as getModelViewMatrix(GLfloat m[16]), without copy nor conversion when the Camera did
+ not change: the array is cached and only updated when the Camera frame() or parameters are
+ modified. The pointer remains valid during the Camera's lifetime.
+
+ Use matricesVersion() to know whether the values changed since a previous call. */
+const GLfloat* Camera::modelViewMatrixf() const
+{
+	computeFloatMatrices();
+	return modelViewMatrixf_;
+}
+
+/*! Returns the Camera projection matrix as 16 floats, in column-major order.
+
+ Cached like modelViewMatrixf(). */
+const GLfloat* Camera::projectionMatrixf() const
+{
+	computeFloatMatrices();
+	return projectionMatrixf_;
+}
+
+/*! Returns the product of the projection and modelView matrices as 16 floats, in column-major order.
+
+ Cached like modelViewMatrixf(): the product is only computed when one of the matrices changed. */
+const GLfloat* Camera::modelViewProjectionMatrixf() const
+{
+	computeFloatMatrices();
+	return modelViewProjectionMatrixf_;
+}
+
+/*! Returns a counter incremented each time the modelViewMatrixf(), projectionMatrixf() or
+ modelViewProjectionMatrixf() values change.
+
+ Render code can store this value and skip its matrix uploads while it is unchanged:
+ \code
+ if (camera()->matricesVersion() != lastVersion_)
+ {
+   lastVersion_ = camera()->matricesVersion();
+   glUniformMatrix4fv(mvpLocation, 1, GL_FALSE, camera()->modelViewProjectionMatrixf());
+ }
+ \endcode
+ Never 0 once the matrices have been computed. */
+unsigned long Camera::matricesVersion() const
+{
+	computeFloatMatrices();
+	return matricesVersion_;
 }
 
 /*! Sets the sceneRadius() value. Negative values are ignored.
@@ -372,6 +372,11 @@ public:
 
 	void getModelViewProjectionMatrix(GLfloat m[16]) const;
 	void getModelViewProjectionMatrix(GLdouble m[16]) const;
+
+	const GLfloat* modelViewMatrixf() const;
+	const GLfloat* projectionMatrixf() const;
+	const GLfloat* modelViewProjectionMatrixf() const;
+	unsigned long matricesVersion() const;
 	//@}
 
 
@@ -496,6 +501,13 @@ private:
 	mutable bool modelViewMatrixIsUpToDate_;
 	mutable GLdouble projectionMatrix_[16]; // Buffered projection matrix.
 	mutable bool projectionMatrixIsUpToDate_;
+	// Float copies of the above and their product, see matricesVersion().
+	mutable GLfloat modelViewMatrixf_[16];
+	mutable GLfloat projectionMatrixf_[16];
+	mutable GLfloat modelViewProjectionMatrixf_[16];
+	mutable bool floatMatricesAreUpToDate_;
+	mutable unsigned long matricesVersion_;
+	void computeFloatMatrices() const;
 
 	// S t e r e o   p a r a m e t e r s
 	qreal IODistance_;		     // inter-ocular distance, in meters
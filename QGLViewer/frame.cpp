@@ -27,14 +27,18 @@
 using namespace qglviewer;
 using namespace std;
 
+unsigned long Frame::globalGeneration_ = 0;
+
 
 /*! Creates a default Frame.
 
   Its position() is (0,0,0) and it has an identity orientation() Quaternion. The referenceFrame()
   and the constraint() are \c NULL. */
 Frame::Frame()
-	: constraint_(NULL), referenceFrame_(NULL)
-{}
+	: localGeneration_(globalGeneration_), worldGeneration_(invalidGeneration), checkedGeneration_(invalidGeneration),
+	  constraint_(NULL), referenceFrame_(NULL)
+{
+}
 
 /*! Creates a Frame with a position() and an orientation().
 
@@ -43,8 +47,11 @@ Frame::Frame()
  The Frame is defined in the world coordinate system (its referenceFrame() is \c NULL). It
  has a \c NULL associated constraint(). */
 Frame::Frame(const Vec& position, const Quaternion& orientation)
-	: t_(position), q_(orientation), constraint_(NULL), referenceFrame_(NULL)
-{}
+	: t_(position), q_(orientation),
+	  localGeneration_(globalGeneration_), worldGeneration_(invalidGeneration), checkedGeneration_(invalidGeneration),
+	  constraint_(NULL), referenceFrame_(NULL)
+{
+}
 
 /*! Equal operator.
 
@@ -66,9 +73,12 @@ Frame& Frame::operator=(const Frame& frame)
   The translation() and rotation() as well as constraint() and referenceFrame() pointers are
   copied. */
 Frame::Frame(const Frame& frame)
-	: QObject()
+	: QObject(), t_(frame.t_), q_(frame.q_),
+	  localGeneration_(globalGeneration_), worldGeneration_(invalidGeneration), checkedGeneration_(invalidGeneration),
+	  constraint_(frame.constraint_), referenceFrame_(frame.referenceFrame_)
 {
-	(*this) = frame;
+	// No other Frame depends on the new one: the world caches of the scene are still valid and
+	// globalGeneration() is not advanced.
 }
 
 /////////////////////////////// MATRICES //////////////////////////////////////
@@ -164,7 +174,9 @@ void Frame::getMatrix(GLdouble m[16]) const
 Frame Frame::inverse() const
 {
 	Frame fr(-(q_.inverseRotate(t_)), q_.inverse());
-	fr.setReferenceFrame(referenceFrame());
+	// Not setReferenceFrame(): a new Frame cannot create a loop, and this temporary must not
+	// advance globalGeneration()
+	fr.referenceFrame_ = referenceFrame_;
 	return fr;
 }
 
@@ -195,13 +207,16 @@ Frame Frame::inverse() const
   \note The scaling factor of the 4x4 matrix is 1.0. */
 const GLdouble* Frame::worldMatrix() const
 {
-	// This test is done for efficiency reasons (creates lots of temp objects otherwise).
 	if (referenceFrame())
 	{
-		static Frame fr;
-		fr.setTranslation(position());
-		fr.setRotation(orientation());
-		return fr.matrix();
+		// Uses the cached world transform instead of walking up the referenceFrame() chain.
+		updateWorldTransform();
+		static GLdouble m[4][4];
+		worldOrientation_.getMatrix(m);
+		m[3][0] = worldPosition_[0];
+		m[3][1] = worldPosition_[1];
+		m[3][2] = worldPosition_[2];
+		return (const GLdouble*)(m);
 	}
 	else
 		return matrix();
@@ -242,6 +257,7 @@ void Frame::setFromMatrix(const GLdouble m[4][4])
 			rot[i][j] = m[j][i] / m[3][3];
 	}
 	q_.setFromRotationMatrix(rot);
+	touch();
 	Q_EMIT modified();
 }
 
@@ -337,6 +353,7 @@ void Frame::translate(Vec& t)
 	if (constraint())
 		constraint()->constrainTranslation(t, this);
 	t_ += t;
+	touch();
 	Q_EMIT modified();
 }
 
@@ -379,6 +396,7 @@ void Frame::rotate(Quaternion& q)
 		constraint()->constrainRotation(q, this);
 	q_ *= q;
 	q_.normalize(); // Prevents numerical drift
+	touch();
 	Q_EMIT modified();
 }
 
@@ -417,10 +435,12 @@ void Frame::rotateAroundPoint(Quaternion& rotation, const Vec& point)
 		constraint()->constrainRotation(rotation, this);
 	q_ *= rotation;
 	q_.normalize(); // Prevents numerical drift
+	touch();
 	Vec trans = point + Quaternion(inverseTransformOf(rotation.axis()), rotation.angle()).rotate(position()-point) - t_;
 	if (constraint())
 		constraint()->constrainTranslation(trans, this);
 	t_ += trans;
+	touch();
 	Q_EMIT modified();
 }
 
@@ -471,6 +491,7 @@ void Frame::setPositionAndOrientation(const Vec& position, const Quaternion& ori
 		t_ = position;
 		q_ = orientation;
 	}
+	touch();
 	Q_EMIT modified();
 }
 
@@ -484,6 +505,7 @@ void Frame::setTranslationAndRotation(const Vec& translation, const Quaternion&
 {
 	t_ = translation;
 	q_ = rotation;
+	touch();
 	Q_EMIT modified();
 }
 
@@ -533,26 +555,32 @@ void Frame::getOrientation(qreal& q0, qreal& q1, qreal& q2, qreal& q3) const
 }
 
 /*! Returns the position of the Frame, defined in the world coordinate system. See also
-	orientation(), setPosition() and translation(). */
+	orientation(), setPosition() and translation().
+
+	The world transformation is cached, see worldGeneration(). */
 Vec Frame::position() const {
 	if (referenceFrame_)
-		return inverseCoordinatesOf(Vec(0.0,0.0,0.0));
+	{
+		updateWorldTransform();
+		return worldPosition_;
+	}
 	else
 		return t_;
 }
 
 /*! Returns the orientation of the Frame, defined in the world coordinate system. See also
-  position(), setOrientation() and rotation(). */
+  position(), setOrientation() and rotation().
+
+  The world transformation is cached, see worldGeneration(). */
 Quaternion Frame::orientation() const
 {
-	Quaternion res = rotation();
-	const Frame* fr = referenceFrame();
-	while (fr != NULL)
+	if (referenceFrame_)
 	{
-		res = fr->rotation() * res;
-		fr  = fr->referenceFrame();
+		updateWorldTransform();
+		return worldOrientation_;
 	}
-	return res;
+	else
+		return q_;
 }
 
 
@@ -587,6 +615,7 @@ void Frame::setRotationWithConstraint(Quaternion& rotation)
 
 	setRotation(this->rotation() * deltaQ);
 	q_.normalize();
+	touch();
 	rotation = this->rotation();
 }
 
@@ -609,6 +638,7 @@ void Frame::setTranslationAndRotationWithConstraint(Vec& translation, Quaternion
 	t_ += deltaT;
 	q_ *= deltaQ;
 	q_.normalize();
+	touch();
 
 	translation = this->translation();
 	rotation = this->rotation();
@@ -671,7 +701,10 @@ void Frame::setReferenceFrame(const Frame* const refFrame)
 		bool identical = (referenceFrame_ == refFrame);
 		referenceFrame_ = refFrame;
 		if (!identical)
+		{
+			touch();
 			Q_EMIT modified();
+		}
 	}
 }
 
@@ -689,6 +722,88 @@ bool Frame::settingAsReferenceFrameWillCreateALoop(const Frame* const frame)
 	return false;
 }
 
+/*! Returns a counter that changes each time the world transformation of the Frame (its position()
+  or orientation()) may have changed: when the Frame or one of its referenceFrame() ancestors is
+  modified, or when the hierarchy is changed with setReferenceFrame().
+
+  Unlike the modified() signal, the modifications of the ancestors are taken into account. Compare
+  the value with a saved one to update data that depend on the Frame world transformation only
+  when needed.
+
+  The world transformation is cached and only recomputed when this value changes. When no Frame
+  was modified since the last query, the cache is used without walking up the hierarchy. */
+unsigned long Frame::worldGeneration() const
+{
+	updateWorldTransform();
+	return worldGeneration_;
+}
+
+/*! Updates the cached world transformation (worldPosition_ and worldOrientation_) if the Frame or
+  one of its ancestors was modified since it was computed. The ancestors' caches are updated
+  first, so that the composition only needs the reference frame world transformation. */
+void Frame::updateWorldTransform() const
+{
+	if (checkedGeneration_ == globalGeneration_)
+		return;
+
+	unsigned long generation = localGeneration_;
+	if (referenceFrame_)
+	{
+		referenceFrame_->updateWorldTransform();
+		if (referenceFrame_->worldGeneration_ > generation)
+			generation = referenceFrame_->worldGeneration_;
+	}
+
+	if (generation != worldGeneration_)
+	{
+		if (referenceFrame_)
+		{
+			worldOrientation_ = referenceFrame_->worldOrientation_ * q_;
+			worldPosition_ = referenceFrame_->worldOrientation_.rotate(t_) + referenceFrame_->worldPosition_;
+		}
+		else
+		{
+			worldOrientation_ = q_;
+			worldPosition_ = t_;
+		}
+		worldGeneration_ = generation;
+	}
+
+	checkedGeneration_ = globalGeneration_;
+}
+
+/*! Computes the rigid transformation (\p q, \p t) that converts coordinates from the Frame to the
+  \p in coordinate system: <code>p_in = q.rotate(p) + t</code>. \p in may be \c NULL (world). */
+void Frame::relativeTransform(const Frame* const in, Quaternion& q, Vec& t) const
+{
+	q = orientation();
+	t = position();
+	if (in)
+	{
+		const Quaternion inOrientation = in->orientation();
+		q = inOrientation.inverse() * q;
+		t = inOrientation.inverseRotate(t - in->position());
+	}
+}
+
+namespace {
+// Applies p -> q.rotate(p) + t (translation ignored when t is NULL) to nb points. q is converted
+// once to a 3x3 matrix. src and res may be the same array.
+void applyRigidTransform(const Quaternion& q, const Vec* t, const Vec* src, Vec* res, int nb)
+{
+	qreal m[3][3];
+	q.getRotationMatrix(m);
+	const Vec tr = t ? *t : Vec(0.0, 0.0, 0.0);
+	for (int i=0; i<nb; ++i)
+	{
+		const Vec p = src[i];
+		res[i] = Vec(m[0][0]*p[0] + m[0][1]*p[1] + m[0][2]*p[2] + tr[0],
+					 m[1][0]*p[0] + m[1][1]*p[1] + m[1][2]*p[2] + tr[1],
+					 m[2][0]*p[0] + m[2][1]*p[1] + m[2][2]*p[2] + tr[2]);
+	}
+}
+}
+
 ///////////////////////// FRAME TRANSFORMATIONS OF 3D POINTS //////////////////////////////
 
 /*! Returns the Frame coordinates of a point \p src defined in the world coordinate system (converts
@@ -702,7 +817,10 @@ bool Frame::settingAsReferenceFrameWillCreateALoop(const Frame* const frame)
 Vec Frame::coordinatesOf(const Vec& src) const
 {
 	if (referenceFrame())
-		return localCoordinatesOf(referenceFrame()->coordinatesOf(src));
+	{
+		updateWorldTransform();
+		return worldOrientation_.inverseRotate(src - worldPosition_);
+	}
 	else
 		return localCoordinatesOf(src);
 }
@@ -714,14 +832,13 @@ Vec Frame::coordinatesOf(const Vec& src) const
   instead of 3D coordinates. */
 Vec Frame::inverseCoordinatesOf(const Vec& src) const
 {
-	const Frame* fr = this;
-	Vec res = src;
-	while (fr != NULL)
+	if (referenceFrame())
 	{
-		res = fr->localInverseCoordinatesOf(res);
-		fr  = fr->referenceFrame();
+		updateWorldTransform();
+		return worldOrientation_.rotate(src) + worldPosition_;
 	}
-	return res;
+	else
+		return localInverseCoordinatesOf(src);
 }
 
 /*! Returns the Frame coordinates of a point \p src defined in the referenceFrame() coordinate
@@ -829,6 +946,54 @@ void Frame::getCoordinatesOfFrom(const qreal src[3], qreal res[3], const Frame*
 		res[i] = r[i];
 }
 
+////// Arrays of points
+
+/*! Same as coordinatesOf(), applied to the \p nb points of \p src. Results are stored in \p res,
+  which may be \p src.
+
+  The world transformation is composed once, then applied to all the points. */
+void Frame::coordinatesOf(const Vec* src, Vec* res, int nb) const
+{
+	const Quaternion q = orientation().inverse();
+	const Vec t = -q.rotate(position());
+	applyRigidTransform(q, &t, src, res, nb);
+}
+
+/*! Same as inverseCoordinatesOf(), applied to the \p nb points of \p src. See
+  coordinatesOf(const Vec*, Vec*, int) const. */
+void Frame::inverseCoordinatesOf(const Vec* src, Vec* res, int nb) const
+{
+	const Vec t = position();
+	applyRigidTransform(orientation(), &t, src, res, nb);
+}
+
+/*! Same as coordinatesOfIn(), applied to the \p nb points of \p src. \p in may be \c NULL (world
+  coordinate system). See coordinatesOf(const Vec*, Vec*, int) const. */
+void Frame::coordinatesOfIn(const Vec* src, Vec* res, int nb, const Frame* const in) const
+{
+	if (this == in)
+	{
+		if (res != src)
+			for (int i=0; i<nb; ++i)
+				res[i] = src[i];
+		return;
+	}
+	Quaternion q;
+	Vec t;
+	relativeTransform(in, q, t);
+	applyRigidTransform(q, &t, src, res, nb);
+}
+
+/*! Same as coordinatesOfFrom(), applied to the \p nb points of \p src. \p from may be \c NULL
+  (world coordinate system). See coordinatesOf(const Vec*, Vec*, int) const. */
+void Frame::coordinatesOfFrom(const Vec* src, Vec* res, int nb, const Frame* const from) const
+{
+	if (from)
+		from->coordinatesOfIn(src, res, nb, this);
+	else
+		coordinatesOf(src, res, nb);
+}
+
 
 ///////////////////////// FRAME TRANSFORMATIONS OF VECTORS //////////////////////////////
 
@@ -843,7 +1008,10 @@ void Frame::getCoordinatesOfFrom(const qreal src[3], qreal res[3], const Frame*
 Vec Frame::transformOf(const Vec& src) const
 {
 	if (referenceFrame())
-		return localTransformOf(referenceFrame()->transformOf(src));
+	{
+		updateWorldTransform();
+		return worldOrientation_.inverseRotate(src);
+	}
 	else
 		return localTransformOf(src);
 }
@@ -855,14 +1023,13 @@ Vec Frame::transformOf(const Vec& src) const
   coordinates instead of 3D vectors. */
 Vec Frame::inverseTransformOf(const Vec& src) const
 {
-	const Frame* fr = this;
-	Vec res = src;
-	while (fr != NULL)
+	if (referenceFrame())
 	{
-		res = fr->localInverseTransformOf(res);
-		fr  = fr->referenceFrame();
+		updateWorldTransform();
+		return worldOrientation_.rotate(src);
 	}
-	return res;
+	else
+		return localInverseTransformOf(src);
 }
 
 /*! Returns the Frame transform of a vector \p src defined in the referenceFrame() coordinate system
@@ -970,6 +1137,51 @@ void Frame::getTransformOfFrom(const qreal src[3], qreal res[3], const Frame* co
 		res[i] = r[i];
 }
 
+/////////////////  Arrays of vectors  //////////////////////
+
+/*! Same as transformOf(), applied to the \p nb vectors of \p src. Results are stored in \p res,
+  which may be \p src.
+
+  The world rotation is composed once, then applied to all the vectors. */
+void Frame::transformOf(const Vec* src, Vec* res, int nb) const
+{
+	applyRigidTransform(orientation().inverse(), NULL, src, res, nb);
+}
+
+/*! Same as inverseTransformOf(), applied to the \p nb vectors of \p src. See
+  transformOf(const Vec*, Vec*, int) const. */
+void Frame::inverseTransformOf(const Vec* src, Vec* res, int nb) const
+{
+	applyRigidTransform(orientation(), NULL, src, res, nb);
+}
+
+/*! Same as transformOfIn(), applied to the \p nb vectors of \p src. \p in may be \c NULL (world
+  coordinate system). See transformOf(const Vec*, Vec*, int) const. */
+void Frame::transformOfIn(const Vec* src, Vec* res, int nb, const Frame* const in) const
+{
+	if (this == in)
+	{
+		if (res != src)
+			for (int i=0; i<nb; ++i)
+				res[i] = src[i];
+		return;
+	}
+	Quaternion q;
+	Vec t;
+	relativeTransform(in, q, t);
+	applyRigidTransform(q, NULL, src, res, nb);
+}
+
+/*! Same as transformOfFrom(), applied to the \p nb vectors of \p src. \p from may be \c NULL
+  (world coordinate system). See transformOf(const Vec*, Vec*, int) const. */
+void Frame::transformOfFrom(const Vec* src, Vec* res, int nb, const Frame* const from) const
+{
+	if (from)
+		from->transformOfIn(src, res, nb, this);
+	else
+		transformOf(src, res, nb);
+}
+
 ////////////////////////////      STATE      //////////////////////////////
 
 /*! Returns an XML \c QDomElement that represents the Frame.
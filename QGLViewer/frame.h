@@ -198,7 +198,7 @@ public:
 
 	Use setPosition() to define the world coordinates position(). Use
 	setTranslationWithConstraint() to take into account the potential constraint() of the Frame. */
-	void setTranslation(const Vec& translation) { t_ = translation; Q_EMIT modified(); }
+	void setTranslation(const Vec& translation) { t_ = translation; touch(); Q_EMIT modified(); }
 	void setTranslation(qreal x, qreal y, qreal z);
 	void setTranslationWithConstraint(Vec& translation);
 
@@ -212,7 +212,7 @@ public:
 	 Use setOrientation() to define the world coordinates orientation(). The potential
 	 constraint() of the Frame is not taken into account, use setRotationWithConstraint()
 	 instead. */
-	void setRotation(const Quaternion& rotation) { q_ = rotation; Q_EMIT modified(); }
+	void setRotation(const Quaternion& rotation) { q_ = rotation; touch(); Q_EMIT modified(); }
 	void setRotation(qreal q0, qreal q1, qreal q2, qreal q3);
 	void setRotationWithConstraint(Quaternion& rotation);
 
@@ -262,6 +262,13 @@ public:
 	const Frame* referenceFrame() const { return referenceFrame_; }
 	void setReferenceFrame(const Frame* const refFrame);
 	bool settingAsReferenceFrameWillCreateALoop(const Frame* const frame);
+
+	unsigned long worldGeneration() const;
+	/*! Returns a counter incremented each time any Frame is modified (translation, rotation or
+	referenceFrame()). Data that depend on the position of many Frames (such as the QGLViewer
+	MouseGrabber screen index) can compare it with a saved value to know if one of them moved.
+	Creating or copying a Frame does not modify it. */
+	static unsigned long globalGeneration() { return globalGeneration_; }
 	//@}
 
 
@@ -304,6 +311,11 @@ public:
 	void getLocalInverseCoordinatesOf(const qreal src[3], qreal res[3]) const;
 	void getCoordinatesOfIn(const qreal src[3], qreal res[3], const Frame* const in) const;
 	void getCoordinatesOfFrom(const qreal src[3], qreal res[3], const Frame* const from) const;
+
+	void coordinatesOf(const Vec* src, Vec* res, int nb) const;
+	void inverseCoordinatesOf(const Vec* src, Vec* res, int nb) const;
+	void coordinatesOfIn(const Vec* src, Vec* res, int nb, const Frame* const in) const;
+	void coordinatesOfFrom(const Vec* src, Vec* res, int nb, const Frame* const from) const;
 	//@}
 
 	/*! @name Coordinate system transformation of vectors */
@@ -342,6 +354,11 @@ public:
 	void getLocalInverseTransformOf(const qreal src[3], qreal res[3]) const;
 	void getTransformOfIn(const qreal src[3], qreal res[3], const Frame* const in) const;
 	void getTransformOfFrom(const qreal src[3], qreal res[3], const Frame* const from) const;
+
+	void transformOf(const Vec* src, Vec* res, int nb) const;
+	void inverseTransformOf(const Vec* src, Vec* res, int nb) const;
+	void transformOfIn(const Vec* src, Vec* res, int nb, const Frame* const in) const;
+	void transformOfFrom(const Vec* src, Vec* res, int nb, const Frame* const from) const;
 	//@}
 
 
@@ -399,10 +416,31 @@ public Q_SLOTS:
 	//@}
 
 private:
+	/*! Marks the local transformation as modified. Called after each change of t_, q_ or
+	  referenceFrame_. */
+	void touch() { localGeneration_ = ++globalGeneration_; }
+	void updateWorldTransform() const;
+	void relativeTransform(const Frame* const in, Quaternion& q, Vec& t) const;
+
 	// P o s i t i o n   a n d   o r i e n t a t i o n
 	Vec t_;
 	Quaternion q_;
 
+	// W o r l d   t r a n s f o r m   c a c h e
+	// localGeneration_ is a globalGeneration_ value, set when t_, q_ or referenceFrame_ change.
+	// worldGeneration_ is the max of the localGeneration_ of the Frame and its ancestors when the
+	// cache was computed. checkedGeneration_ is the globalGeneration_ of the last validation: when
+	// no Frame was modified since, the cache is valid without walking up the hierarchy.
+	unsigned long localGeneration_;
+	mutable unsigned long worldGeneration_;
+	mutable unsigned long checkedGeneration_;
+	mutable Vec worldPosition_;
+	mutable Quaternion worldOrientation_;
+	static unsigned long globalGeneration_;
+	// worldGeneration_ and checkedGeneration_ of a new Frame: never a globalGeneration_ value, so
+	// that its cache is computed on first use.
+	static const unsigned long invalidGeneration = ~0UL;
+
 	// C o n s t r a i n t s
 	Constraint* constraint_;
 
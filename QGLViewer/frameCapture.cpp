@@ -0,0 +1,348 @@
+/****************************************************************************
+
+ Copyright (C) 2002-2014 Gilles Debunne. All rights reserved.
+
+ This file is part of the QGLViewer library version 2.6.3.
+
+ http://www.libqglviewer.com - contact@libqglviewer.com
+
+ This file may be used under the terms of the GNU General Public License
+ versions 2.0 or 3.0 as published by the Free Software Foundation and
+ appearing in the LICENSE file included in the packaging of this file.
+ In addition, as a special exception, Gilles Debunne gives you certain
+ additional rights, described in the file GPL_EXCEPTION in this package.
+
+ libQGLViewer uses dual licensing. Commercial/proprietary software must
+ purchase a libQGLViewer Commercial License.
+
+ This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+
+*****************************************************************************/
+
+#include "frameCapture.h"
+
+#include <QFile>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+
+#if QT_VERSION >= 0x050200
+# include <QOpenGLBuffer>
+# include <QOpenGLContext>
+#endif
+
+using namespace qglviewer;
+
+// Encodes one frame and releases its queue slot
+class FrameCapture::EncodeTask : public QRunnable
+{
+public:
+	EncodeTask(FrameCapture* capture, const QImage& image, bool bottomUp, const QString& fileName, const QString& format, int quality)
+		: capture_(capture), image_(image), bottomUp_(bottomUp), fileName_(fileName), format_(format), quality_(quality) {}
+
+	void run()
+	{
+		const QImage image = bottomUp_ ? image_.mirrored() : image_;
+		image_ = QImage();
+		if (FrameCapture::writeImage(image, fileName_, format_, quality_))
+			capture_->written_.ref();
+		else
+			capture_->failed_.ref();
+		capture_->releaseQueueSlot();
+	}
+
+private:
+	FrameCapture* capture_;
+	QImage image_;
+	bool bottomUp_;
+	QString fileName_;
+	QString format_;
+	int quality_;
+};
+
+FrameCapture::FrameCapture()
+	: nextSlot_(0), width_(0), height_(0), usePackBuffers_(true),
+	  queueSize_(8), backpressure_(WAIT), inFlight_(0)
+{
+#if QT_VERSION >= 0x050200
+	for (int i=0; i<nbPackBuffers; ++i)
+		packBuffers_[i] = NULL;
+#endif
+	for (int i=0; i<nbPackBuffers; ++i)
+		pending_[i].valid = false;
+
+	// Leave a core to the GUI thread
+	pool_.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+}
+
+/*! Waits for the encoders. The frames still in pixel pack buffers are lost if flush() was not
+  called, and the buffers are only released by releaseBuffers(), with the context current. */
+FrameCapture::~FrameCapture()
+{
+	waitForEncoders();
+}
+
+/*! Deletes the pixel pack buffers. Their context must be current. Pending frames are lost. */
+void FrameCapture::releaseBuffers()
+{
+#if QT_VERSION >= 0x050200
+	for (int i=0; i<nbPackBuffers; ++i)
+	{
+		if (pending_[i].valid)
+			dropped_.ref();
+		pending_[i].valid = false;
+		delete packBuffers_[i];
+		packBuffers_[i] = NULL;
+	}
+#endif
+	width_ = height_ = 0;
+}
+
+/*! Captures the current read buffer (\p width x \p height pixels) and schedules its writing in \p
+  fileName. See the class documentation. */
+void FrameCapture::capture(int width, int height, const QString& fileName, const QString& format, int quality)
+{
+	if ((width <= 0) || (height <= 0))
+		return;
+
+	// New size: previous frames are mapped with their size, buffers reallocated
+	if ((width != width_) || (height != height_))
+	{
+		flush();
+		releaseBuffers();
+		width_ = width;
+		height_ = height;
+	}
+
+	// Not worth a read back, the frame would be dropped by encode()
+	if ((backpressure_ == DROP) && queueIsFull())
+	{
+		dropped_.ref();
+		return;
+	}
+
+#if QT_VERSION >= 0x050200
+	if (usePackBuffers_ && QOpenGLContext::currentContext())
+	{
+		const int slot = nextSlot_;
+		nextSlot_ = (nextSlot_ + 1) % nbPackBuffers;
+
+		// Frame read nbPackBuffers-1 captures ago: its transfer is over
+		if (pending_[slot].valid)
+			mapSlot(slot);
+
+		if (!packBuffers_[slot])
+		{
+			packBuffers_[slot] = new QOpenGLBuffer(QOpenGLBuffer::PixelPackBuffer);
+			packBuffers_[slot]->setUsagePattern(QOpenGLBuffer::StreamRead);
+			if (packBuffers_[slot]->create())
+			{
+				packBuffers_[slot]->bind();
+				packBuffers_[slot]->allocate(4 * width * height);
+				packBuffers_[slot]->release();
+			}
+			else
+			{
+				delete packBuffers_[slot];
+				packBuffers_[slot] = NULL;
+				usePackBuffers_ = false;
+			}
+		}
+
+		if (packBuffers_[slot])
+		{
+			packBuffers_[slot]->bind();
+			readPixels(width, height, NULL);
+			packBuffers_[slot]->release();
+
+			pending_[slot].valid = true;
+			pending_[slot].fileName = fileName;
+			pending_[slot].format = format;
+			pending_[slot].quality = quality;
+			return;
+		}
+	}
+
+	// Synchronous read back
+	QImage image(width, height, QImage::Format_RGBA8888);
+	readPixels(width, height, image.bits());
+	encode(image, true, fileName, format, quality);
+#else
+	// Synchronous read back, 0xAARRGGBB words
+	QImage image(width, height, QImage::Format_ARGB32);
+	readPixels(width, height, image.bits());
+	QRgb* pixel = reinterpret_cast<QRgb*>(image.bits());
+	for (int i=0; i<width*height; ++i, ++pixel)
+	{
+		const uchar* c = reinterpret_cast<const uchar*>(pixel);
+		*pixel = qRgba(c[0], c[1], c[2], c[3]);
+	}
+	encode(image, true, fileName, format, quality);
+#endif
+}
+
+/*! Reads the RGBA pixels of the current read buffer in \p data (an offset in the bound pixel pack
+  buffer when it is \c NULL), tightly packed. The pack alignment is restored. */
+void FrameCapture::readPixels(int width, int height, uchar* data)
+{
+	GLint previousAlignment;
+	glGetIntegerv(GL_PACK_ALIGNMENT, &previousAlignment);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+	glPixelStorei(GL_PACK_ALIGNMENT, previousAlignment);
+}
+
+/*! Maps the pixel pack buffer of \p slot and hands its frame to the encoders. */
+void FrameCapture::mapSlot(int slot)
+{
+#if QT_VERSION >= 0x050200
+	PendingFrame& frame = pending_[slot];
+	frame.valid = false;
+
+	packBuffers_[slot]->bind();
+	const uchar* data = static_cast<const uchar*>(packBuffers_[slot]->map(QOpenGLBuffer::ReadOnly));
+	if (data)
+	{
+		encode(QImage(data, width_, height_, QImage::Format_RGBA8888).copy(), true, frame.fileName, frame.format, frame.quality);
+		packBuffers_[slot]->unmap();
+	}
+	else
+		failed_.ref();
+	packBuffers_[slot]->release();
+#else
+	Q_UNUSED(slot);
+#endif
+}
+
+/*! Hands the frames still in pixel pack buffers to the encoders, in capture order. Needs the
+  capture context to be current. Called when the capture sequence pauses. */
+void FrameCapture::flush()
+{
+	for (int i=0; i<nbPackBuffers; ++i)
+	{
+		const int slot = (nextSlot_ + i) % nbPackBuffers;
+		if (pending_[slot].valid)
+			mapSlot(slot);
+	}
+}
+
+/*! Blocks until all the frames handed to the encoders are written. */
+void FrameCapture::waitForEncoders()
+{
+	pool_.waitForDone();
+}
+
+/*! Hands a read back frame to the encoders, applying backpressure() when the queue is full. The
+  frames waiting in pixel pack buffers are not counted in the queue: they only enter it here. */
+void FrameCapture::encode(const QImage& image, bool bottomUp, const QString& fileName, const QString& format, int quality)
+{
+	if (!reserveQueueSlot())
+	{
+		dropped_.ref();
+		return;
+	}
+	pool_.start(new EncodeTask(this, image, bottomUp, fileName, format, quality));
+}
+
+/*! Reserves a queue entry for a new frame, applying backpressure(). Returns \c false when the frame
+  must be dropped. */
+bool FrameCapture::reserveQueueSlot()
+{
+	QMutexLocker locker(&mutex_);
+	if (inFlight_ >= queueSize_)
+	{
+		if (backpressure_ == DROP)
+			return false;
+		while (inFlight_ >= queueSize_)
+			slotReleased_.wait(&mutex_);
+	}
+	++inFlight_;
+	return true;
+}
+
+bool FrameCapture::queueIsFull()
+{
+	QMutexLocker locker(&mutex_);
+	return inFlight_ >= queueSize_;
+}
+
+void FrameCapture::releaseQueueSlot()
+{
+	QMutexLocker locker(&mutex_);
+	--inFlight_;
+	slotReleased_.wakeAll();
+}
+
+/*! Number of frames written since the last resetStatistics(). */
+int FrameCapture::writtenFrameCount() const
+{
+#if QT_VERSION >= 0x050000
+	return written_.load();
+#else
+	return written_;
+#endif
+}
+
+/*! Number of frames dropped by the DROP backpressure() since the last resetStatistics(). */
+int FrameCapture::droppedFrameCount() const
+{
+#if QT_VERSION >= 0x050000
+	return dropped_.load();
+#else
+	return dropped_;
+#endif
+}
+
+/*! Number of frames that could not be read back or written since the last resetStatistics(). */
+int FrameCapture::failedFrameCount() const
+{
+#if QT_VERSION >= 0x050000
+	return failed_.load();
+#else
+	return failed_;
+#endif
+}
+
+void FrameCapture::resetStatistics()
+{
+	written_.fetchAndStoreOrdered(0);
+	dropped_.fetchAndStoreOrdered(0);
+	failed_.fetchAndStoreOrdered(0);
+}
+
+/*! Writes \p image in \p fileName. \p format is a QImageWriter format, or \c "RAW" for the bare
+  pixels (top to bottom rows of 8 bits R, G, B, A values) without header. */
+bool FrameCapture::writeImage(const QImage& image, const QString& fileName, const QString& format, int quality)
+{
+	if (format != "RAW")
+		return image.save(fileName, format.toLatin1().constData(), quality);
+
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly))
+		return false;
+
+#if QT_VERSION >= 0x050200
+	const QImage rgba = image.convertToFormat(QImage::Format_RGBA8888);
+	for (int y=0; y<rgba.height(); ++y)
+		if (file.write(reinterpret_cast<const char*>(rgba.constScanLine(y)), 4 * rgba.width()) != 4 * rgba.width())
+			return false;
+#else
+	const QImage argb = image.convertToFormat(QImage::Format_ARGB32);
+	QByteArray line(4 * argb.width(), 0);
+	for (int y=0; y<argb.height(); ++y)
+	{
+		const QRgb* pixel = reinterpret_cast<const QRgb*>(argb.constScanLine(y));
+		for (int x=0; x<argb.width(); ++x)
+		{
+			line[4*x]   = char(qRed(pixel[x]));
+			line[4*x+1] = char(qGreen(pixel[x]));
+			line[4*x+2] = char(qBlue(pixel[x]));
+			line[4*x+3] = char(qAlpha(pixel[x]));
+		}
+		if (file.write(line) != line.size())
+			return false;
+	}
+#endif
+	return true;
+}
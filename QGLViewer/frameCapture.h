@@ -0,0 +1,135 @@
+/****************************************************************************
+
+ Copyright (C) 2002-2014 Gilles Debunne. All rights reserved.
+
+ This file is part of the QGLViewer library version 2.6.3.
+
+ http://www.libqglviewer.com - contact@libqglviewer.com
+
+ This file may be used under the terms of the GNU General Public License
+ versions 2.0 or 3.0 as published by the Free Software Foundation and
+ appearing in the LICENSE file included in the packaging of this file.
+ In addition, as a special exception, Gilles Debunne gives you certain
+ additional rights, described in the file GPL_EXCEPTION in this package.
+
+ libQGLViewer uses dual licensing. Commercial/proprietary software must
+ purchase a libQGLViewer Commercial License.
+
+ This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+
+*****************************************************************************/
+
+#ifndef QGLVIEWER_FRAME_CAPTURE_H
+#define QGLVIEWER_FRAME_CAPTURE_H
+
+#include "config.h"
+#include <QAtomicInt>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#if QT_VERSION >= 0x050200
+class QOpenGLBuffer;
+#endif
+
+namespace qglviewer {
+
+/*! \brief Asynchronous frame sequence capture, used by QGLViewer::saveSnapshot() in automatic mode.
+  \class FrameCapture frameCapture.h QGLViewer/frameCapture.h
+
+  capture() starts the read back of the current read buffer in one of a ring of pixel pack buffers
+  (Qt 5.2 and later) and returns without waiting for it. The pixels of a ring slot are only mapped
+  when the slot is reused, nbPackBuffers - 1 captures later, or by flush(). The frames are then
+  encoded and written by a pool of encoder threads.
+
+  At most queueSize() mapped frames are waiting for or being encoded. When this queue is full, the
+  frame handed to the encoders waits for an encoder (WAIT) or is dropped (DROP), see backpressure().
+  Frames still in pixel pack buffers are not counted, so that any queueSize() makes progress. The numbers of
+  written, dropped and failed frames are available for statistics.
+
+  Without pixel pack buffers, the frame is read synchronously but still encoded in the background.
+
+  Internal class used by QGLViewer, not installed. */
+class FrameCapture
+{
+public:
+	enum Backpressure { WAIT, DROP };
+
+	FrameCapture();
+	~FrameCapture();
+
+	void capture(int width, int height, const QString& fileName, const QString& format, int quality);
+	void flush();
+	void waitForEncoders();
+	void releaseBuffers();
+
+	/*! Maximum number of frames waiting for or being encoded. */
+	int queueSize() const { return queueSize_; }
+	void setQueueSize(int size) { queueSize_ = qMax(1, size); }
+	/*! Policy applied when queueSize() is reached. */
+	Backpressure backpressure() const { return backpressure_; }
+	void setBackpressure(Backpressure policy) { backpressure_ = policy; }
+	/*! Number of encoder threads. */
+	int encoderCount() const { return pool_.maxThreadCount(); }
+	void setEncoderCount(int count) { pool_.setMaxThreadCount(qMax(1, count)); }
+
+	int writtenFrameCount() const;
+	int droppedFrameCount() const;
+	int failedFrameCount() const;
+	void resetStatistics();
+
+	static bool writeImage(const QImage& image, const QString& fileName, const QString& format, int quality);
+
+private:
+	// Copy would share the GL buffers
+	FrameCapture(const FrameCapture&);
+	FrameCapture& operator=(const FrameCapture&);
+
+	class EncodeTask;
+	friend class EncodeTask;
+
+	bool reserveQueueSlot();
+	bool queueIsFull();
+	void releaseQueueSlot();
+	void encode(const QImage& image, bool bottomUp, const QString& fileName, const QString& format, int quality);
+	void mapSlot(int slot);
+	static void readPixels(int width, int height, uchar* data);
+
+	// Frame of a pixel pack buffer, waiting to be mapped
+	struct PendingFrame
+	{
+		bool valid;
+		QString fileName;
+		QString format;
+		int quality;
+	};
+
+	static const int nbPackBuffers = 3;
+#if QT_VERSION >= 0x050200
+	QOpenGLBuffer* packBuffers_[nbPackBuffers];
+#endif
+	PendingFrame pending_[nbPackBuffers];
+	int nextSlot_;
+	int width_, height_;
+	bool usePackBuffers_;
+
+	int queueSize_;
+	Backpressure backpressure_;
+	QThreadPool pool_;
+
+	// Frames handed to the encoders, waiting for or being encoded
+	int inFlight_;
+	QMutex mutex_;
+	QWaitCondition slotReleased_;
+
+	QAtomicInt written_;
+	QAtomicInt dropped_;
+	QAtomicInt failed_;
+};
+
+} // namespace qglviewer
+
+#endif // QGLVIEWER_FRAME_CAPTURE_H
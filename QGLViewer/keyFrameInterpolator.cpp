@@ -21,7 +21,10 @@
 *****************************************************************************/
 
 #include "domUtils.h"
-#include "qglviewer.h" // for QGLViewer::drawAxis and Camera::drawCamera
+#include "qglviewer.h"
+#include "retainedGeometry.h"
+
+#include <algorithm>
 
 using namespace qglviewer;
 using namespace std;
@@ -34,12 +37,15 @@ using namespace std;
   values. */
 KeyFrameInterpolator::KeyFrameInterpolator(Frame* frame)
 	: frame_(NULL), period_(40), interpolationTime_(0.0), interpolationSpeed_(1.0), interpolationStarted_(false),
-	  closedPath_(false), loopInterpolation_(false), pathIsValid_(false), valuesAreValid_(true), currentFrameValid_(false)
+	  closedPath_(false), loopInterpolation_(false), constantSpeed_(false), pathIsValid_(false), valuesAreValid_(true),
+	  arcLengthIsValid_(false), geometryIsValid_(false)
 	// #CONNECTION# Values cut pasted initFromDOMElement()
 {
+	currentSegment_ = 0;
+	pathGeometry_ = new RetainedGeometry();
+	axisGeometry_ = new RetainedGeometry();
+	axisGeometry_->setHasColors(true);
 	setFrame(frame);
-	for (int i=0; i<4; ++i)
-		currentFrame_[i] = new QMutableListIterator<KeyFrame*>(keyFrame_);
 	connect(&timer_, SIGNAL(timeout()), SLOT(update()));
 }
 
@@ -47,8 +53,8 @@ KeyFrameInterpolator::KeyFrameInterpolator(Frame* frame)
 KeyFrameInterpolator::~KeyFrameInterpolator()
 {
 	deletePath();
-	for (int i=0; i<4; ++i)
-		delete currentFrame_[i];
+	delete pathGeometry_;
+	delete axisGeometry_;
 }
 
 /*! Sets the frame() associated to the KeyFrameInterpolator. */
@@ -186,7 +192,6 @@ void KeyFrameInterpolator::addKeyFrame(const Frame* const frame, qreal time)
 	connect(frame, SIGNAL(modified()), SLOT(invalidateValues()));
 	valuesAreValid_ = false;
 	pathIsValid_ = false;
-	currentFrameValid_ = false;
 	resetInterpolation();
 }
 
@@ -209,7 +214,6 @@ void KeyFrameInterpolator::addKeyFrame(const Frame& frame, qreal time)
 
 	valuesAreValid_ = false;
 	pathIsValid_ = false;
-	currentFrameValid_ = false;
 	resetInterpolation();
 }
 
@@ -252,13 +256,11 @@ void KeyFrameInterpolator::deletePath()
 	keyFrame_.clear();
 	pathIsValid_ = false;
 	valuesAreValid_ = false;
-	currentFrameValid_ = false;
 }
 
-static void drawCamera(qreal scale)
+// Camera representation of drawPath(), in the current RetainedGeometry frame
+static void addCamera(RetainedGeometry& geometry, qreal scale)
 {
-	glDisable(GL_LIGHTING);
-
 	const qreal halfHeight = scale * 0.07;
 	const qreal halfWidth  = halfHeight * 1.3;
 	const qreal dist = halfHeight / tan(qreal(M_PI)/8.0);
@@ -269,38 +271,21 @@ static void drawCamera(qreal scale)
 	const qreal baseHalfWidth  = 0.3 * halfWidth;
 
 	// Frustum outline
-	glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-	glBegin(GL_LINE_STRIP);
-	glVertex3d(-halfWidth, halfHeight,-dist);
-	glVertex3d(-halfWidth,-halfHeight,-dist);
-	glVertex3d( 0.0, 0.0, 0.0);
-	glVertex3d( halfWidth,-halfHeight,-dist);
-	glVertex3d(-halfWidth,-halfHeight,-dist);
-	glEnd();
-	glBegin(GL_LINE_STRIP);
-	glVertex3d( halfWidth,-halfHeight,-dist);
-	glVertex3d( halfWidth, halfHeight,-dist);
-	glVertex3d( 0.0, 0.0, 0.0);
-	glVertex3d(-halfWidth, halfHeight,-dist);
-	glVertex3d( halfWidth, halfHeight,-dist);
-	glEnd();
+	const Vec frustum1[5] = { Vec(-halfWidth, halfHeight,-dist), Vec(-halfWidth,-halfHeight,-dist), Vec(0.0, 0.0, 0.0),
+							  Vec( halfWidth,-halfHeight,-dist), Vec(-halfWidth,-halfHeight,-dist) };
+	const Vec frustum2[5] = { Vec( halfWidth,-halfHeight,-dist), Vec( halfWidth, halfHeight,-dist), Vec(0.0, 0.0, 0.0),
+							  Vec(-halfWidth, halfHeight,-dist), Vec( halfWidth, halfHeight,-dist) };
+	geometry.addLineStrip(frustum1, 5);
+	geometry.addLineStrip(frustum2, 5);
 
 	// Up arrow
-	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 	// Base
-	glBegin(GL_QUADS);
-	glVertex3d(-baseHalfWidth, halfHeight,-dist);
-	glVertex3d( baseHalfWidth, halfHeight,-dist);
-	glVertex3d( baseHalfWidth, baseHeight,-dist);
-	glVertex3d(-baseHalfWidth, baseHeight,-dist);
-	glEnd();
-
+	geometry.addQuad(Vec(-baseHalfWidth, halfHeight,-dist), Vec( baseHalfWidth, halfHeight,-dist),
+					 Vec( baseHalfWidth, baseHeight,-dist), Vec(-baseHalfWidth, baseHeight,-dist));
 	// Arrow
-	glBegin(GL_TRIANGLES);
-	glVertex3d( 0.0,           arrowHeight,-dist);
-	glVertex3d(-arrowHalfWidth, baseHeight, -dist);
-	glVertex3d( arrowHalfWidth, baseHeight, -dist);
-	glEnd();
+	geometry.addTriangle(Vec( 0.0,           arrowHeight,-dist),
+						 Vec(-arrowHalfWidth, baseHeight, -dist),
+						 Vec( arrowHalfWidth, baseHeight, -dist));
 }
 
 /*! Draws the path used to interpolate the frame().
@@ -327,6 +312,11 @@ static void drawCamera(qreal scale)
 
   The color of the path is the current \c glColor().
 
+  The path, cameras and axis are stored in vertex buffers, only rebuilt when a keyFrame or one of the
+  parameters changes. Each call then draws them with a few \c glDrawArrays. With an OpenGL core
+  profile context, the matrices and color set by QGLViewer::preDraw() are used instead of the current
+  \c GL_MODELVIEW matrix and \c glColor().
+
   \attention The OpenGL state is modified by this method: GL_LIGHTING is disabled and line width set
   to 2. Use this code to preserve your current OpenGL state:
   \code
@@ -351,72 +341,96 @@ void KeyFrameInterpolator::drawPath(int mask, int nbFrames, qreal scale)
 			path_.push_back(Frame(keyFrame_.first()->position(), keyFrame_.first()->orientation()));
 		else
 		{
-			static Frame fr;
-			KeyFrame* kf_[4];
-			kf_[0] = keyFrame_.first();
-			kf_[1] = kf_[0];
-			int index = 1;
-			kf_[2] = (index < keyFrame_.size()) ? keyFrame_.at(index) : NULL;
-			index++;
-			kf_[3] = (index < keyFrame_.size()) ? keyFrame_.at(index) : NULL;
-
-			while (kf_[2])
-			{
-				Vec diff = kf_[2]->position() - kf_[1]->position();
-				Vec v1 = 3.0 * diff - 2.0 * kf_[1]->tgP() - kf_[2]->tgP();
-				Vec v2 = -2.0 * diff + kf_[1]->tgP() + kf_[2]->tgP();
-
-				// cout << kf_[0]->time() << " , " << kf_[1]->time() << " , " << kf_[2]->time() << " , " << kf_[3]->time() << endl;
+			Vec pos;
+			Quaternion q;
+			for (int i=0; i<segments_.size(); ++i)
 				for (int step=0; step<nbSteps; ++step)
 				{
-					qreal alpha = step / static_cast<qreal>(nbSteps);
-					fr.setPosition(kf_[1]->position() + alpha * (kf_[1]->tgP() + alpha * (v1+alpha*v2)));
-					fr.setOrientation(Quaternion::squad(kf_[1]->orientation(), kf_[1]->tgQ(), kf_[2]->tgQ(), kf_[2]->orientation(), alpha));
-					path_.push_back(fr);
+					evaluate(i, step / static_cast<qreal>(nbSteps), pos, q);
+					path_.push_back(Frame(pos, q));
 				}
-
-				// Shift
-				kf_[0] = kf_[1];
-				kf_[1] = kf_[2];
-				kf_[2] = kf_[3];
-				index++;
-				kf_[3] = (index < keyFrame_.size()) ? keyFrame_.at(index) : NULL;
-			}
 			// Add last KeyFrame
-			path_.push_back(Frame(kf_[1]->position(), kf_[1]->orientation()));
+			path_.push_back(Frame(keyFrame_.last()->position(), keyFrame_.last()->orientation()));
 		}
 		pathIsValid_ = true;
+		geometryIsValid_ = false;
 	}
 
+	if (!geometryIsValid_ || (mask != geometryMask_) || (nbFrames != geometryNbFrames_) || (scale != geometryScale_))
+		updatePathGeometry(mask, nbFrames, scale);
+
 	if (mask)
 	{
-		glDisable(GL_LIGHTING);
-		glLineWidth(2);
-
-		if (mask & 1)
+		const bool coreProfile = RetainedGeometry::isCoreProfile();
+		if (!coreProfile)
 		{
-			glBegin(GL_LINE_STRIP);
-			Q_FOREACH (Frame fr, path_)
-				glVertex3fv(fr.position());
-			glEnd();
+			glDisable(GL_LIGHTING);
+			glLineWidth(2);
 		}
-		if (mask & 6)
+
+		pathGeometry_->draw();
+
+		if (!axisGeometry_->isEmpty())
 		{
-			int count = 0;
-			if (nbFrames > nbSteps)
-				nbFrames = nbSteps;
-			qreal goal = 0.0;
-			Q_FOREACH (Frame fr, path_)
-				if ((count++) >= goal)
+			// Lit axis arrows, as with QGLViewer::drawAxis()
+			if (!coreProfile)
+			{
+				glPushAttrib(GL_LIGHTING_BIT);
+				glEnable(GL_LIGHTING);
+				glEnable(GL_COLOR_MATERIAL);
+				glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
+			}
+			axisGeometry_->draw();
+			if (!coreProfile)
+				glPopAttrib();
+		}
+	}
+}
+
+/*! Bakes the path_ polyline, cameras and axis selected by \p mask in pathGeometry_ and
+ axisGeometry_. The vertex buffers are then only updated when the path or the drawPath() parameters
+ change. */
+void KeyFrameInterpolator::updatePathGeometry(int mask, int nbFrames, qreal scale)
+{
+	const int nbSteps = 30;
+
+	pathGeometry_->clear();
+	axisGeometry_->clear();
+	geometryMask_ = mask;
+	geometryNbFrames_ = nbFrames;
+	geometryScale_ = scale;
+	geometryIsValid_ = true;
+
+	if (mask & 1)
+	{
+		QVector<Vec> points;
+		points.reserve(path_.size());
+		Q_FOREACH (const Frame& fr, path_)
+			points.append(fr.position());
+		pathGeometry_->addLineStrip(points.constData(), points.size());
+	}
+
+	if (mask & 6)
+	{
+		int count = 0;
+		if (nbFrames > nbSteps)
+			nbFrames = nbSteps;
+		qreal goal = 0.0;
+		Q_FOREACH (const Frame& fr, path_)
+			if ((count++) >= goal)
+			{
+				goal += nbSteps / static_cast<qreal>(nbFrames);
+				pathGeometry_->setFrame(&fr);
+				axisGeometry_->setFrame(&fr);
+				if (mask & 2) addCamera(*pathGeometry_, scale);
+				if (mask & 4)
 				{
-					goal += nbSteps / static_cast<qreal>(nbFrames);
-					glPushMatrix();
-					glMultMatrixd(fr.matrix());
-					if (mask & 2) drawCamera(scale);
-					if (mask & 4) QGLViewer::drawAxis(scale/10.0);
-					glPopMatrix();
+					pathGeometry_->addAxisLetters(scale/10.0);
+					axisGeometry_->addAxisArrows(scale/10.0);
 				}
-		}
+			}
+		pathGeometry_->setFrame(NULL);
+		axisGeometry_->setFrame(NULL);
 	}
 }
 
@@ -447,7 +461,189 @@ void KeyFrameInterpolator::updateModifiedFrameValues()
 		prev = kf;
 		kf = next;
 	}
+
+	// Flattened copy: times for the binary search and spline coefficients of each segment
+	const int nb = keyFrame_.size();
+	times_.resize(nb);
+	segments_.resize(nb-1);
+	for (int i=0; i<nb; ++i)
+	{
+		times_[i] = keyFrame_.at(i)->time();
+		if (i == nb-1)
+			break;
+
+		const KeyFrame* const kf1 = keyFrame_.at(i);
+		const KeyFrame* const kf2 = keyFrame_.at(i+1);
+		Segment& seg = segments_[i];
+		const Vec delta = kf2->position() - kf1->position();
+		seg.p    = kf1->position();
+		seg.tgP  = kf1->tgP();
+		seg.v1   = 3.0 * delta - 2.0 * kf1->tgP() - kf2->tgP();
+		seg.v2   = -2.0 * delta + kf1->tgP() + kf2->tgP();
+		seg.q1   = kf1->orientation();
+		seg.tgQ1 = kf1->tgQ();
+		seg.tgQ2 = kf2->tgQ();
+		seg.q2   = kf2->orientation();
+	}
+	if (currentSegment_ >= segments_.size())
+		currentSegment_ = 0;
+
 	valuesAreValid_ = true;
+	arcLengthIsValid_ = false;
+}
+
+// Number of samples per segment of the arc-length table
+static const int nbArcLengthSamples = 16;
+
+/*! Computes arcLength_, the length of the position path from the first keyFrame to each of the
+ nbArcLengthSamples regular alpha steps of each segment. Linear interpolation between these samples
+ gives the (segment, alpha) reached at a given distance. */
+void KeyFrameInterpolator::updateArcLengthTable()
+{
+	arcLength_.resize(segments_.size() * nbArcLengthSamples + 1);
+	arcLength_[0] = 0.0;
+	qreal length = 0.0;
+	int index = 1;
+	for (int i=0; i<segments_.size(); ++i)
+	{
+		const Segment& seg = segments_.at(i);
+		Vec prev = seg.p;
+		for (int step=1; step<=nbArcLengthSamples; ++step)
+		{
+			const qreal alpha = step / static_cast<qreal>(nbArcLengthSamples);
+			const Vec pos = seg.p + alpha * (seg.tgP + alpha * (seg.v1 + alpha * seg.v2));
+			length += (pos - prev).norm();
+			arcLength_[index++] = length;
+			prev = pos;
+		}
+	}
+	arcLengthIsValid_ = true;
+}
+
+/*! Returns the length of the path followed by the frame() position (the curve displayed by
+ drawPath()), computed from the arc-length table used by constantSpeed(). */
+qreal KeyFrameInterpolator::pathLength()
+{
+	if (keyFrame_.isEmpty())
+		return 0.0;
+
+	if (!valuesAreValid_)
+		updateModifiedFrameValues();
+	if (!arcLengthIsValid_)
+		updateArcLengthTable();
+
+	return arcLength_.last();
+}
+
+/*! Finds the \p segment and the \p alpha spline parameter in that segment that correspond to \p
+ time. The path values must be valid and there must be at least 2 keyFrames.
+
+ Times before firstTime() (resp. after lastTime()) are clamped to the first (resp. last) keyFrame.
+ The segment found for the previous call and its successor are tested first, so that successive
+ increasing times (interpolation, getFramesAtTimes()) are found in constant time. Other times use a
+ binary search in the keyFrame times, or in the arc-length table when constantSpeed(). */
+void KeyFrameInterpolator::segmentAtTime(qreal time, int& segment, qreal& alpha)
+{
+	const int nbSegments = segments_.size();
+	const qreal first = times_.first();
+	const qreal last  = times_.last();
+
+	if (time <= first)
+	{
+		segment = 0;
+		alpha = 0.0;
+		return;
+	}
+	if (time >= last)
+	{
+		segment = nbSegments-1;
+		alpha = 1.0;
+		return;
+	}
+
+	if (constantSpeed())
+	{
+		if (!arcLengthIsValid_)
+			updateArcLengthTable();
+
+		const qreal length = arcLength_.last();
+		if (length > 0.0)
+		{
+			// Distance reached at time, then sample interval containing it
+			const qreal dist = (time - first) / (last - first) * length;
+			int sample = int(upper_bound(arcLength_.constBegin(), arcLength_.constEnd(), dist) - arcLength_.constBegin()) - 1;
+			sample = qBound(0, sample, arcLength_.size()-2);
+
+			const qreal sampleLength = arcLength_.at(sample+1) - arcLength_.at(sample);
+			const qreal frac = (sampleLength > 0.0) ? (dist - arcLength_.at(sample)) / sampleLength : 0.0;
+
+			segment = qMin(sample / nbArcLengthSamples, nbSegments-1);
+			alpha = (sample - segment * nbArcLengthSamples + frac) / nbArcLengthSamples;
+			currentSegment_ = segment;
+			return;
+		}
+	}
+
+	// times_[segment] <= time < times_[segment+1]
+	segment = -1;
+	for (int s=currentSegment_; s<=currentSegment_+1 && s<nbSegments; ++s)
+		if ((times_.at(s) <= time) && (time < times_.at(s+1)))
+		{
+			segment = s;
+			break;
+		}
+	if (segment < 0)
+		segment = int(upper_bound(times_.constBegin(), times_.constEnd(), time) - times_.constBegin()) - 1;
+	currentSegment_ = segment;
+
+	const qreal dt = times_.at(segment+1) - times_.at(segment);
+	if (dt == 0.0)
+		alpha = 0.0;
+	else
+		alpha = (time - times_.at(segment)) / dt;
+}
+
+/*! Position and orientation of the path at spline parameter \p alpha of \p segment. */
+void KeyFrameInterpolator::evaluate(int segment, qreal alpha, Vec& position, Quaternion& orientation) const
+{
+	const Segment& seg = segments_.at(segment);
+	position = seg.p + alpha * (seg.tgP + alpha * (seg.v1 + alpha * seg.v2));
+	orientation = Quaternion::squad(seg.q1, seg.tgQ1, seg.tgQ2, seg.q2, alpha);
+}
+
+/*! Computes the path positions and orientations at each of the \p times, without modifying the
+ frame() nor the interpolationTime(). constantSpeed() is taken into account.
+
+ \p positions and \p orientations are resized to the number of \p times. This is much faster than
+ successive calls to interpolateAtTime() to preview a path (no signal is emitted, the frame()
+ constraint is not involved), especially when \p times are sorted. */
+void KeyFrameInterpolator::getFramesAtTimes(const QVector<qreal>& times, QVector<Vec>& positions, QVector<Quaternion>& orientations)
+{
+	const int nb = times.size();
+	positions.resize(nb);
+	orientations.resize(nb);
+	if (keyFrame_.isEmpty())
+		return;
+
+	if (!valuesAreValid_)
+		updateModifiedFrameValues();
+
+	if (segments_.isEmpty())
+	{
+		positions.fill(keyFrame_.first()->position());
+		orientations.fill(keyFrame_.first()->orientation());
+		return;
+	}
+
+	Vec* pos = positions.data();
+	Quaternion* ori = orientations.data();
+	int segment;
+	qreal alpha;
+	for (int i=0; i<nb; ++i)
+	{
+		segmentAtTime(times.at(i), segment, alpha);
+		evaluate(segment, alpha, pos[i], ori[i]);
+	}
 }
 
 /*! Returns the Frame associated with the keyFrame at index \p index.
@@ -501,65 +697,6 @@ qreal KeyFrameInterpolator::lastTime() const
 		return keyFrame_.last()->time();
 }
 
-void KeyFrameInterpolator::updateCurrentKeyFrameForTime(qreal time)
-{
-	// Assertion: times are sorted in monotone order.
-	// Assertion: keyFrame_ is not empty
-
-	// TODO: Special case for loops when closed path is implemented !!
-	if (!currentFrameValid_)
-		// Recompute everything from scrach
-		currentFrame_[1]->toFront();
-
-	while (currentFrame_[1]->peekNext()->time() > time)
-	{
-		currentFrameValid_ = false;
-		if (!currentFrame_[1]->hasPrevious())
-			break;
-		currentFrame_[1]->previous();
-	}
-
-	if (!currentFrameValid_)
-		*currentFrame_[2] = *currentFrame_[1];
-
-	while (currentFrame_[2]->peekNext()->time() < time)
-	{
-		currentFrameValid_ = false;
-		if (!currentFrame_[2]->hasNext())
-			break;
-		currentFrame_[2]->next();
-	}
-
-	if (!currentFrameValid_)
-	{
-		*currentFrame_[1] = *currentFrame_[2];
-		if ((currentFrame_[1]->hasPrevious()) && (time < currentFrame_[2]->peekNext()->time()))
-			currentFrame_[1]->previous();
-
-		*currentFrame_[0] = *currentFrame_[1];
-		if (currentFrame_[0]->hasPrevious())
-			currentFrame_[0]->previous();
-
-		*currentFrame_[3] = *currentFrame_[2];
-		if (currentFrame_[3]->hasNext())
-			currentFrame_[3]->next();
-
-		currentFrameValid_ = true;
-		splineCacheIsValid_ = false;
-	}
-
-	// cout << "Time = " << time << " : " << currentFrame_[0]->peekNext()->time() << " , " <<
-	// currentFrame_[1]->peekNext()->time() << " , " << currentFrame_[2]->peekNext()->time() << " , " <<  currentFrame_[3]->peekNext()->time() << endl;
-}
-
-void KeyFrameInterpolator::updateSplineCache()
-{
-	Vec delta = currentFrame_[2]->peekNext()->position() - currentFrame_[1]->peekNext()->position();
-	v1 = 3.0 * delta - 2.0 * currentFrame_[1]->peekNext()->tgP() - currentFrame_[2]->peekNext()->tgP();
-	v2 = -2.0 * delta + currentFrame_[1]->peekNext()->tgP() + currentFrame_[2]->peekNext()->tgP();
-	splineCacheIsValid_ = true;
-}
-
 /*! Interpolate frame() at time \p time (expressed in seconds). interpolationTime() is set to \p
   time and frame() is set accordingly.
 
@@ -577,23 +714,20 @@ void KeyFrameInterpolator::interpolateAtTime(qreal time)
 	if (!valuesAreValid_)
 		updateModifiedFrameValues();
 
-	updateCurrentKeyFrameForTime(time);
-
-	if (!splineCacheIsValid_)
-		updateSplineCache();
-
-	qreal alpha;
-	qreal dt = currentFrame_[2]->peekNext()->time() - currentFrame_[1]->peekNext()->time();
-	if (dt == 0.0)
-		alpha = 0.0;
+	Vec pos;
+	Quaternion q;
+	if (segments_.isEmpty())
+	{
+		pos = keyFrame_.first()->position();
+		q = keyFrame_.first()->orientation();
+	}
 	else
-		alpha = (time - currentFrame_[1]->peekNext()->time()) / dt;
-
-	// Linear interpolation - debug
-	// Vec pos = alpha*(currentFrame_[2]->peekNext()->position()) + (1.0-alpha)*(currentFrame_[1]->peekNext()->position());
-	Vec pos = currentFrame_[1]->peekNext()->position() + alpha * (currentFrame_[1]->peekNext()->tgP() + alpha * (v1+alpha*v2));
-	Quaternion q = Quaternion::squad(currentFrame_[1]->peekNext()->orientation(), currentFrame_[1]->peekNext()->tgQ(),
-			currentFrame_[2]->peekNext()->tgQ(), currentFrame_[2]->peekNext()->orientation(), alpha);
+	{
+		int segment;
+		qreal alpha;
+		segmentAtTime(time, segment, alpha);
+		evaluate(segment, alpha, pos, q);
+	}
 	frame()->setPositionAndOrientationWithConstraint(pos, q);
 
 	Q_EMIT interpolated();
@@ -672,7 +806,6 @@ void KeyFrameInterpolator::initFromDOMElement(const QDomElement& element)
 	// setFrame(NULL);
 	pathIsValid_ = false;
 	valuesAreValid_ = false;
-	currentFrameValid_ = false;
 
 	stopInterpolation();
 }
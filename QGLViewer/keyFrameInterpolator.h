@@ -25,6 +25,7 @@
 
 #include <QObject>
 #include <QTimer>
+#include <QVector>
 
 #include "quaternion.h"
 // Not actually needed, but some bad compilers (Microsoft VS6) complain.
@@ -37,6 +38,7 @@
 namespace qglviewer {
 class Camera;
 class Frame;
+class RetainedGeometry;
 /*! \brief A keyFrame Catmull-Rom Frame interpolator.
   \class KeyFrameInterpolator keyFrameInterpolator.h QGLViewer/keyFrameInterpolator.h
 
@@ -230,6 +232,13 @@ public:
 
 	In both cases, the endReached() signal is emitted. */
 	bool loopInterpolation() const { return loopInterpolation_; }
+	/*! Returns \c true when the frame() moves at constant speed along the path.
+
+	When \c false (default), each keyFrame is reached at its keyFrameTime(). When \c true, the
+	interpolationTime() is mapped to a distance along the path (firstTime() at the first keyFrame,
+	lastTime() at the last one, proportionally in between), using a precomputed arc-length table.
+	The keyFrameTime() of the intermediate keyFrames are then ignored. See pathLength(). */
+	bool constantSpeed() const { return constantSpeed_; }
 #ifndef DOXYGEN
 	/*! Whether or not (default) the path defined by the keyFrames is a closed loop. When \c true,
 	the last and the first KeyFrame are linked by a new spline segment.
@@ -251,6 +260,8 @@ public Q_SLOTS:
 	void setInterpolationPeriod(int period) { period_ = period; }
 	/*! Sets the loopInterpolation() value. */
 	void setLoopInterpolation(bool loop=true) { loopInterpolation_ = loop; }
+	/*! Sets the constantSpeed() value. */
+	void setConstantSpeed(bool constant=true) { constantSpeed_ = constant; }
 #ifndef DOXYGEN
 	/*! Sets the closedPath() value. \attention The closed path feature is not yet implemented. */
 	void setClosedPath(bool closed=true) { closedPath_ = closed; }
@@ -271,6 +282,9 @@ public Q_SLOTS:
 	/*! Calls startInterpolation() or stopInterpolation(), depending on interpolationIsStarted(). */
 	void toggleInterpolation() { if (interpolationIsStarted()) stopInterpolation(); else startInterpolation(); }
 	virtual void interpolateAtTime(qreal time);
+public:
+	void getFramesAtTimes(const QVector<qreal>& times, QVector<Vec>& positions, QVector<Quaternion>& orientations);
+	qreal pathLength();
 	//@}
 
 	/*! @name Path drawing */
@@ -288,7 +302,7 @@ public:
 
 private Q_SLOTS:
 	virtual void update();
-	virtual void invalidateValues() { valuesAreValid_ = false; pathIsValid_ = false; splineCacheIsValid_ = false; }
+	virtual void invalidateValues() { valuesAreValid_ = false; pathIsValid_ = false; }
 
 private:
 	// Copy constructor and opertor= are declared private and undefined
@@ -296,9 +310,11 @@ private:
 	// KeyFrameInterpolator(const KeyFrameInterpolator& kfi);
 	// KeyFrameInterpolator& operator=(const KeyFrameInterpolator& kfi);
 
-	void updateCurrentKeyFrameForTime(qreal time);
 	void updateModifiedFrameValues();
-	void updateSplineCache();
+	void updateArcLengthTable();
+	void updatePathGeometry(int mask, int nbFrames, qreal scale);
+	void segmentAtTime(qreal time, int& segment, qreal& alpha);
+	void evaluate(int segment, qreal alpha, Vec& position, Quaternion& orientation) const;
 
 #ifndef DOXYGEN
 	// Internal private KeyFrame representation
@@ -323,12 +339,35 @@ private:
 		qreal time_;
 		const Frame* const frame_;
 	};
+
+	// Hermite spline coefficients of the path between two successive keyFrames:
+	// position(alpha) = p + alpha * (tgP + alpha * (v1 + alpha * v2)), alpha in [0,1]
+	struct Segment
+	{
+		Vec p, tgP, v1, v2;
+		Quaternion q1, tgQ1, tgQ2, q2;
+	};
 #endif
 
 	// K e y F r a m e s
 	mutable QList<KeyFrame*> keyFrame_;
-	QMutableListIterator<KeyFrame*>* currentFrame_[4];
 	QList<Frame> path_;
+	// drawPath() geometry baked from path_: polyline, cameras and axis letters (current color),
+	// colored axis arrows. See updatePathGeometry().
+	RetainedGeometry* pathGeometry_;
+	RetainedGeometry* axisGeometry_;
+	int geometryMask_;
+	int geometryNbFrames_;
+	qreal geometryScale_;
+
+	// F l a t t e n e d   p a t h   (see updateModifiedFrameValues())
+	// times_[i] is keyFrame_[i]->time(), segments_[i] goes from keyFrame i to i+1
+	QVector<qreal> times_;
+	QVector<Segment> segments_;
+	// Cumulated path length at nbArcLengthSamples regular alpha steps per segment
+	QVector<qreal> arcLength_;
+	// Segment of the previous segmentAtTime(), tested first
+	int currentSegment_;
 
 	// A s s o c i a t e d   f r a m e
 	Frame* frame_;
@@ -343,13 +382,13 @@ private:
 	// M i s c
 	bool closedPath_;
 	bool loopInterpolation_;
+	bool constantSpeed_;
 
 	// C a c h e d   v a l u e s   a n d   f l a g s
 	bool pathIsValid_;
 	bool valuesAreValid_;
-	bool currentFrameValid_;
-	bool splineCacheIsValid_;
-	Vec v1, v2;
+	bool arcLengthIsValid_;
+	bool geometryIsValid_;
 };
 
 } // namespace qglviewer
@@ -97,6 +97,28 @@ void ManipulatedFrame::checkIfGrabsMouse(int x, int y, const Camera* const camer
 	setGrabsMouse(keepsGrabbingMouse_ || ((fabs(x-proj.x) < thresold) && (fabs(y-proj.y) < thresold)));
 }
 
+/*! Implementation of MouseGrabber::screenRegion(), consistent with checkIfGrabsMouse(): the 10 pixels
+region around the projected position().
+
+Returns \c false while the ManipulatedFrame keeps grabbing the mouse (after a mousePressEvent()) or when
+the projection is not a finite screen position. */
+bool ManipulatedFrame::screenRegion(const Camera* const camera, QRect& region) const
+{
+	if (keepsGrabbingMouse_)
+		return false;
+
+	const int thresold = 10;
+	const Vec proj = camera->projectedCoordinatesOf(position());
+	// Also rejects NaN
+	if (!(fabs(proj.x) < 1E6 && fabs(proj.y) < 1E6))
+		return false;
+
+	const int x0 = int(floor(proj.x)) - thresold;
+	const int y0 = int(floor(proj.y)) - thresold;
+	region = QRect(x0, y0, 2*thresold+2, 2*thresold+2);
+	return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //          S t a t e   s a v i n g   a n d   r e s t o r i n g               //
 ////////////////////////////////////////////////////////////////////////////////
@@ -307,7 +329,11 @@ void ManipulatedFrame::mousePressEvent(QMouseEvent* const event, Camera* const c
 	Q_UNUSED(camera);
 
 	if (grabsMouse())
+	{
 		keepsGrabbingMouse_ = true;
+		// screenRegion() is no longer bounded
+		screenRegionsModified();
+	}
 
 	// #CONNECTION setMouseBinding
 	// action_ should no longer possibly be NO_MOUSE_ACTION since this value is not inserted in mouseBinding_
@@ -463,6 +489,8 @@ void ManipulatedFrame::mouseReleaseEvent(QMouseEvent* const event, Camera* const
 	Q_UNUSED(event);
 	Q_UNUSED(camera);
 
+	if (keepsGrabbingMouse_)
+		screenRegionsModified();
 	keepsGrabbingMouse_ = false;
 
 	if (previousConstraint_)
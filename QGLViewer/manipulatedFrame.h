@@ -272,6 +272,7 @@ public:
 	//@{
 public:
 	virtual void checkIfGrabsMouse(int x, int y, const Camera* const camera);
+	virtual bool screenRegion(const Camera* const camera, QRect& region) const;
 	//@}
 
 	/*! @name XML representation */
@@ -26,6 +26,7 @@ using namespace qglviewer;
 
 // Static private variable
 QList<MouseGrabber*> MouseGrabber::MouseGrabberPool_;
+unsigned long MouseGrabber::poolVersion_ = 0;
 
 /*! Default constructor.
 
@@ -47,7 +48,10 @@ isInMouseGrabberPool() to know the current state of the MouseGrabber. */
 void MouseGrabber::addInMouseGrabberPool()
 {
 	if (!isInMouseGrabberPool())
+	{
 		MouseGrabber::MouseGrabberPool_.append(this);
+		++MouseGrabber::poolVersion_;
+	}
 }
 
 /*! Removes the MouseGrabber from the MouseGrabberPool().
@@ -57,7 +61,10 @@ has no effect. */
 void MouseGrabber::removeFromMouseGrabberPool()
 {
 	if (isInMouseGrabberPool())
+	{
 		MouseGrabber::MouseGrabberPool_.removeAll(const_cast<MouseGrabber*>(this));
+		++MouseGrabber::poolVersion_;
+	}
 }
 
 /*! Clears the MouseGrabberPool().
@@ -73,4 +80,14 @@ void MouseGrabber::clearMouseGrabberPool(bool autoDelete)
 	if (autoDelete)
 		qDeleteAll(MouseGrabber::MouseGrabberPool_);
 	MouseGrabber::MouseGrabberPool_.clear();
+	++MouseGrabber::poolVersion_;
+}
+
+/*! Forces the QGLViewers to rebuild their screen index of the MouseGrabberPool().
+
+Call this method when the screenRegion() of a MouseGrabber changed for a reason that is not a Camera
+or a Frame modification. */
+void MouseGrabber::screenRegionsModified()
+{
+	++MouseGrabber::poolVersion_;
 }
@@ -26,6 +26,7 @@
 #include "config.h"
 
 #include <QEvent>
+#include <QRect>
 
 class QGLViewer;
 
@@ -136,7 +137,7 @@ class QGLVIEWER_EXPORT MouseGrabber
 public:
 	MouseGrabber();
 	/*! Virtual destructor. Removes the MouseGrabber from the MouseGrabberPool(). */
-	virtual ~MouseGrabber() { MouseGrabber::MouseGrabberPool_.removeAll(this); }
+	virtual ~MouseGrabber() { MouseGrabber::MouseGrabberPool_.removeAll(this); ++MouseGrabber::poolVersion_; }
 
 	/*! @name Mouse grabbing detection */
 	//@{
@@ -173,6 +174,22 @@ public:
 	href="../examples/mouseGrabber.html">mouseGrabber example</a>. */
 	virtual void checkIfGrabsMouse(int x, int y, const Camera* const camera) = 0;
 
+	/*! Returns in \p region the screen rectangle (in pixels, Qt coordinate system) out of which
+	checkIfGrabsMouse() can not setGrabsMouse() to \c true for this \p camera.
+
+	The QGLViewer uses these regions to index the MouseGrabberPool() on screen, so that on each mouse
+	move only the MouseGrabbers whose region contains the cursor are tested with checkIfGrabsMouse().
+	The index is rebuilt when the Camera, a Frame (see Frame::globalGeneration()) or the
+	MouseGrabberPool() is modified.
+
+	Returns \c false (default) when the region is unknown: the MouseGrabber is then always tested.
+	When you overload this method, the region must only depend on the \p camera and on Frame
+	positions, or you must call screenRegionsModified() when it changes. An overloaded
+	checkIfGrabsMouse() must be consistent with screenRegion(). */
+	virtual bool screenRegion(const Camera* const camera, QRect& region) const { Q_UNUSED(camera); Q_UNUSED(region); return false; }
+
+	static void screenRegionsModified();
+
 	/*! Returns \c true when the MouseGrabber grabs the QGLViewer's mouse events.
 
 	This flag is set with setGrabsMouse() by the checkIfGrabsMouse() method. */
@@ -257,6 +274,12 @@ private:
 
 	// Q G L V i e w e r   p o o l
 	static QList<MouseGrabber*> MouseGrabberPool_;
+	// Incremented when the pool or the screenRegion() of its MouseGrabbers change
+	static unsigned long poolVersion_;
+
+#ifndef DOXYGEN
+	friend class MouseGrabberIndex;
+#endif
 };
 
 } // namespace qglviewer
@@ -0,0 +1,178 @@
+/****************************************************************************
+
+ Copyright (C) 2002-2014 Gilles Debunne. All rights reserved.
+
+ This file is part of the QGLViewer library version 2.6.3.
+
+ http://www.libqglviewer.com - contact@libqglviewer.com
+
+ This file may be used under the terms of the GNU General Public License
+ versions 2.0 or 3.0 as published by the Free Software Foundation and
+ appearing in the LICENSE file included in the packaging of this file.
+ In addition, as a special exception, Gilles Debunne gives you certain
+ additional rights, described in the file GPL_EXCEPTION in this package.
+
+ libQGLViewer uses dual licensing. Commercial/proprietary software must
+ purchase a libQGLViewer Commercial License.
+
+ This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+
+*****************************************************************************/
+
+#include "mouseGrabberIndex.h"
+#include "mouseGrabber.h"
+#include "camera.h"
+#include "frame.h"
+
+#include <algorithm>
+
+using namespace qglviewer;
+
+MouseGrabberIndex::MouseGrabberIndex()
+	: originX_(0), originY_(0), nbX_(0), nbY_(0),
+	  built_(false), camera_(NULL), cameraVersion_(0), frameGeneration_(0), poolVersion_(0),
+	  width_(0), height_(0)
+{}
+
+/*! Returns \c true when nothing that can move a MouseGrabber::screenRegion() changed since the
+ last rebuild(). */
+bool MouseGrabberIndex::isUpToDate(const Camera* const camera) const
+{
+	return built_ &&
+		   (camera == camera_) &&
+		   (MouseGrabber::poolVersion_ == poolVersion_) &&
+		   (Frame::globalGeneration() == frameGeneration_) &&
+		   (camera->matricesVersion() == cameraVersion_) &&
+		   (camera->screenWidth() == width_) && (camera->screenHeight() == height_);
+}
+
+/*! Rebuilds the grid from the current MouseGrabberPool() and \p camera.
+
+ The grid covers the viewport extended by one cell on each side. Regions that do not overlap it are
+ not stored: the cursor can only reach them from outside the grid, where candidates() returns the
+ whole pool. */
+void MouseGrabberIndex::rebuild(const Camera* const camera)
+{
+	if (MouseGrabber::poolVersion_ != poolVersion_)
+		// Indexes (and possibly pointers) of the previous pool are no longer valid
+		grabbing_.clear();
+
+	// Read before the regions are computed: matricesVersion() updates the Camera matrices used by
+	// Camera::projectedCoordinatesOf().
+	camera_          = camera;
+	cameraVersion_   = camera->matricesVersion();
+	poolVersion_     = MouseGrabber::poolVersion_;
+	width_           = camera->screenWidth();
+	height_          = camera->screenHeight();
+	grabbers_        = MouseGrabber::MouseGrabberPool();
+
+	originX_ = -cellSize_;
+	originY_ = -cellSize_;
+	nbX_ = (width_  + cellSize_ - 1) / cellSize_ + 2;
+	nbY_ = (height_ + cellSize_ - 1) / cellSize_ + 2;
+
+	const int nb = grabbers_.size();
+	// Cell range of each grabber, x0 > x1 when not stored
+	QVector<int> range(4*nb);
+	QVector<int> count(nbX_*nbY_ + 1, 0);
+	unbounded_.clear();
+
+	for (int i=0; i<nb; ++i)
+	{
+		int* r = range.data() + 4*i;
+		r[0] = 1; r[1] = 0;
+
+		QRect region;
+		if (!grabbers_.at(i)->screenRegion(camera, region))
+		{
+			unbounded_.append(i);
+			continue;
+		}
+
+		const int x0 = std::max(0, (region.left()   - originX_) / cellSize_);
+		const int y0 = std::max(0, (region.top()    - originY_) / cellSize_);
+		const int x1 = std::min(nbX_-1, (region.right()  - originX_) / cellSize_);
+		const int y1 = std::min(nbY_-1, (region.bottom() - originY_) / cellSize_);
+		if (region.right() < originX_ || region.bottom() < originY_ || x0 > x1 || y0 > y1)
+			continue;
+
+		r[0] = x0; r[1] = x1; r[2] = y0; r[3] = y1;
+		for (int y=y0; y<=y1; ++y)
+			for (int x=x0; x<=x1; ++x)
+				++count[y*nbX_ + x];
+	}
+
+	// Prefix sum, then fill in pool order so that each cell list is sorted
+	cellStart_.resize(nbX_*nbY_ + 1);
+	int total = 0;
+	for (int c=0; c<nbX_*nbY_; ++c)
+	{
+		cellStart_[c] = total;
+		total += count[c];
+		count[c] = cellStart_[c];
+	}
+	cellStart_[nbX_*nbY_] = total;
+	cellItems_.resize(total);
+
+	for (int i=0; i<nb; ++i)
+	{
+		const int* r = range.constData() + 4*i;
+		for (int y=r[2]; r[0]<=r[1] && y<=r[3]; ++y)
+			for (int x=r[0]; x<=r[1]; ++x)
+				cellItems_[count[y*nbX_ + x]++] = i;
+	}
+
+	// Frames may have been read (and caches updated) but not modified: the value is stable
+	frameGeneration_ = Frame::globalGeneration();
+	built_ = true;
+}
+
+/*! Fills \p result with the MouseGrabbers of the MouseGrabberPool() that may grab the mouse at
+ (\p x, \p y) for \p camera, in MouseGrabberPool() order.
+
+ These are the MouseGrabbers whose screenRegion() contains the cursor, the ones without region and
+ the ones returned by the previous call that still grabsMouse(). The whole pool is returned when the
+ cursor is outside of the indexed area. */
+void MouseGrabberIndex::candidates(int x, int y, const Camera* const camera, QList<MouseGrabber*>& result)
+{
+	result.clear();
+
+	if (!isUpToDate(camera))
+		rebuild(camera);
+
+	const int cx = (x - originX_) / cellSize_;
+	const int cy = (y - originY_) / cellSize_;
+	if (x < originX_ || y < originY_ || cx >= nbX_ || cy >= nbY_)
+	{
+		result = grabbers_;
+		grabbing_.clear();
+		for (int i=0; i<grabbers_.size(); ++i)
+			grabbing_.append(i);
+		return;
+	}
+
+	// Previous candidates that still grab
+	QVector<int> grabbing;
+	Q_FOREACH (int i, grabbing_)
+		if (grabbers_.at(i)->grabsMouse())
+			grabbing.append(i);
+
+	const int c = cy*nbX_ + cx;
+	const int* cellBegin = cellItems_.constData() + cellStart_[c];
+	const int* cellEnd   = cellItems_.constData() + cellStart_[c+1];
+
+	QVector<int> merged(int(cellEnd - cellBegin) + unbounded_.size());
+	std::merge(cellBegin, cellEnd, unbounded_.constBegin(), unbounded_.constEnd(), merged.begin());
+
+	QVector<int> indexes(merged.size() + grabbing.size());
+	QVector<int>::iterator end = std::set_union(merged.constBegin(), merged.constEnd(),
+												grabbing.constBegin(), grabbing.constEnd(), indexes.begin());
+	indexes.resize(int(end - indexes.begin()));
+
+	for (QVector<int>::const_iterator it=indexes.constBegin(), itEnd=indexes.constEnd(); it != itEnd; ++it)
+		result.append(grabbers_.at(*it));
+
+	// Remembered for the next call, filtered on grabsMouse() then
+	grabbing_ = indexes;
+}
@@ -0,0 +1,84 @@
+/****************************************************************************
+
+ Copyright (C) 2002-2014 Gilles Debunne. All rights reserved.
+
+ This file is part of the QGLViewer library version 2.6.3.
+
+ http://www.libqglviewer.com - contact@libqglviewer.com
+
+ This file may be used under the terms of the GNU General Public License
+ versions 2.0 or 3.0 as published by the Free Software Foundation and
+ appearing in the LICENSE file included in the packaging of this file.
+ In addition, as a special exception, Gilles Debunne gives you certain
+ additional rights, described in the file GPL_EXCEPTION in this package.
+
+ libQGLViewer uses dual licensing. Commercial/proprietary software must
+ purchase a libQGLViewer Commercial License.
+
+ This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+
+*****************************************************************************/
+
+#ifndef QGLVIEWER_MOUSE_GRABBER_INDEX_H
+#define QGLVIEWER_MOUSE_GRABBER_INDEX_H
+
+#include "config.h"
+#include <QVector>
+
+namespace qglviewer {
+class Camera;
+class MouseGrabber;
+
+/*! \brief Screen space grid of the MouseGrabber::MouseGrabberPool(), used by QGLViewer::mouseMoveEvent().
+  \class MouseGrabberIndex mouseGrabberIndex.h QGLViewer/mouseGrabberIndex.h
+
+  Each MouseGrabber with a MouseGrabber::screenRegion() is stored in the grid cells its region
+  overlaps. candidates() returns the MouseGrabbers of the cell under the cursor, plus the ones without
+  region, in MouseGrabberPool() order.
+
+  The grid is rebuilt lazily, when the Camera matrices or viewport, a Frame (see
+  Frame::globalGeneration()) or the MouseGrabberPool() changed since the last build.
+
+  Internal class, not installed. */
+class MouseGrabberIndex
+{
+public:
+	MouseGrabberIndex();
+
+	void candidates(int x, int y, const Camera* const camera, QList<MouseGrabber*>& result);
+
+private:
+	bool isUpToDate(const Camera* const camera) const;
+	void rebuild(const Camera* const camera);
+
+	// Side of a grid cell, in pixels
+	static const int cellSize_ = 32;
+
+	// Snapshot of the pool at build time
+	QList<MouseGrabber*> grabbers_;
+	// Cell c lists the indexes cellItems_[cellStart_[c]..cellStart_[c+1][ in grabbers_
+	QVector<int> cellStart_;
+	QVector<int> cellItems_;
+	// Indexes of the grabbers without screenRegion(), always tested
+	QVector<int> unbounded_;
+	// Candidates that grabbed the mouse at the previous query: tested again so that their
+	// grabsMouse() flag is released when the cursor leaves them
+	QVector<int> grabbing_;
+
+	// Grid covers [originX_, originX_+nbX_*cellSize_[ x [originY_, originY_+nbY_*cellSize_[
+	int originX_, originY_;
+	int nbX_, nbY_;
+
+	// Build state
+	bool built_;
+	const Camera* camera_;
+	unsigned long cameraVersion_;
+	unsigned long frameGeneration_;
+	unsigned long poolVersion_;
+	int width_, height_;
+};
+
+} // namespace qglviewer
+
+#endif // QGLVIEWER_MOUSE_GRABBER_INDEX_H
@@ -23,8 +23,12 @@
 #include "domUtils.h"
 #include "qglviewer.h"
 #include "camera.h"
+#include "frameCapture.h"
 #include "keyFrameInterpolator.h"
 #include "manipulatedCameraFrame.h"
+#include "mouseGrabberIndex.h"
+#include "retainedGeometry.h"
+#include "textRenderer.h"
 
 # include <QtAlgorithms>
 # include <QTextEdit>
@@ -104,6 +108,9 @@ void QGLViewer::defaultConstructor()
 	manipulatedFrameIsACamera_ = false;
 	mouseGrabberIsAManipulatedFrame_ = false;
 	mouseGrabberIsAManipulatedCameraFrame_ = false;
+	mouseGrabberIndex_ = new MouseGrabberIndex();
+	visualHintsGeometry_ = new RetainedGeometry();
+	textRenderer_ = new TextRenderer();
 	displayMessage_ = false;
 	connect(&messageTimer_, SIGNAL(timeout()), SLOT(hideMessage()));
 	messageTimer_.setSingleShot(true);
@@ -129,6 +136,17 @@ void QGLViewer::defaultConstructor()
 	stopAnimation();
 	setAnimationPeriod(40); // 25Hz
 
+	renderOnDemand_ = false;
+	maximumFrameRate_ = 0;
+	idleAnimationPeriod_ = 250;
+	redrawRequested_ = false;
+	redrawPending_ = false;
+	animationGeneration_ = Frame::globalGeneration();
+	idleAnimationSteps_ = 0;
+	redrawTimer_.setSingleShot(true);
+	connect(&redrawTimer_, SIGNAL(timeout()), SLOT(pacedRedraw()));
+	lastFrameTime_.start();
+
 	selectBuffer_ = NULL;
 	setSelectBufferSize(4*1000);
 	setSelectRegionWidth(3);
@@ -147,6 +165,10 @@ void QGLViewer::defaultConstructor()
 	setAttribute(Qt::WA_NoSystemBackground);
 
 	tileRegion_ = NULL;
+	frameCapture_ = new FrameCapture();
+	captureFlushTimer_.setSingleShot(true);
+	captureFlushTimer_.setInterval(200);
+	connect(&captureFlushTimer_, SIGNAL(timeout()), SLOT(flushCapture()));
 }
 
 #if !defined QT3_SUPPORT
@@ -191,6 +213,14 @@ QGLViewer::~QGLViewer()
 
 	delete camera();
 	delete[] selectBuffer_;
+	delete mouseGrabberIndex_;
+	// Text textures and vertex buffers are released in their context
+	makeCurrent();
+	frameCapture_->flush();
+	frameCapture_->releaseBuffers();
+	delete frameCapture_;
+	delete textRenderer_;
+	delete visualHintsGeometry_;
 	if (helpWidget())
 	{
 		// Needed for Qt 4 which has no main widget.
@@ -274,6 +304,12 @@ Calls the following methods, in that order:
 \arg postDraw() : display of visual hints (world axis, FPS...) */
 void QGLViewer::paintGL()
 {
+	// Invalidations received from now on need a new frame
+	redrawRequested_ = false;
+	redrawPending_ = false;
+	redrawTimer_.stop();
+	lastFrameTime_.restart();
+
 	if (displaysInStereo())
 	{
 		for (int view=1; view>=0; --view)
@@ -286,6 +322,7 @@ void QGLViewer::paintGL()
 			else
 				draw();
 //			postDraw();
+			flushText();
 		}
 	}
 	else
@@ -299,7 +336,10 @@ void QGLViewer::paintGL()
 			draw();
 		// Add visual hints: axis, camera, grid...
 //		postDraw();
+		flushText();
 	}
+	// Frames modified while drawing are displayed: only later changes make the frame dirty
+	animationGeneration_ = Frame::globalGeneration();
 	Q_EMIT drawFinished(true);
 }
 
@@ -322,6 +362,8 @@ void QGLViewer::preDraw()
 	camera()->loadProjectionMatrix();
 	// GL_MODELVIEW matrix
 	camera()->loadModelViewMatrix();
+	// Same matrices for the core profile retained drawing helpers
+	RetainedGeometry::setCoreState(camera()->modelViewProjectionMatrixf(), camera()->modelViewMatrixf(), foregroundColor());
 
 	Q_EMIT drawNeeded();
 }
@@ -338,33 +380,39 @@ draw(), the user can rely on the OpenGL context he defined. Respect this convent
 different attributes) if you overload this method. */
 void QGLViewer::postDraw()
 {
-	// Reset model view matrix to world coordinates origin
-	glMatrixMode(GL_MODELVIEW);
-	glPushMatrix();
-	camera()->loadModelViewMatrix();
-	// TODO restore model loadProjectionMatrixStereo
+	// No fixed pipeline state in core profile: the helpers use the preDraw() matrices
+	const bool coreProfile = RetainedGeometry::isCoreProfile();
 
-	// Save OpenGL state
-	glPushAttrib(GL_ALL_ATTRIB_BITS);
+	if (!coreProfile)
+	{
+		// Reset model view matrix to world coordinates origin
+		glMatrixMode(GL_MODELVIEW);
+		glPushMatrix();
+		camera()->loadModelViewMatrix();
+		// TODO restore model loadProjectionMatrixStereo
+
+		// Save OpenGL state
+		glPushAttrib(GL_ALL_ATTRIB_BITS);
 
-	// Set neutral GL state
-	glDisable(GL_TEXTURE_1D);
-	glDisable(GL_TEXTURE_2D);
+		// Set neutral GL state
+		glDisable(GL_TEXTURE_1D);
+		glDisable(GL_TEXTURE_2D);
 #ifdef GL_TEXTURE_3D  // OpenGL 1.2 Only...
-	glDisable(GL_TEXTURE_3D);
+		glDisable(GL_TEXTURE_3D);
 #endif
 
-	glDisable(GL_TEXTURE_GEN_Q);
-	glDisable(GL_TEXTURE_GEN_R);
-	glDisable(GL_TEXTURE_GEN_S);
-	glDisable(GL_TEXTURE_GEN_T);
+		glDisable(GL_TEXTURE_GEN_Q);
+		glDisable(GL_TEXTURE_GEN_R);
+		glDisable(GL_TEXTURE_GEN_S);
+		glDisable(GL_TEXTURE_GEN_T);
 
 #ifdef GL_RESCALE_NORMAL  // OpenGL 1.2 Only...
-	glEnable(GL_RESCALE_NORMAL);
+		glEnable(GL_RESCALE_NORMAL);
 #endif
 
-	glDisable(GL_COLOR_MATERIAL);
-	qglColor(foregroundColor());
+		glDisable(GL_COLOR_MATERIAL);
+		qglColor(foregroundColor());
+	}
 
 	if (cameraIsEdited())
 		camera()->drawAllPaths();
@@ -372,8 +420,8 @@ void QGLViewer::postDraw()
 	// Pivot point, line when camera rolls, zoom region
 	drawVisualHints();
 
-	if (gridIsDrawn()) { glLineWidth(1.0); drawGrid(camera()->sceneRadius()); }
-	if (axisIsDrawn()) { glLineWidth(2.0); drawAxis(camera()->sceneRadius()); }
+	if (gridIsDrawn()) { if (!coreProfile) glLineWidth(1.0); drawGrid(camera()->sceneRadius()); }
+	if (axisIsDrawn()) { if (!coreProfile) glLineWidth(2.0); drawAxis(camera()->sceneRadius()); }
 
 	// FPS computation
 	const unsigned int maxCounter = 20;
@@ -384,6 +432,14 @@ void QGLViewer::postDraw()
 		fpsCounter_ = 0;
 	}
 
+	if (coreProfile)
+	{
+		if (FPSIsDisplayed()) displayFPS();
+		if (displayMessage_) drawText(10, height()-10,  message_);
+		flushText();
+		return;
+	}
+
 	// Restore foregroundColor
 	float color[4];
 	color[0] = foregroundColor().red()   / 255.0f;
@@ -400,6 +456,8 @@ void QGLViewer::postDraw()
 	// Restore GL state
 	glPopAttrib();
 	glPopMatrix();
+
+	flushText();
 }
 
 /*! Called before draw() (instead of preDraw()) when viewer displaysInStereo().
@@ -607,12 +665,12 @@ void QGLViewer::setCamera(Camera* const camera)
 	camera->setScreenWidthAndHeight(width(), height());
 
 	// Disconnect current camera from this viewer.
-	disconnect(this->camera()->frame(), SIGNAL(manipulated()), this, SLOT(update()));
-	disconnect(this->camera()->frame(), SIGNAL(spun()), this, SLOT(update()));
+	disconnect(this->camera()->frame(), SIGNAL(manipulated()), this, SLOT(requestRedraw()));
+	disconnect(this->camera()->frame(), SIGNAL(spun()), this, SLOT(requestRedraw()));
 
 	// Connect camera frame to this viewer.
-	connect(camera->frame(), SIGNAL(manipulated()), SLOT(update()));
-	connect(camera->frame(), SIGNAL(spun()), SLOT(update()));
+	connect(camera->frame(), SIGNAL(manipulated()), SLOT(requestRedraw()));
+	connect(camera->frame(), SIGNAL(spun()), SLOT(requestRedraw()));
 
 	connectAllCameraKFIInterpolatedSignals(false);
 	camera_ = camera;
@@ -626,15 +684,15 @@ void QGLViewer::connectAllCameraKFIInterpolatedSignals(bool connection)
 	for (QMap<unsigned int, KeyFrameInterpolator*>::ConstIterator it = camera()->kfi_.begin(), end=camera()->kfi_.end(); it != end; ++it)
 	{
 		if (connection)
-			connect(camera()->keyFrameInterpolator(it.key()), SIGNAL(interpolated()), SLOT(update()));
+			connect(camera()->keyFrameInterpolator(it.key()), SIGNAL(interpolated()), SLOT(requestRedraw()));
 		else
-			disconnect(camera()->keyFrameInterpolator(it.key()), SIGNAL(interpolated()), this, SLOT(update()));
+			disconnect(camera()->keyFrameInterpolator(it.key()), SIGNAL(interpolated()), this, SLOT(requestRedraw()));
 	}
 
 	if (connection)
-		connect(camera()->interpolationKfi_, SIGNAL(interpolated()), SLOT(update()));
+		connect(camera()->interpolationKfi_, SIGNAL(interpolated()), SLOT(requestRedraw()));
 	else
-		disconnect(camera()->interpolationKfi_, SIGNAL(interpolated()), this, SLOT(update()));
+		disconnect(camera()->interpolationKfi_, SIGNAL(interpolated()), this, SLOT(requestRedraw()));
 }
 
 /*! Draws a representation of \p light.
@@ -714,7 +772,8 @@ upper left corner of the widget).
 The default QApplication::font() is used to render the text when no \p fnt is specified. Use
 QApplication::setFont() to define this default font.
 
-You should disable \c GL_LIGHTING and \c GL_DEPTH_TEST before this method so that colors are properly rendered.
+The text is drawn with the current \c glColor (foregroundColor() with an OpenGL core profile
+context), always on top of the scene.
 
 This method can be used in conjunction with the qglviewer::Camera::projectedCoordinatesOf()
 method to display a text attached to an object. In your draw() method use:
@@ -723,31 +782,70 @@ qglviewer::Vec screenPos = camera()->projectedCoordinatesOf(myFrame.position());
 drawText((int)screenPos[0], (int)screenPos[1], "My Object");
 \endcode
 See the <a href="../examples/screenCoordSystem.html">screenCoordSystem example</a> for an illustration.
+The drawText(const qglviewer::Vec&, const QString&, const QFont&) overload does this for you.
 
 Text is displayed only when textIsEnabled() (default). This mechanism allows the user to
 conveniently remove all the displayed text with a single keyboard shortcut.
 
 See also displayMessage() to drawText() for only a short amount of time.
 
-Use QGLWidget::renderText(x,y,z, text) instead if you want to draw a text located
- at a specific 3D position instead of 2D screen coordinates (fixed size text, facing the camera).
+The characters are taken from a glyph texture, rasterized once per font. Texts are not drawn
+immediately: they are batched and all drawn at the end of the frame (after draw() and postDraw())
+with one \c glDrawArrays per font. The OpenGL state, \c GL_MODELVIEW and \c GL_PROJECTION
+matrices are not modified by this method. */
+void QGLViewer::drawText(int x, int y, const QString& text, const QFont& fnt)
+{
+	if (!textIsEnabled())
+		return;
 
-The \c GL_MODELVIEW and \c GL_PROJECTION matrices are not modified by this method.
+	addText(x, y, 0.0, text, fnt);
+}
 
-\attention This method uses display lists to render the characters, with an index that starts at
-2000 by default (see the QGLWidget::renderText() documentation). If you use more than 2000 Display
-Lists, they may overlap with these. Directly use QGLWidget::renderText() in that case, with a
-higher \c listBase parameter (or overload <code>fontDisplayListBase</code>).*/
-void QGLViewer::drawText(int x, int y, const QString& text, const QFont& fnt)
+/*! Draws \p text at the projection of the 3D \p position, expressed in the world coordinate system.
+
+The text has a fixed size and faces the camera. It starts at the projected point, with the depth of
+\p position: it is hidden by closer objects when \c GL_DEPTH_TEST is enabled at the end of the frame
+(it is not by default, see postDraw()). Nothing is drawn when \p position is behind the camera.
+
+See drawText(int, int, const QString&, const QFont&) for details. */
+void QGLViewer::drawText(const Vec& position, const QString& text, const QFont& fnt)
 {
 	if (!textIsEnabled())
 		return;
 
-	if (tileRegion_ != NULL) {
-		renderText(int((x-tileRegion_->xMin) * width() / (tileRegion_->xMax - tileRegion_->xMin)),
-				   int((y-tileRegion_->yMin) * height() / (tileRegion_->yMax - tileRegion_->yMin)), text, scaledFont(fnt));
-	} else
-		renderText(x, y, text, fnt);
+	const Vec proj = camera()->projectedCoordinatesOf(position);
+	if ((proj.z < 0.0) || (proj.z > 1.0))
+		return;
+
+	addText(proj.x, proj.y, proj.z, text, fnt);
+}
+
+/*! Adds \p text to the textRenderer_ batch, in the current color, at the (\p x, \p y) pixel
+position of the possibly tiled image. */
+void QGLViewer::addText(qreal x, qreal y, qreal depth, const QString& text, const QFont& fnt)
+{
+	QColor color;
+	if (RetainedGeometry::isCoreProfile())
+		color = foregroundColor();
+	else
+	{
+		GLfloat current[4];
+		glGetFloatv(GL_CURRENT_COLOR, current);
+		color = QColor::fromRgbF(current[0], current[1], current[2], current[3]);
+	}
+
+	if (tileRegion_ != NULL)
+		textRenderer_->addText((x-tileRegion_->xMin) * width() / (tileRegion_->xMax - tileRegion_->xMin),
+							   (y-tileRegion_->yMin) * height() / (tileRegion_->yMax - tileRegion_->yMin),
+							   depth, text, scaledFont(fnt), color);
+	else
+		textRenderer_->addText(x, y, depth, text, fnt, color);
+}
+
+/*! Draws the texts batched by drawText() since the previous call. */
+void QGLViewer::flushText()
+{
+	textRenderer_->draw(width(), height());
 }
 
 /*! Briefly displays a message in the lower left corner of the widget. Convenient to provide
@@ -858,16 +956,39 @@ void QGLViewer::stopScreenCoordinatesSystem() const
 	glPopMatrix();
 }
 
+// Unchanged animation steps before renderOnDemand() slows the animation timer down
+static const int maxIdleAnimationSteps = 10;
+
 /*! Overloading of the \c QObject method.
 
-If animationIsStarted(), calls animate() and draw(). */
+If animationIsStarted(), calls animate() and draw(). With renderOnDemand(), draw() is only called
+when animate() changed something, see renderOnDemand(). */
 void QGLViewer::timerEvent(QTimerEvent *)
 {
-	if (animationIsStarted())
+	if (!animationIsStarted())
+		return;
+
+	animate();
+
+	if (!renderOnDemand())
 	{
-		animate();
+		update();
+		return;
+	}
+
+	// Frames modified by animate() or explicit invalidation
+	const bool changed = redrawRequested_ || (Frame::globalGeneration() != animationGeneration_);
+	animationGeneration_ = Frame::globalGeneration();
+
+	if (changed)
+	{
+		if (idleAnimationSteps_ >= maxIdleAnimationSteps)
+			setAnimationTimerPeriod(animationPeriod());
+		idleAnimationSteps_ = 0;
 		update();
 	}
+	else if (++idleAnimationSteps_ == maxIdleAnimationSteps)
+		setAnimationTimerPeriod(qMax(animationPeriod(), idleAnimationPeriod()));
 }
 
 /*! Starts the animation loop. See animationIsStarted(). */
@@ -875,6 +996,8 @@ void QGLViewer::startAnimation()
 {
 	animationTimerId_ = startTimer(animationPeriod());
 	animationStarted_ = true;
+	animationGeneration_ = Frame::globalGeneration();
+	idleAnimationSteps_ = 0;
 }
 
 /*! Stops animation. See animationIsStarted(). */
@@ -883,6 +1006,59 @@ void QGLViewer::stopAnimation()
 	animationStarted_ = false;
 	if (animationTimerId_ != 0)
 		killTimer(animationTimerId_);
+	animationTimerId_ = 0;
+}
+
+/*! Restarts the animation timer with a new \p period, used by the renderOnDemand() idle throttling. */
+void QGLViewer::setAnimationTimerPeriod(int period)
+{
+	if (animationTimerId_ != 0)
+		killTimer(animationTimerId_);
+	animationTimerId_ = startTimer(period);
+}
+
+/*! Sets renderOnDemand(). A frame is drawn to reflect the current state. */
+void QGLViewer::setRenderOnDemand(bool onDemand)
+{
+	renderOnDemand_ = onDemand;
+	if (!onDemand && animationIsStarted() && (idleAnimationSteps_ >= maxIdleAnimationSteps))
+		setAnimationTimerPeriod(animationPeriod());
+	idleAnimationSteps_ = 0;
+	requestRedraw();
+}
+
+/*! Invalidates the display: a new frame will be drawn.
+
+Several calls before this frame is drawn result in a single frame. When maximumFrameRate() is set,
+the frame is delayed so that frames are at least 1/maximumFrameRate() second apart.
+
+The camera and manipulatedFrame() signals, as well as the KeyFrameInterpolator ones, are connected to
+this slot. Call it when your scene changes, especially with renderOnDemand(). */
+void QGLViewer::requestRedraw()
+{
+	redrawRequested_ = true;
+	if (redrawPending_)
+		return;
+	redrawPending_ = true;
+
+	// Leave the animation idle throttling at the next step
+	if (renderOnDemand() && animationIsStarted() && (idleAnimationSteps_ >= maxIdleAnimationSteps))
+	{
+		setAnimationTimerPeriod(animationPeriod());
+		idleAnimationSteps_ = 0;
+	}
+
+	const int minInterval = (maximumFrameRate() > 0) ? 1000 / maximumFrameRate() : 0;
+	const int wait = minInterval - lastFrameTime_.elapsed();
+	if (wait > 0)
+		redrawTimer_.start(wait);
+	else
+		update();
+}
+
+void QGLViewer::pacedRedraw()
+{
+	update();
 }
 
 /*! Overloading of the \c QWidget method.
@@ -1327,7 +1503,10 @@ void QGLViewer::mouseMoveEvent(QMouseEvent* e)
 			else
 				if (hasMouseTracking())
 				{
-					Q_FOREACH (MouseGrabber* mg, MouseGrabber::MouseGrabberPool())
+					// Only the MouseGrabbers whose screen region contains the cursor are tested
+					QList<MouseGrabber*> candidates;
+					mouseGrabberIndex_->candidates(e->x(), e->y(), camera(), candidates);
+					Q_FOREACH (MouseGrabber* mg, candidates)
 					{
 						mg->checkIfGrabsMouse(e->x(), e->y(), camera());
 						if (mg->grabsMouse())
@@ -2116,7 +2295,7 @@ void QGLViewer::keyPressEvent(QKeyEvent *e)
 				{
 					if (camera()->keyFrameInterpolator(index))
 					{
-						disconnect(camera()->keyFrameInterpolator(index), SIGNAL(interpolated()), this, SLOT(update()));
+						disconnect(camera()->keyFrameInterpolator(index), SIGNAL(interpolated()), this, SLOT(requestRedraw()));
 						if (camera()->keyFrameInterpolator(index)->numberOfKeyFrames() > 1)
 							displayMessage(tr("Path %1 deleted", "Feedback message").arg(index));
 						else
@@ -2129,7 +2308,7 @@ void QGLViewer::keyPressEvent(QKeyEvent *e)
 					bool nullBefore = (camera()->keyFrameInterpolator(index) == NULL);
 					camera()->addKeyFrameToPath(index);
 					if (nullBefore)
-						connect(camera()->keyFrameInterpolator(index), SIGNAL(interpolated()), SLOT(update()));
+						connect(camera()->keyFrameInterpolator(index), SIGNAL(interpolated()), SLOT(requestRedraw()));
 					int nbKF = camera()->keyFrameInterpolator(index)->numberOfKeyFrames();
 					if (nbKF > 1)
 						displayMessage(tr("Path %1, position %2 added", "Feedback message").arg(index).arg(nbKF));
@@ -3062,8 +3241,8 @@ void QGLViewer::setManipulatedFrame(ManipulatedFrame* frame)
 
 		if (manipulatedFrame() != camera()->frame())
 		{
-			disconnect(manipulatedFrame(), SIGNAL(manipulated()), this, SLOT(update()));
-			disconnect(manipulatedFrame(), SIGNAL(spun()), this, SLOT(update()));
+			disconnect(manipulatedFrame(), SIGNAL(manipulated()), this, SLOT(requestRedraw()));
+			disconnect(manipulatedFrame(), SIGNAL(spun()), this, SLOT(requestRedraw()));
 		}
 	}
 
@@ -3077,8 +3256,8 @@ void QGLViewer::setManipulatedFrame(ManipulatedFrame* frame)
 		// Prevent multiple connections, that would result in useless display updates
 		if (manipulatedFrame() != camera()->frame())
 		{
-			connect(manipulatedFrame(), SIGNAL(manipulated()), SLOT(update()));
-			connect(manipulatedFrame(), SIGNAL(spun()), SLOT(update()));
+			connect(manipulatedFrame(), SIGNAL(manipulated()), SLOT(requestRedraw()));
+			connect(manipulatedFrame(), SIGNAL(spun()), SLOT(requestRedraw()));
 		}
 	}
 }
@@ -3104,23 +3283,16 @@ Limitation : One needs to have access to visualHint_ to overload this method.
 Removed from the documentation for this reason. */
 void QGLViewer::drawVisualHints()
 {
+	visualHintsGeometry_->clear();
+
 	// Pivot point cross
 	if (visualHint_ & 1)
 	{
 		const qreal size = 15.0;
 		Vec proj = camera()->projectedCoordinatesOf(camera()->pivotPoint());
-		startScreenCoordinatesSystem();
-		glDisable(GL_LIGHTING);
-		glDisable(GL_DEPTH_TEST);
-		glLineWidth(3.0);
-		glBegin(GL_LINES);
-		glVertex2d(proj.x - size, proj.y);
-		glVertex2d(proj.x + size, proj.y);
-		glVertex2d(proj.x, proj.y - size);
-		glVertex2d(proj.x, proj.y + size);
-		glEnd();
-		glEnable(GL_DEPTH_TEST);
-		stopScreenCoordinatesSystem();
+		proj.z = 0.0;
+		visualHintsGeometry_->addLine(proj - Vec(size, 0.0, 0.0), proj + Vec(size, 0.0, 0.0));
+		visualHintsGeometry_->addLine(proj - Vec(0.0, size, 0.0), proj + Vec(0.0, size, 0.0));
 	}
 
 	// if (visualHint_ & 2)
@@ -3145,34 +3317,81 @@ void QGLViewer::drawVisualHints()
 	if (mf)
 	{
 		pnt = camera()->projectedCoordinatesOf(pnt);
-		startScreenCoordinatesSystem();
-		glDisable(GL_LIGHTING);
-		glDisable(GL_DEPTH_TEST);
-		glLineWidth(3.0);
-		glBegin(GL_LINES);
-		glVertex2d(pnt.x, pnt.y);
-		glVertex2i(mf->prevPos_.x(), mf->prevPos_.y());
-		glEnd();
-		glEnable(GL_DEPTH_TEST);
-		stopScreenCoordinatesSystem();
+		pnt.z = 0.0;
+		visualHintsGeometry_->addLine(pnt, Vec(mf->prevPos_.x(), mf->prevPos_.y(), 0.0));
 	}
 
+	drawScreenGeometry(visualHintsGeometry_, 3.0);
+
 	// Zoom on region: draw a rectangle
 	if (camera()->frame()->action_ == ZOOM_ON_REGION)
+	{
+		const QPoint& press = camera()->frame()->pressPos_;
+		const QPoint& prev  = camera()->frame()->prevPos_;
+		const Vec corners[5] = { Vec(press.x(), press.y(), 0.0), Vec(prev.x(), press.y(), 0.0),
+								 Vec(prev.x(), prev.y(), 0.0), Vec(press.x(), prev.y(), 0.0),
+								 Vec(press.x(), press.y(), 0.0) };
+		visualHintsGeometry_->clear();
+		visualHintsGeometry_->addLineStrip(corners, 5);
+		drawScreenGeometry(visualHintsGeometry_, 2.0);
+	}
+}
+
+/*! Fills \p matrix with the projection used by startScreenCoordinatesSystem(), in OpenGL (column
+major) order. */
+void QGLViewer::screenCoordinatesMatrix(GLfloat matrix[16], bool upward) const
+{
+	qreal left = 0.0, right = width(), bottom = height(), top = 0.0;
+	if (tileRegion_ != NULL)
+	{
+		left = tileRegion_->xMin;  right = tileRegion_->xMax;
+		bottom = tileRegion_->yMax;  top = tileRegion_->yMin;
+	}
+	if (upward)
+		qSwap(bottom, top);
+
+	// glOrtho(left, right, bottom, top, 0.0, -1.0)
+	for (int i=0; i<16; ++i)
+		matrix[i] = 0.0f;
+	matrix[0]  = GLfloat(2.0 / (right - left));
+	matrix[5]  = GLfloat(2.0 / (top - bottom));
+	matrix[10] = 2.0f;
+	matrix[12] = GLfloat(-(right + left) / (right - left));
+	matrix[13] = GLfloat(-(top + bottom) / (top - bottom));
+	matrix[14] = -1.0f;
+	matrix[15] = 1.0f;
+}
+
+/*! Draws \p geometry, defined in screen coordinates (see startScreenCoordinatesSystem()), on top of
+the scene with the current color. Lighting and depth test are disabled. */
+void QGLViewer::drawScreenGeometry(RetainedGeometry* geometry, GLfloat lineWidth) const
+{
+	if (geometry->isEmpty())
+		return;
+
+	glDisable(GL_DEPTH_TEST);
+	if (RetainedGeometry::isCoreProfile())
+	{
+		GLfloat modelViewProjection[16], modelView[16];
+		QColor color;
+		RetainedGeometry::getCoreState(modelViewProjection, modelView, color);
+
+		GLfloat screen[16];
+		const GLfloat identity[16] = { 1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1 };
+		screenCoordinatesMatrix(screen, false);
+		RetainedGeometry::setCoreState(screen, identity, color);
+		geometry->draw();
+		RetainedGeometry::setCoreState(modelViewProjection, modelView, color);
+	}
+	else
 	{
 		startScreenCoordinatesSystem();
 		glDisable(GL_LIGHTING);
-		glDisable(GL_DEPTH_TEST);
-		glLineWidth(2.0);
-		glBegin(GL_LINE_LOOP);
-		glVertex2i(camera()->frame()->pressPos_.x(), camera()->frame()->pressPos_.y());
-		glVertex2i(camera()->frame()->prevPos_.x(),  camera()->frame()->pressPos_.y());
-		glVertex2i(camera()->frame()->prevPos_.x(),  camera()->frame()->prevPos_.y());
-		glVertex2i(camera()->frame()->pressPos_.x(), camera()->frame()->prevPos_.y());
-		glEnd();
-		glEnable(GL_DEPTH_TEST);
+		glLineWidth(lineWidth);
+		geometry->draw();
 		stopScreenCoordinatesSystem();
 	}
+	glEnable(GL_DEPTH_TEST);
 }
 
 /*! Defines the mask that will be used to drawVisualHints(). The only available mask is currently 1,
@@ -3195,6 +3414,108 @@ void QGLViewer::resetVisualHints()
 //       A x i s   a n d   G r i d   d i s p l a y   l i s t s                //
 ////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+enum HelperGeometryKind { ARROW_GEOMETRY, AXIS_ARROWS_GEOMETRY, AXIS_LETTERS_GEOMETRY, GRID_GEOMETRY };
+
+struct HelperGeometryKey
+{
+	int kind;
+	qreal size, radius;
+	int nbSubdivisions;
+
+	bool operator<(const HelperGeometryKey& other) const
+	{
+		if (kind != other.kind) return kind < other.kind;
+		if (size != other.size) return size < other.size;
+		if (radius != other.radius) return radius < other.radius;
+		return nbSubdivisions < other.nbSubdivisions;
+	}
+};
+
+struct HelperGeometryEntry
+{
+	RetainedGeometry* geometry;
+	unsigned int lastUse;
+};
+
+// Retained geometry of the static drawing helpers, built once per parameter set. \p created is set
+// to \c true when the returned geometry is new and empty.
+RetainedGeometry* helperGeometry(int kind, qreal size, qreal radius, int nbSubdivisions, bool& created)
+{
+	// The least recently used entry is evicted when too many parameter sets were used (animated
+	// sizes...). The geometries returned by the previous calls of a drawing method are kept.
+	static const int maxSize = 64;
+	static QMap<HelperGeometryKey, HelperGeometryEntry> cache;
+	static unsigned int useCount = 0;
+
+	HelperGeometryKey key;
+	key.kind = kind;
+	key.size = size;
+	key.radius = radius;
+	key.nbSubdivisions = nbSubdivisions;
+
+	QMap<HelperGeometryKey, HelperGeometryEntry>::iterator it = cache.find(key);
+	created = (it == cache.end());
+	if (!created)
+	{
+		it.value().lastUse = ++useCount;
+		return it.value().geometry;
+	}
+
+	if (cache.size() >= maxSize)
+	{
+		QMap<HelperGeometryKey, HelperGeometryEntry>::iterator oldest = cache.begin();
+		for (QMap<HelperGeometryKey, HelperGeometryEntry>::iterator e = cache.begin(); e != cache.end(); ++e)
+			if (e.value().lastUse < oldest.value().lastUse)
+				oldest = e;
+		delete oldest.value().geometry;
+		cache.erase(oldest);
+	}
+	HelperGeometryEntry entry;
+	entry.geometry = new RetainedGeometry();
+	entry.lastUse = ++useCount;
+	cache.insert(key, entry);
+	return entry.geometry;
+}
+
+// Arrows of all lengths share a unit length geometry per radius / length ratio, scaled by the
+// model matrix.
+void drawArrowGeometry(qreal length, qreal radius, int nbSubdivisions, const GLdouble* matrix)
+{
+	if (length == 0.0)
+		return;
+
+	const qreal ratio = (radius < 0.0) ? 0.05 : radius / length;
+
+	bool created;
+	RetainedGeometry* geometry = helperGeometry(ARROW_GEOMETRY, ratio, 0.0, nbSubdivisions, created);
+	if (created)
+		geometry->addArrow(Vec(), Vec(0.0, 0.0, 1.0), ratio, nbSubdivisions);
+
+	GLdouble scaled[16];
+	for (int i=0; i<16; ++i)
+		scaled[i] = matrix ? matrix[i] : ((i%5 == 0) ? 1.0 : 0.0);
+	for (int i=0; i<12; ++i)
+		scaled[i] *= length;
+
+	if (RetainedGeometry::isCoreProfile())
+	{
+		// Normals are normalized by the shader
+		geometry->draw(scaled);
+		return;
+	}
+
+	glPushAttrib(GL_ENABLE_BIT);
+#ifdef GL_RESCALE_NORMAL  // OpenGL 1.2 Only...
+	glEnable(GL_RESCALE_NORMAL);
+#else
+	glEnable(GL_NORMALIZE);
+#endif
+	geometry->draw(scaled);
+	glPopAttrib();
+}
+}
+
 /*! Draws a 3D arrow along the positive Z axis.
 
 \p length, \p radius and \p nbSubdivisions define its geometry. If \p radius is negative
@@ -3203,21 +3524,12 @@ void QGLViewer::resetVisualHints()
 Use drawArrow(const Vec& from, const Vec& to, qreal radius, int nbSubdivisions) or change the \c
 ModelView matrix to place the arrow in 3D.
 
-Uses current color and does not modify the OpenGL state. */
+Uses current color and does not modify the OpenGL state. The arrow is kept in a vertex buffer for each
+\p radius / \p length ratio and \p nbSubdivisions, and scaled to \p length. With an OpenGL core profile context, it is drawn with the Camera matrices and
+foregroundColor() set by preDraw(), in world coordinates. */
 void QGLViewer::drawArrow(qreal length, qreal radius, int nbSubdivisions)
 {
-	static GLUquadric* quadric = gluNewQuadric();
-
-	if (radius < 0.0)
-		radius = 0.05 * length;
-
-	const qreal head = 2.5*(radius / length) + 0.1;
-	const qreal coneRadiusCoef = 4.0 - 5.0 * head;
-
-	gluCylinder(quadric, radius, radius, length * (1.0 - head/coneRadiusCoef), nbSubdivisions, 1);
-	glTranslated(0.0, 0.0, length * (1.0 - head));
-	gluCylinder(quadric, coneRadiusCoef * radius, 0.0, head * length, nbSubdivisions, 1);
-	glTranslated(0.0, 0.0, -length * (1.0 - head));
+	drawArrowGeometry(length, radius, nbSubdivisions, NULL);
 }
 
 /*! Draws a 3D arrow between the 3D point \p from and the 3D point \p to, both defined in the
@@ -3226,12 +3538,16 @@ current ModelView coordinates system.
 See drawArrow(qreal length, qreal radius, int nbSubdivisions) for details. */
 void QGLViewer::drawArrow(const Vec& from, const Vec& to, qreal radius, int nbSubdivisions)
 {
-	glPushMatrix();
-	glTranslated(from[0], from[1], from[2]);
 	const Vec dir = to-from;
-	glMultMatrixd(Quaternion(Vec(0,0,1), dir).matrix());
-	QGLViewer::drawArrow(dir.norm(), radius, nbSubdivisions);
-	glPopMatrix();
+	GLdouble matrix[16];
+	const GLdouble* const rotation = Quaternion(Vec(0,0,1), dir).matrix();
+	for (int i=0; i<12; ++i)
+		matrix[i] = rotation[i];
+	matrix[12] = from[0];
+	matrix[13] = from[1];
+	matrix[14] = from[2];
+	matrix[15] = 1.0;
+	drawArrowGeometry(dir.norm(), radius, nbSubdivisions, matrix);
 }
 
 /*! Draws an XYZ axis, with a given size (default is 1.0).
@@ -3250,68 +3566,41 @@ glPopMatrix();
 The current color and line width are used to draw the X, Y and Z characters at the extremities of
 the three arrows. The OpenGL state is not modified by this method.
 
+The axis is kept in vertex buffers for each \p length. With an OpenGL core profile context, it is
+drawn in world coordinates with the preDraw() Camera matrices, the characters in foregroundColor().
+
 axisIsDrawn() uses this method to draw a representation of the world coordinate system. See also
 QGLViewer::drawArrow() and QGLViewer::drawGrid(). */
 void QGLViewer::drawAxis(qreal length)
 {
-	const qreal charWidth = length / 40.0;
-	const qreal charHeight = length / 30.0;
-	const qreal charShift = 1.04 * length;
+	bool created;
+	RetainedGeometry* letters = helperGeometry(AXIS_LETTERS_GEOMETRY, length, 0.0, 0, created);
+	if (created)
+		letters->addAxisLetters(length);
+	RetainedGeometry* arrows = helperGeometry(AXIS_ARROWS_GEOMETRY, length, 0.0, 0, created);
+	if (created)
+	{
+		arrows->setHasColors(true);
+		arrows->addAxisArrows(length);
+	}
 
-	GLboolean lighting, colorMaterial;
-	glGetBooleanv(GL_LIGHTING, &lighting);
-	glGetBooleanv(GL_COLOR_MATERIAL, &colorMaterial);
+	if (RetainedGeometry::isCoreProfile())
+	{
+		letters->draw();
+		arrows->draw();
+		return;
+	}
 
+	glPushAttrib(GL_LIGHTING_BIT);
 	glDisable(GL_LIGHTING);
+	letters->draw();
 
-	glBegin(GL_LINES);
-	// The X
-	glVertex3d(charShift,  charWidth, -charHeight);
-	glVertex3d(charShift, -charWidth,  charHeight);
-	glVertex3d(charShift, -charWidth, -charHeight);
-	glVertex3d(charShift,  charWidth,  charHeight);
-	// The Y
-	glVertex3d( charWidth, charShift, charHeight);
-	glVertex3d(0.0,        charShift, 0.0);
-	glVertex3d(-charWidth, charShift, charHeight);
-	glVertex3d(0.0,        charShift, 0.0);
-	glVertex3d(0.0,        charShift, 0.0);
-	glVertex3d(0.0,        charShift, -charHeight);
-	// The Z
-	glVertex3d(-charWidth,  charHeight, charShift);
-	glVertex3d( charWidth,  charHeight, charShift);
-	glVertex3d( charWidth,  charHeight, charShift);
-	glVertex3d(-charWidth, -charHeight, charShift);
-	glVertex3d(-charWidth, -charHeight, charShift);
-	glVertex3d( charWidth, -charHeight, charShift);
-	glEnd();
-
+	// Vertex colors give the arrows material
 	glEnable(GL_LIGHTING);
-	glDisable(GL_COLOR_MATERIAL);
-
-	float color[4];
-	color[0] = 0.7f;  color[1] = 0.7f;  color[2] = 1.0f;  color[3] = 1.0f;
-	glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, color);
-	QGLViewer::drawArrow(length, 0.01*length);
-
-	color[0] = 1.0f;  color[1] = 0.7f;  color[2] = 0.7f;  color[3] = 1.0f;
-	glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, color);
-	glPushMatrix();
-	glRotatef(90.0f, 0.0f, 1.0f, 0.0f);
-	QGLViewer::drawArrow(length, 0.01*length);
-	glPopMatrix();
-
-	color[0] = 0.7f;  color[1] = 1.0f;  color[2] = 0.7f;  color[3] = 1.0f;
-	glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, color);
-	glPushMatrix();
-	glRotatef(-90.0f, 1.0f, 0.0f, 0.0f);
-	QGLViewer::drawArrow(length, 0.01*length);
-	glPopMatrix();
-
-	if (colorMaterial)
-		glEnable(GL_COLOR_MATERIAL);
-	if (!lighting)
-		glDisable(GL_LIGHTING);
+	glEnable(GL_COLOR_MATERIAL);
+	glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
+	arrows->draw();
+	glPopAttrib();
 }
 
 /*! Draws a grid in the XY plane, centered on (0,0,0) (defined in the current coordinate system).
@@ -3319,24 +3608,33 @@ void QGLViewer::drawAxis(qreal length)
 \p size (OpenGL units) and \p nbSubdivisions define its geometry. Set the \c GL_MODELVIEW matrix to
 place and orientate the grid in 3D space (see the drawAxis() documentation).
 
+The grid is kept in a vertex buffer for each set of parameters. With an OpenGL core profile context,
+it is drawn in the world XY plane with the preDraw() Camera matrices and foregroundColor().
+
 The OpenGL state is not modified by this method. */
 void QGLViewer::drawGrid(qreal size, int nbSubdivisions)
 {
+	bool created;
+	RetainedGeometry* grid = helperGeometry(GRID_GEOMETRY, size, 0.0, nbSubdivisions, created);
+	if (created)
+		for (int i=0; i<=nbSubdivisions; ++i)
+		{
+			const qreal pos = size*(2.0*i/nbSubdivisions-1.0);
+			grid->addLine(Vec(pos, -size, 0.0), Vec(pos, +size, 0.0));
+			grid->addLine(Vec(-size, pos, 0.0), Vec( size, pos, 0.0));
+		}
+
+	if (RetainedGeometry::isCoreProfile())
+	{
+		grid->draw();
+		return;
+	}
+
 	GLboolean lighting;
 	glGetBooleanv(GL_LIGHTING, &lighting);
 
 	glDisable(GL_LIGHTING);
-
-	glBegin(GL_LINES);
-	for (int i=0; i<=nbSubdivisions; ++i)
-	{
-		const qreal pos = size*(2.0*i/nbSubdivisions-1.0);
-		glVertex2d(pos, -size);
-		glVertex2d(pos, +size);
-		glVertex2d(-size, pos);
-		glVertex2d( size, pos);
-	}
-	glEnd();
+	grid->draw();
 
 	if (lighting)
 		glEnable(GL_LIGHTING);
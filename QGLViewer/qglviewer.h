@@ -33,6 +33,10 @@ class QTabWidget;
 
 namespace qglviewer {
 class MouseGrabber;
+class MouseGrabberIndex;
+class RetainedGeometry;
+class TextRenderer;
+class FrameCapture;
 class ManipulatedFrame;
 class ManipulatedCameraFrame;
 }
@@ -376,6 +380,7 @@ public:
 	virtual void stopScreenCoordinatesSystem() const;
 
 	void drawText(int x, int y, const QString& text, const QFont& fnt=QFont());
+	void drawText(const qglviewer::Vec& position, const QString& text, const QFont& fnt=QFont());
 	void displayMessage(const QString& message, int delay=2000);
 	// void draw3DText(const qglviewer::Vec& pos, const qglviewer::Vec& normal, const QString& string, GLfloat height=0.1);
 
@@ -384,6 +389,8 @@ protected:
 
 private:
 	void displayFPS();
+	void addText(qreal x, qreal y, qreal depth, const QString& text, const QFont& fnt);
+	void flushText();
 	/*! Vectorial rendering callback method. */
 	void drawVectorial() { paintGL(); }
 
@@ -519,8 +526,29 @@ public Q_SLOTS:
 	bool openSnapshotFormatDialog();
 	void snapshotToClipboard();
 
+public:
+	/*! Policy of the image sequence capture when captureQueueSize() frames are already waiting to
+	be written, see setCaptureBackpressure(). */
+	enum CaptureBackpressure { CAPTURE_WAIT, CAPTURE_DROP };
+
+	int captureQueueSize() const;
+	CaptureBackpressure captureBackpressure() const;
+	int captureEncoderCount() const;
+	int capturedFrameCount() const;
+	int droppedFrameCount() const;
+	int failedFrameCount() const;
+
+public Q_SLOTS:
+	void setCaptureQueueSize(int size);
+	void setCaptureBackpressure(CaptureBackpressure policy);
+	void setCaptureEncoderCount(int count);
+	void resetCaptureStatistics();
+	void waitForCapturedFrames();
+
 private:
 	bool saveImageSnapshot(const QString& fileName);
+	bool saveImageSnapshotOffscreen(const QString& fileName, const QSize& finalSize, qreal oversampling,
+									qreal xMin, qreal yMin, bool fitHeight);
 
 #ifndef DOXYGEN
 	/* This class is used internally for screenshot that require tiling (image size size different
@@ -632,6 +660,36 @@ public Q_SLOTS:
 	void toggleAnimation() { if (animationIsStarted()) stopAnimation(); else startAnimation(); }
 	//@}
 
+	/*! @name Render on demand */
+	//@{
+public:
+	/*! Returns \c true when the viewer only redraws when something changed. Default is \c false.
+
+	When animationIsStarted(), animate() is still called every animationPeriod(), but a frame is only
+	drawn when a qglviewer::Frame was modified by animate() (see qglviewer::Frame::globalGeneration())
+	or when requestRedraw() (or \c update()) was called. An animate() method that changes something
+	else (mesh vertex buffers, colors...) should call requestRedraw().
+
+	After a few idle animation steps, the animation timer is slowed down to idleAnimationPeriod() until
+	the next change, so that a static viewer uses almost no CPU. */
+	bool renderOnDemand() const { return renderOnDemand_; }
+	/*! Maximum number of frames per second drawn for the requestRedraw() invalidations. Default is \c
+	0, meaning no limit. Caps the frame rate during continuous camera or manipulatedFrame()
+	interaction. */
+	int maximumFrameRate() const { return maximumFrameRate_; }
+	/*! Animation timer period, in milliseconds, used by renderOnDemand() when animate() has not changed
+	anything for a while. Default is 250. Never shorter than animationPeriod(). */
+	int idleAnimationPeriod() const { return idleAnimationPeriod_; }
+
+public Q_SLOTS:
+	void setRenderOnDemand(bool onDemand=true);
+	/*! Sets maximumFrameRate(). \p fps = 0 removes the limit. */
+	void setMaximumFrameRate(int fps) { maximumFrameRate_ = fps; }
+	/*! Sets idleAnimationPeriod(), in milliseconds. */
+	void setIdleAnimationPeriod(int period) { idleAnimationPeriod_ = period; }
+	void requestRedraw();
+	//@}
+
 public:
 Q_SIGNALS:
 	/*! Signal emitted by the default init() method.
@@ -658,6 +716,10 @@ Q_SIGNALS:
 	connected to saveSnapshot() with an \c automatic value set to \c true. */
 	void drawFinished(bool automatic);
 
+	/*! Signal emitted when an image snapshot, rendered offscreen and encoded in a background thread
+	by saveSnapshot(), has been written to \p fileName. \p ok is \c false if writing failed. */
+	void snapshotSaved(const QString& fileName, bool ok);
+
 	/*! Signal emitted by the default animate() method.
 
 	Connect this signal to your scene animation method or overload animate(). */
@@ -1111,6 +1173,9 @@ private Q_SLOTS:
 	// Patch for a Qt bug with fullScreen on startup
 	void delayedFullScreen() { move(prevPos_); setFullScreen(); }
 	void hideMessage();
+	void pacedRedraw();
+	void imageSnapshotWritten(const QString& fileName, bool ok);
+	void flushCapture();
 
 private:
 	// Copy constructor and operator= are declared private and undefined
@@ -1147,6 +1212,18 @@ private:
 	int animationPeriod_;   // period in msecs
 	int animationTimerId_;
 
+	// R e n d e r   o n   d e m a n d
+	bool renderOnDemand_;
+	int maximumFrameRate_;
+	int idleAnimationPeriod_;
+	bool redrawRequested_;	// requestRedraw() since the last frame
+	bool redrawPending_;	// update() posted or delayed by redrawTimer_
+	QTimer redrawTimer_;
+	QTime lastFrameTime_;
+	unsigned long animationGeneration_; // Frame::globalGeneration() after the previous animate()
+	int idleAnimationSteps_;
+	void setAnimationTimerPeriod(int period);
+
 	// F P S    d i s p l a y
 	QTime fpsTime_;
 	unsigned int fpsCounter_;
@@ -1167,6 +1244,7 @@ private:
 	bool mouseGrabberIsAManipulatedFrame_;
 	bool mouseGrabberIsAManipulatedCameraFrame_;
 	QMap<size_t, bool> disabledMouseGrabbers_;
+	qglviewer::MouseGrabberIndex* mouseGrabberIndex_;
 
 	// S e l e c t i o n
 	int selectRegionWidth_, selectRegionHeight_;
@@ -1176,6 +1254,12 @@ private:
 
 	// V i s u a l   h i n t s
 	int visualHint_;
+	qglviewer::RetainedGeometry* visualHintsGeometry_;
+	void screenCoordinatesMatrix(GLfloat matrix[16], bool upward) const;
+	void drawScreenGeometry(qglviewer::RetainedGeometry* geometry, GLfloat lineWidth) const;
+
+	// T e x t
+	qglviewer::TextRenderer* textRenderer_;
 
 	// S h o r t c u t   k e y s
 	void setDefaultShortcuts();
@@ -1284,6 +1368,8 @@ private:
 	QString snapshotFileName_, snapshotFormat_;
 	int snapshotCounter_, snapshotQuality_;
 	TileRegion* tileRegion_;
+	qglviewer::FrameCapture* frameCapture_;
+	QTimer captureFlushTimer_;	// Maps the last captured frames when the sequence pauses
 
 	// Q G L V i e w e r   p o o l
 	static QList<QGLViewer*> QGLViewerPool_;
@@ -0,0 +1,507 @@
+/****************************************************************************
+
+ Copyright (C) 2002-2014 Gilles Debunne. All rights reserved.
+
+ This file is part of the QGLViewer library version 2.6.3.
+
+ http://www.libqglviewer.com - contact@libqglviewer.com
+
+ This file may be used under the terms of the GNU General Public License
+ versions 2.0 or 3.0 as published by the Free Software Foundation and
+ appearing in the LICENSE file included in the packaging of this file.
+ In addition, as a special exception, Gilles Debunne gives you certain
+ additional rights, described in the file GPL_EXCEPTION in this package.
+
+ libQGLViewer uses dual licensing. Commercial/proprietary software must
+ purchase a libQGLViewer Commercial License.
+
+ This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+
+*****************************************************************************/
+
+#include "retainedGeometry.h"
+#include "frame.h"
+
+#include <math.h>
+
+#if QT_VERSION >= 0x050100
+# include <QHash>
+# include <QPointer>
+# include <QOpenGLBuffer>
+# include <QOpenGLContext>
+# include <QOpenGLShaderProgram>
+# include <QOpenGLVertexArrayObject>
+#endif
+
+using namespace qglviewer;
+
+// Interleaved vertex: position, normal, color
+static const int vertexSize = 10;
+
+GLfloat RetainedGeometry::coreModelViewProjection_[16] = { 1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1 };
+GLfloat RetainedGeometry::coreModelView_[16] = { 1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1 };
+GLfloat RetainedGeometry::coreColor_[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+#if QT_VERSION >= 0x050100
+namespace {
+const char* const vertexShaderSource =
+	"#version 150\n"
+	"in vec3 position;\n"
+	"in vec3 normal;\n"
+	"in vec4 color;\n"
+	"uniform mat4 modelViewProjection;\n"
+	"uniform mat3 normalMatrix;\n"
+	"uniform vec4 defaultColor;\n"
+	"uniform bool useColors;\n"
+	"out vec4 vertexColor;\n"
+	"void main()\n"
+	"{\n"
+	"	vec4 c = useColors ? color : defaultColor;\n"
+	"	float shade = 1.0;\n"
+	"	if (dot(normal, normal) > 0.0)\n"
+	"		shade = 0.3 + 0.7 * abs(normalize(normalMatrix * normal).z);\n"
+	"	vertexColor = vec4(c.rgb * shade, c.a);\n"
+	"	gl_Position = modelViewProjection * vec4(position, 1.0);\n"
+	"}\n";
+
+const char* const fragmentShaderSource =
+	"#version 150\n"
+	"in vec4 vertexColor;\n"
+	"out vec4 fragColor;\n"
+	"void main()\n"
+	"{\n"
+	"	fragColor = vertexColor;\n"
+	"}\n";
+
+// One program per share group, one vertex array per context (vertex arrays are not shared).
+// Deleted with their group / context (QObject parent).
+QOpenGLShaderProgram* coreProgram(QOpenGLContext* context)
+{
+	static QHash<QOpenGLContextGroup*, QPointer<QOpenGLShaderProgram> > programs;
+	QPointer<QOpenGLShaderProgram>& program = programs[context->shareGroup()];
+	if (program.isNull())
+	{
+		program = new QOpenGLShaderProgram(context->shareGroup());
+		program->addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShaderSource);
+		program->addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShaderSource);
+		program->bindAttributeLocation("position", 0);
+		program->bindAttributeLocation("normal", 1);
+		program->bindAttributeLocation("color", 2);
+		if (!program->link())
+			qWarning("RetainedGeometry: unable to link the core profile program: %s", qPrintable(program->log()));
+	}
+	return program;
+}
+
+QOpenGLVertexArrayObject* coreVertexArray(QOpenGLContext* context)
+{
+	static QHash<QOpenGLContext*, QPointer<QOpenGLVertexArrayObject> > vertexArrays;
+	QPointer<QOpenGLVertexArrayObject>& vao = vertexArrays[context];
+	if (vao.isNull())
+	{
+		vao = new QOpenGLVertexArrayObject(context);
+		vao->create();
+	}
+	return vao;
+}
+}
+#endif
+
+RetainedGeometry::RetainedGeometry()
+	: modified_(false), hasColors_(false), color_(Qt::white), frame_(NULL),
+#if QT_VERSION >= 0x050100
+	  buffer_(NULL), shareGroup_(NULL),
+#endif
+	  nbLineVertices_(0), nbTriangleVertices_(0)
+{}
+
+/*! The vertex buffer is released (Qt defers this until its context is current). */
+RetainedGeometry::~RetainedGeometry()
+{
+#if QT_VERSION >= 0x050100
+	delete buffer_;
+#endif
+}
+
+/*! Removes all the primitives. The vertex buffer is updated at the next draw(). */
+void RetainedGeometry::clear()
+{
+	lines_.clear();
+	triangles_.clear();
+	modified_ = true;
+}
+
+void RetainedGeometry::addVertex(QVector<GLfloat>& array, const Vec& p)
+{
+	addVertex(array, p, normal_);
+}
+
+void RetainedGeometry::addVertex(QVector<GLfloat>& array, const Vec& p, const Vec& n)
+{
+	const Vec pos    = frame_ ? frame_->inverseCoordinatesOf(p) : p;
+	const Vec normal = frame_ ? frame_->inverseTransformOf(n) : n;
+	array << GLfloat(pos.x) << GLfloat(pos.y) << GLfloat(pos.z)
+		  << GLfloat(normal.x) << GLfloat(normal.y) << GLfloat(normal.z)
+		  << GLfloat(color_.redF()) << GLfloat(color_.greenF()) << GLfloat(color_.blueF()) << GLfloat(color_.alphaF());
+	modified_ = true;
+}
+
+/*! Adds the segment [\p a, \p b]. */
+void RetainedGeometry::addLine(const Vec& a, const Vec& b)
+{
+	addVertex(lines_, a);
+	addVertex(lines_, b);
+}
+
+/*! Adds the \p nb - 1 segments joining the successive \p points (stored as independent lines, so that
+  all the lines are drawn with one call). */
+void RetainedGeometry::addLineStrip(const Vec* points, int nb)
+{
+	for (int i=1; i<nb; ++i)
+		addLine(points[i-1], points[i]);
+}
+
+/*! Adds the triangle (\p a, \p b, \p c). */
+void RetainedGeometry::addTriangle(const Vec& a, const Vec& b, const Vec& c)
+{
+	addVertex(triangles_, a);
+	addVertex(triangles_, b);
+	addVertex(triangles_, c);
+}
+
+/*! Adds the quad (\p a, \p b, \p c, \p d) as two triangles. */
+void RetainedGeometry::addQuad(const Vec& a, const Vec& b, const Vec& c, const Vec& d)
+{
+	addTriangle(a, b, c);
+	addTriangle(a, c, d);
+}
+
+/*! Adds a 3D arrow from \p from to \p to, with the geometry of QGLViewer::drawArrow(): a cylinder
+  of radius \p radius (0.05 * length if negative) ended by a cone, both with \p nbSubdivisions faces
+  and smooth normals. */
+void RetainedGeometry::addArrow(const Vec& from, const Vec& to, qreal radius, int nbSubdivisions)
+{
+	const Vec dir = to - from;
+	const qreal length = dir.norm();
+	if (length < 1E-10 || nbSubdivisions < 3)
+		return;
+
+	if (radius < 0.0)
+		radius = 0.05 * length;
+
+	const qreal head = 2.5*(radius / length) + 0.1;
+	const qreal coneRadiusCoef = 4.0 - 5.0 * head;
+	const qreal cylinderLength = length * (1.0 - head/coneRadiusCoef);
+	const qreal coneBase = length * (1.0 - head);
+	const qreal coneRadius = coneRadiusCoef * radius;
+	// Cone side normal: radial direction tilted by the cone slope
+	const qreal coneSlope = coneRadius / (head * length);
+	const qreal coneNorm = sqrt(1.0 + coneSlope*coneSlope);
+
+	// Arrow along Z, then rotated towards dir as in QGLViewer::drawArrow()
+	const Quaternion q(Vec(0.0, 0.0, 1.0), dir);
+	const Vec z = q.rotate(Vec(0.0, 0.0, 1.0));
+
+	Vec prevRadial = q.rotate(Vec(1.0, 0.0, 0.0));
+	for (int i=1; i<=nbSubdivisions; ++i)
+	{
+		const qreal angle = 2.0 * M_PI * i / nbSubdivisions;
+		const Vec radial = q.rotate(Vec(cos(angle), sin(angle), 0.0));
+
+		// Cylinder side
+		const Vec a = from + radius * prevRadial;
+		const Vec b = from + radius * radial;
+		const Vec c = b + cylinderLength * z;
+		const Vec d = a + cylinderLength * z;
+		addVertex(triangles_, a, prevRadial);
+		addVertex(triangles_, b, radial);
+		addVertex(triangles_, c, radial);
+		addVertex(triangles_, a, prevRadial);
+		addVertex(triangles_, c, radial);
+		addVertex(triangles_, d, prevRadial);
+
+		// Cone side
+		const Vec prevConeNormal = (prevRadial + coneSlope * z) / coneNorm;
+		const Vec coneNormal = (radial + coneSlope * z) / coneNorm;
+		const Vec base = from + coneBase * z;
+		addVertex(triangles_, base + coneRadius * prevRadial, prevConeNormal);
+		addVertex(triangles_, base + coneRadius * radial, coneNormal);
+		addVertex(triangles_, to, (prevConeNormal + coneNormal).unit());
+
+		prevRadial = radial;
+	}
+}
+
+/*! Adds the three arrows of QGLViewer::drawAxis() along the positive X, Y and Z directions, with
+  their light red, green and blue colors (see setHasColors()). The current color is restored. */
+void RetainedGeometry::addAxisArrows(qreal length)
+{
+	const QColor color = color_;
+	const Vec origin;
+
+	setColor(QColor::fromRgbF(0.7, 0.7, 1.0));
+	addArrow(origin, Vec(0.0, 0.0, length), 0.01*length, 12);
+	setColor(QColor::fromRgbF(1.0, 0.7, 0.7));
+	addArrow(origin, Vec(length, 0.0, 0.0), 0.01*length, 12);
+	setColor(QColor::fromRgbF(0.7, 1.0, 0.7));
+	addArrow(origin, Vec(0.0, length, 0.0), 0.01*length, 12);
+
+	setColor(color);
+}
+
+/*! Adds the X, Y and Z characters drawn by QGLViewer::drawAxis() at the arrows extremities, as lines
+  without normal. */
+void RetainedGeometry::addAxisLetters(qreal length)
+{
+	const qreal charWidth = length / 40.0;
+	const qreal charHeight = length / 30.0;
+	const qreal charShift = 1.04 * length;
+
+	const Vec normal = normal_;
+	normal_ = Vec();
+
+	// The X
+	addLine(Vec(charShift,  charWidth, -charHeight), Vec(charShift, -charWidth,  charHeight));
+	addLine(Vec(charShift, -charWidth, -charHeight), Vec(charShift,  charWidth,  charHeight));
+	// The Y
+	addLine(Vec( charWidth, charShift, charHeight), Vec(0.0, charShift, 0.0));
+	addLine(Vec(-charWidth, charShift, charHeight), Vec(0.0, charShift, 0.0));
+	addLine(Vec(0.0,        charShift, 0.0),        Vec(0.0, charShift, -charHeight));
+	// The Z
+	addLine(Vec(-charWidth,  charHeight, charShift), Vec( charWidth,  charHeight, charShift));
+	addLine(Vec( charWidth,  charHeight, charShift), Vec(-charWidth, -charHeight, charShift));
+	addLine(Vec(-charWidth, -charHeight, charShift), Vec( charWidth, -charHeight, charShift));
+
+	normal_ = normal;
+}
+
+/*! Returns \c true when the current context uses an OpenGL core profile (no fixed pipeline). */
+bool RetainedGeometry::isCoreProfile()
+{
+#if QT_VERSION >= 0x050100
+	const QOpenGLContext* const context = QOpenGLContext::currentContext();
+	return context && (context->format().profile() == QSurfaceFormat::CoreProfile);
+#else
+	return false;
+#endif
+}
+
+/*! Sets the matrices and default color used by draw() in core profile. \p modelView gives the normal
+  matrix used for the shading of the primitives that have a normal. Matrices are in OpenGL (column
+  major) order. */
+void RetainedGeometry::setCoreState(const GLfloat modelViewProjection[16], const GLfloat modelView[16], const QColor& color)
+{
+	for (int i=0; i<16; ++i)
+	{
+		coreModelViewProjection_[i] = modelViewProjection[i];
+		coreModelView_[i] = modelView[i];
+	}
+	coreColor_[0] = GLfloat(color.redF());
+	coreColor_[1] = GLfloat(color.greenF());
+	coreColor_[2] = GLfloat(color.blueF());
+	coreColor_[3] = GLfloat(color.alphaF());
+}
+
+/*! Returns the values given to setCoreState(), typically to restore them after a temporary change. */
+void RetainedGeometry::getCoreState(GLfloat modelViewProjection[16], GLfloat modelView[16], QColor& color)
+{
+	for (int i=0; i<16; ++i)
+	{
+		modelViewProjection[i] = coreModelViewProjection_[i];
+		modelView[i] = coreModelView_[i];
+	}
+	color = QColor::fromRgbF(coreColor_[0], coreColor_[1], coreColor_[2], coreColor_[3]);
+}
+
+/*! Returns \c true when the vertex buffer exists and can be used in the current context. */
+bool RetainedGeometry::bufferIsUsable() const
+{
+#if QT_VERSION >= 0x050100
+	const QOpenGLContext* const context = QOpenGLContext::currentContext();
+	return buffer_ && context && (context->shareGroup() == shareGroup_);
+#else
+	return false;
+#endif
+}
+
+/*! Copies the primitives in the vertex buffer of the current context (Qt 5 only). */
+void RetainedGeometry::upload()
+{
+	nbLineVertices_ = lines_.size() / vertexSize;
+	nbTriangleVertices_ = triangles_.size() / vertexSize;
+	modified_ = false;
+
+#if QT_VERSION >= 0x050100
+	QOpenGLContext* const context = QOpenGLContext::currentContext();
+	if (!context)
+		return;
+
+	if (buffer_ && !bufferIsUsable())
+	{
+		delete buffer_;
+		buffer_ = NULL;
+	}
+	if (!buffer_)
+	{
+		buffer_ = new QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+		buffer_->setUsagePattern(QOpenGLBuffer::StaticDraw);
+		if (!buffer_->create())
+		{
+			delete buffer_;
+			buffer_ = NULL;
+			return;
+		}
+		shareGroup_ = context->shareGroup();
+	}
+
+	buffer_->bind();
+	buffer_->allocate((lines_.size() + triangles_.size()) * int(sizeof(GLfloat)));
+	buffer_->write(0, lines_.constData(), lines_.size() * int(sizeof(GLfloat)));
+	buffer_->write(lines_.size() * int(sizeof(GLfloat)), triangles_.constData(), triangles_.size() * int(sizeof(GLfloat)));
+	buffer_->release();
+#endif
+}
+
+/*! Draws the lines, then the triangles. Uploads the vertex buffer first if the geometry was
+  modified or if the current context does not share the previous buffer.
+
+  When \p matrix is not \c NULL, the geometry is transformed by this OpenGL (column major) matrix,
+  multiplied to the current \c GL_MODELVIEW matrix or to the setCoreState() matrices. It should be
+  rigid up to a scale factor. */
+void RetainedGeometry::draw(const GLdouble* matrix)
+{
+	if (isEmpty())
+		return;
+
+#if QT_VERSION >= 0x050100
+	if (modified_ || !bufferIsUsable())
+		upload();
+
+	if (isCoreProfile())
+	{
+		drawCore(matrix);
+		return;
+	}
+#else
+	if (modified_)
+		upload();
+#endif
+
+	if (matrix)
+	{
+		glPushMatrix();
+		glMultMatrixd(matrix);
+	}
+
+#if QT_VERSION >= 0x050100
+	if (buffer_)
+	{
+		buffer_->bind();
+		drawFixed(NULL, nbLineVertices_, nbTriangleVertices_);
+		buffer_->release();
+	}
+	else
+#endif
+	{
+		// Client side arrays. Lines and triangles are not contiguous: two passes.
+		if (!lines_.isEmpty())
+			drawFixed(lines_.constData(), nbLineVertices_, 0);
+		if (!triangles_.isEmpty())
+			drawFixed(triangles_.constData(), 0, nbTriangleVertices_);
+	}
+
+	if (matrix)
+		glPopMatrix();
+}
+
+/*! Fixed pipeline drawing of \p nbLines line vertices followed by \p nbTriangles triangle vertices,
+  from the bound buffer (\p base is \c NULL) or from client memory. */
+void RetainedGeometry::drawFixed(const GLfloat* base, int nbLines, int nbTriangles)
+{
+	const GLsizei stride = vertexSize * sizeof(GLfloat);
+	// Offsets in the buffer when base is NULL
+	const char* const start = reinterpret_cast<const char*>(base);
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_NORMAL_ARRAY);
+	glVertexPointer(3, GL_FLOAT, stride, start);
+	glNormalPointer(GL_FLOAT, stride, start + 3*sizeof(GLfloat));
+	if (hasColors())
+	{
+		// The current color is undefined after drawing with a color array
+		glPushAttrib(GL_CURRENT_BIT);
+		glEnableClientState(GL_COLOR_ARRAY);
+		glColorPointer(4, GL_FLOAT, stride, start + 6*sizeof(GLfloat));
+	}
+
+	if (nbLines > 0)
+		glDrawArrays(GL_LINES, 0, nbLines);
+	if (nbTriangles > 0)
+		glDrawArrays(GL_TRIANGLES, nbLines, nbTriangles);
+
+	if (hasColors())
+	{
+		glDisableClientState(GL_COLOR_ARRAY);
+		glPopAttrib();
+	}
+	glDisableClientState(GL_NORMAL_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+/*! Core profile drawing with the shared program. */
+void RetainedGeometry::drawCore(const GLdouble* matrix)
+{
+#if QT_VERSION >= 0x050100
+	QOpenGLContext* const context = QOpenGLContext::currentContext();
+	if (!buffer_ || !context)
+		return;
+
+	QOpenGLShaderProgram* const program = coreProgram(context);
+	if (!program->isLinked() || !program->bind())
+		return;
+
+	QOpenGLVertexArrayObject* const vao = coreVertexArray(context);
+	vao->bind();
+	buffer_->bind();
+
+	const int stride = vertexSize * sizeof(GLfloat);
+	program->enableAttributeArray(0);
+	program->enableAttributeArray(1);
+	program->setAttributeBuffer(0, GL_FLOAT, 0, 3, stride);
+	program->setAttributeBuffer(1, GL_FLOAT, 3 * sizeof(GLfloat), 3, stride);
+	if (hasColors())
+	{
+		program->enableAttributeArray(2);
+		program->setAttributeBuffer(2, GL_FLOAT, 6 * sizeof(GLfloat), 4, stride);
+	}
+	else
+		program->disableAttributeArray(2);
+
+	QMatrix4x4 modelViewProjection = QMatrix4x4(coreModelViewProjection_).transposed();
+	QMatrix4x4 modelView = QMatrix4x4(coreModelView_).transposed();
+	if (matrix)
+	{
+		QMatrix4x4 local;
+		for (int i=0; i<4; ++i)
+			for (int j=0; j<4; ++j)
+				local(i, j) = float(matrix[4*j+i]);
+		modelViewProjection *= local;
+		modelView *= local;
+	}
+	program->setUniformValue("modelViewProjection", modelViewProjection);
+	// Rigid (up to a scale, normalized in the shader) modelView: its 3x3 part is the normal matrix
+	program->setUniformValue("normalMatrix", modelView.toGenericMatrix<3, 3>());
+	program->setUniformValue("defaultColor", coreColor_[0], coreColor_[1], coreColor_[2], coreColor_[3]);
+	program->setUniformValue("useColors", GLint(hasColors() ? 1 : 0));
+
+	if (nbLineVertices_ > 0)
+		glDrawArrays(GL_LINES, 0, nbLineVertices_);
+	if (nbTriangleVertices_ > 0)
+		glDrawArrays(GL_TRIANGLES, nbLineVertices_, nbTriangleVertices_);
+
+	buffer_->release();
+	vao->release();
+	program->release();
+#endif
+}
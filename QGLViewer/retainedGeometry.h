@@ -0,0 +1,130 @@
+/****************************************************************************
+
+ Copyright (C) 2002-2014 Gilles Debunne. All rights reserved.
+
+ This file is part of the QGLViewer library version 2.6.3.
+
+ http://www.libqglviewer.com - contact@libqglviewer.com
+
+ This file may be used under the terms of the GNU General Public License
+ versions 2.0 or 3.0 as published by the Free Software Foundation and
+ appearing in the LICENSE file included in the packaging of this file.
+ In addition, as a special exception, Gilles Debunne gives you certain
+ additional rights, described in the file GPL_EXCEPTION in this package.
+
+ libQGLViewer uses dual licensing. Commercial/proprietary software must
+ purchase a libQGLViewer Commercial License.
+
+ This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+
+*****************************************************************************/
+
+#ifndef QGLVIEWER_RETAINED_GEOMETRY_H
+#define QGLVIEWER_RETAINED_GEOMETRY_H
+
+#include "config.h"
+#include "vec.h"
+#include <QColor>
+#include <QVector>
+
+#if QT_VERSION >= 0x050100
+class QOpenGLBuffer;
+class QOpenGLContextGroup;
+#endif
+
+namespace qglviewer {
+class Frame;
+
+/*! \brief Lines and triangles built once and drawn with one call per primitive type.
+  \class RetainedGeometry retainedGeometry.h QGLViewer/retainedGeometry.h
+
+  The geometry is accumulated on the CPU (addLine(), addTriangle()...), uploaded in a vertex buffer
+  at the first draw() following a modification, and then drawn with at most two \c glDrawArrays
+  (\c GL_LINES, then \c GL_TRIANGLES).
+
+  With a compatibility context, the fixed pipeline is used: the current modelview and projection
+  matrices, lighting and (unless hasColors()) \c glColor apply as with \c glBegin / \c glEnd. With a
+  core profile context, a shared minimal shader is used with the matrices and color given to
+  setCoreState() (done by QGLViewer::preDraw()): coordinates are then world coordinates, unless a
+  matrix is given to draw(). The shader
+  program, vertex array and array buffer bindings are reset to 0 after draw().
+
+  Internal class used by the QGLViewer drawing helpers, not installed. */
+class RetainedGeometry
+{
+public:
+	RetainedGeometry();
+	~RetainedGeometry();
+
+	void clear();
+	/*! Returns \c true when no primitive was added since the last clear(). */
+	bool isEmpty() const { return lines_.isEmpty() && triangles_.isEmpty(); }
+
+	/*! Sets the color of the vertices added afterwards. Only used when hasColors(). */
+	void setColor(const QColor& color) { color_ = color; }
+	/*! Sets the normal of the vertices added afterwards. A null normal (default) means unlit in core
+	  profile. */
+	void setNormal(const Vec& normal) { normal_ = normal; }
+	/*! Sets the transformation applied to the vertices added afterwards (\c NULL: identity). The
+	  Frame world transformation is used. */
+	void setFrame(const Frame* const frame) { frame_ = frame; }
+
+	/*! Whether vertex colors (see setColor()) are used. When \c false (default), the current \c
+	  glColor (compatibility context) or the setCoreState() color is used. */
+	bool hasColors() const { return hasColors_; }
+	void setHasColors(bool colors) { hasColors_ = colors; }
+
+	void addLine(const Vec& a, const Vec& b);
+	void addLineStrip(const Vec* points, int nb);
+	void addTriangle(const Vec& a, const Vec& b, const Vec& c);
+	void addQuad(const Vec& a, const Vec& b, const Vec& c, const Vec& d);
+	void addArrow(const Vec& from, const Vec& to, qreal radius, int nbSubdivisions);
+	void addAxisArrows(qreal length);
+	void addAxisLetters(qreal length);
+
+	void draw(const GLdouble* matrix=NULL);
+
+	static bool isCoreProfile();
+	static void setCoreState(const GLfloat modelViewProjection[16], const GLfloat modelView[16], const QColor& color);
+	static void getCoreState(GLfloat modelViewProjection[16], GLfloat modelView[16], QColor& color);
+
+private:
+	// Copy would share the GL buffer
+	RetainedGeometry(const RetainedGeometry&);
+	RetainedGeometry& operator=(const RetainedGeometry&);
+
+	void addVertex(QVector<GLfloat>& array, const Vec& p);
+	void addVertex(QVector<GLfloat>& array, const Vec& p, const Vec& normal);
+	bool bufferIsUsable() const;
+	void upload();
+	void drawFixed(const GLfloat* base, int nbLines, int nbTriangles);
+	void drawCore(const GLdouble* matrix);
+
+	// Interleaved position (3), normal (3), color (4) per vertex
+	QVector<GLfloat> lines_;
+	QVector<GLfloat> triangles_;
+	bool modified_;
+	bool hasColors_;
+
+	QColor color_;
+	Vec normal_;
+	const Frame* frame_;
+
+#if QT_VERSION >= 0x050100
+	QOpenGLBuffer* buffer_;
+	// Share group of the buffer, only compared (may have been deleted)
+	QOpenGLContextGroup* shareGroup_;
+#endif
+	// Vertex counts of the uploaded data
+	int nbLineVertices_;
+	int nbTriangleVertices_;
+
+	static GLfloat coreModelViewProjection_[16];
+	static GLfloat coreModelView_[16];
+	static GLfloat coreColor_[4];
+};
+
+} // namespace qglviewer
+
+#endif // QGLVIEWER_RETAINED_GEOMETRY_H
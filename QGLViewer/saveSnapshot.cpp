@@ -21,6 +21,8 @@
 *****************************************************************************/
 
 #include "qglviewer.h"
+#include "frameCapture.h"
+#include "retainedGeometry.h"
 
 #ifndef NO_VECTORIAL_RENDER
 #  include "ui_VRenderInterface.h"
@@ -40,6 +42,16 @@
 #include <qinputdialog.h>
 #include <qprogressdialog.h>
 #include <qcursor.h>
+#include <QGLFramebufferObject>
+#include <QPainter>
+#include <QPointer>
+#include <QRunnable>
+#include <QSharedPointer>
+#include <QThreadPool>
+
+#if QT_VERSION >= 0x050200
+# include <QOpenGLBuffer>
+#endif
 
 using namespace std;
 
@@ -105,6 +117,8 @@ void QGLViewer::initializeSnapshotFormats()
 	formatList += "PS";
 	formatList += "XFIG";
 #endif
+	// Headerless pixels, written by FrameCapture
+	formatList += "RAW";
 
 	// Check that the interesting formats are available and add them in "formats"
 	// Unused formats: XPM XBM PBM PGM
@@ -116,6 +130,7 @@ void QGLViewer::initializeSnapshotFormats()
 	QtText += "PPM";	MenuText += "24bit RGB Bitmap (*.ppm)";	Ext += "ppm";
 	QtText += "BMP";	MenuText += "Windows Bitmap (*.bmp)";	Ext += "bmp";
 	QtText += "XFIG";	MenuText += "XFig (*.fig)";		Ext += "fig";
+	QtText += "RAW";	MenuText += "Raw RGBA pixels (*.raw)";	Ext += "raw";
 
 	QStringList::iterator itText = QtText.begin();
 	QStringList::iterator itMenu = MenuText.begin();
@@ -306,6 +321,400 @@ public: ImageInterface(QWidget *parent) : QDialog(parent) { setupUi(this); }
 };
 
 
+namespace {
+// Final image of an offscreen snapshot, filled by SnapshotTileTask and written by SnapshotWriteTask
+struct SnapshotImage
+{
+	QImage image;
+	QString fileName;
+	QByteArray format;
+	int quality;
+	QPointer<QGLViewer> viewer;
+};
+
+// Scales a rendered tile (bottom-up OpenGL rows) and copies it in the final image
+class SnapshotTileTask : public QRunnable
+{
+public:
+	SnapshotTileTask(const QSharedPointer<SnapshotImage>& snapshot, const QImage& tile, const QRect& target, bool bottomUp)
+		: snapshot_(snapshot), tile_(tile), target_(target), bottomUp_(bottomUp) {}
+
+	void run()
+	{
+		QImage tile = tile_.convertToFormat(QImage::Format_ARGB32);
+		if (bottomUp_)
+			tile = tile.mirrored();
+		if (tile.size() != target_.size())
+			tile = tile.scaled(target_.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+		QPainter painter(&snapshot_->image);
+		painter.setCompositionMode(QPainter::CompositionMode_Source);
+		painter.drawImage(target_.topLeft(), tile);
+	}
+
+private:
+	QSharedPointer<SnapshotImage> snapshot_;
+	QImage tile_;
+	QRect target_;
+	bool bottomUp_;
+};
+
+// Encodes the final image and notifies the viewer (in its thread)
+class SnapshotWriteTask : public QRunnable
+{
+public:
+	explicit SnapshotWriteTask(const QSharedPointer<SnapshotImage>& snapshot) : snapshot_(snapshot) {}
+
+	void run()
+	{
+		const bool ok = qglviewer::FrameCapture::writeImage(snapshot_->image, snapshot_->fileName, QString(snapshot_->format), snapshot_->quality);
+		// Released before the notification: the image may be large
+		const QString fileName = snapshot_->fileName;
+		QPointer<QGLViewer> viewer = snapshot_->viewer;
+		snapshot_.clear();
+		if (viewer)
+			QMetaObject::invokeMethod(viewer, "imageSnapshotWritten", Qt::QueuedConnection,
+									  Q_ARG(QString, fileName), Q_ARG(bool, ok));
+	}
+
+private:
+	QSharedPointer<SnapshotImage> snapshot_;
+};
+
+// Single thread: the tiles of a snapshot are copied before it is written, in submission order
+QThreadPool* snapshotThreadPool()
+{
+	static QThreadPool* pool = NULL;
+	if (!pool)
+	{
+		pool = new QThreadPool(qApp);
+		pool->setMaxThreadCount(1);
+	}
+	return pool;
+}
+
+// Largest offscreen render size supported by the implementation
+int maxOffscreenSize()
+{
+	GLint maxSize = 0;
+#ifdef GL_MAX_RENDERBUFFER_SIZE
+	glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &maxSize);
+#endif
+	if (maxSize <= 0)
+		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+	GLint viewportDims[2] = { 0, 0 };
+	glGetIntegerv(GL_MAX_VIEWPORT_DIMS, viewportDims);
+	if (viewportDims[0] > 0)
+		maxSize = qMin(maxSize, qMin(viewportDims[0], viewportDims[1]));
+	return qMax(int(maxSize), 64);
+}
+}
+
+/*! Renders the saveImageSnapshot() image in a framebuffer object, in as few tiles as the OpenGL
+implementation allows, and hands the pixels to a worker thread for scaling and encoding.
+
+Each tile covers outputTile pixels of the final image and is rendered \p oversampling times larger.
+With pixel buffer objects (Qt 5.2), the read back of a tile is overlapped with the rendering of the
+next one. Returns \c false if the framebuffer object could not be created, in which case nothing was
+done. The result is reported by snapshotSaved(). */
+bool QGLViewer::saveImageSnapshotOffscreen(const QString& fileName, const QSize& finalSize, qreal oversampling,
+										   qreal xMin, qreal yMin, bool fitHeight)
+{
+	makeCurrent();
+
+	// In core profile, the projection comes from the camera and cannot be tiled: one tile,
+	// scaled up if the implementation limit is exceeded.
+	const bool coreProfile = RetainedGeometry::isCoreProfile();
+	const int maxSize = maxOffscreenSize();
+
+	QSize outputTile, renderSize;
+	if (coreProfile)
+	{
+		outputTile = finalSize;
+		const qreal scale = qMin(oversampling, qMin(maxSize / qreal(finalSize.width()), maxSize / qreal(finalSize.height())));
+		renderSize = QSize(qMax(1, int(finalSize.width() * scale)), qMax(1, int(finalSize.height() * scale)));
+	}
+	else
+	{
+		outputTile = QSize(qMax(1, qMin(finalSize.width(),  int(maxSize / oversampling))),
+						   qMax(1, qMin(finalSize.height(), int(maxSize / oversampling))));
+		renderSize = QSize(qMin(maxSize, int(ceil(outputTile.width()  * oversampling))),
+						   qMin(maxSize, int(ceil(outputTile.height() * oversampling))));
+	}
+
+	QGLFramebufferObject fbo(renderSize, QGLFramebufferObject::Depth);
+	if (!fbo.isValid())
+		return false;
+
+	QSharedPointer<SnapshotImage> snapshot(new SnapshotImage());
+	snapshot->image = QImage(finalSize, QImage::Format_ARGB32);
+	if (snapshot->image.isNull())
+		return false;
+	snapshot->image.fill(0);
+	snapshot->fileName = fileName;
+	snapshot->format = snapshotFormat().toLatin1();
+	snapshot->quality = snapshotQuality();
+	snapshot->viewer = this;
+
+	const int nbX = (finalSize.width()  + outputTile.width()  - 1) / outputTile.width();
+	const int nbY = (finalSize.height() + outputTile.height() - 1) / outputTile.height();
+
+	const qreal zNear = camera()->zNear();
+	const qreal zFar = camera()->zFar();
+	const qreal scaleX = outputTile.width()  / static_cast<qreal>(finalSize.width());
+	const qreal scaleY = outputTile.height() / static_cast<qreal>(finalSize.height());
+	const qreal deltaX = 2.0 * xMin * scaleX;
+	const qreal deltaY = 2.0 * yMin * scaleY;
+
+	// tileRegion_ maps the widget coordinates used by drawText() and startScreenCoordinatesSystem()
+	// to the tile, as for the on screen tiling
+	tileRegion_ = new TileRegion();
+	qreal tileXMin, tileWidth, tileYMin, tileHeight;
+	if (fitHeight)
+	{
+		const qreal tileTotalWidth = finalSize.width() / static_cast<qreal>(finalSize.height()) * height();
+		tileXMin = (width() - tileTotalWidth) / 2.0;
+		tileWidth = tileTotalWidth * scaleX;
+		tileYMin = 0.0;
+		tileHeight = height() * scaleY;
+		tileRegion_->textScale = 1.0 / scaleY;
+	}
+	else
+	{
+		const qreal tileTotalHeight = width() / (finalSize.width() / static_cast<qreal>(finalSize.height()));
+		tileYMin = (height() - tileTotalHeight) / 2.0;
+		tileHeight = tileTotalHeight * scaleY;
+		tileXMin = 0.0;
+		tileWidth = width() * scaleX;
+		tileRegion_->textScale = 1.0 / scaleX;
+	}
+
+	GLint previousViewport[4];
+	glGetIntegerv(GL_VIEWPORT, previousViewport);
+	GLint previousPackAlignment;
+	glGetIntegerv(GL_PACK_ALIGNMENT, &previousPackAlignment);
+
+	// The core profile projection is the camera one: it must have the aspect ratio of the image
+	const qreal previousFieldOfView = camera()->fieldOfView();
+	if (coreProfile)
+	{
+		const qreal horizontalFieldOfView = camera()->horizontalFieldOfView();
+		camera()->setScreenWidthAndHeight(renderSize.width(), renderSize.height());
+		if (!fitHeight && (camera()->type() == qglviewer::Camera::PERSPECTIVE))
+			camera()->setHorizontalFieldOfView(horizontalFieldOfView);
+	}
+
+#if QT_VERSION >= 0x050200
+	// Two pixel pack buffers: tile n is read back while tile n+1 is rendered
+	const int tileBytes = 4 * renderSize.width() * renderSize.height();
+	QOpenGLBuffer packBuffers[2] = { QOpenGLBuffer(QOpenGLBuffer::PixelPackBuffer), QOpenGLBuffer(QOpenGLBuffer::PixelPackBuffer) };
+	bool usePackBuffers = true;
+	for (int b=0; b<2 && usePackBuffers; ++b)
+	{
+		packBuffers[b].setUsagePattern(QOpenGLBuffer::StreamRead);
+		usePackBuffers = packBuffers[b].create();
+		if (usePackBuffers)
+		{
+			packBuffers[b].bind();
+			packBuffers[b].allocate(tileBytes);
+			packBuffers[b].release();
+		}
+	}
+	QRect pendingTarget;
+	int pending = -1;
+#endif
+
+	QThreadPool* const pool = snapshotThreadPool();
+	int count = 0;
+	for (int i=0; i<nbX; ++i)
+		for (int j=0; j<nbY; ++j, ++count)
+		{
+			fbo.bind();
+			glViewport(0, 0, renderSize.width(), renderSize.height());
+
+			preDraw();
+
+			if (!coreProfile)
+			{
+				// Tile projection matrix
+				glMatrixMode(GL_PROJECTION);
+				glLoadIdentity();
+				if (camera()->type() == qglviewer::Camera::PERSPECTIVE)
+					glFrustum(-xMin + i*deltaX, -xMin + (i+1)*deltaX, yMin - (j+1)*deltaY, yMin - j*deltaY, zNear, zFar);
+				else
+					glOrtho(-xMin + i*deltaX, -xMin + (i+1)*deltaX, yMin - (j+1)*deltaY, yMin - j*deltaY, zNear, zFar);
+				glMatrixMode(GL_MODELVIEW);
+			}
+
+			tileRegion_->xMin = tileXMin + i * tileWidth;
+			tileRegion_->xMax = tileXMin + (i+1) * tileWidth;
+			tileRegion_->yMin = tileYMin + j * tileHeight;
+			tileRegion_->yMax = tileYMin + (j+1) * tileHeight;
+
+			draw();
+			postDraw();
+
+			const QRect target(i * outputTile.width(), j * outputTile.height(), outputTile.width(), outputTile.height());
+
+#if QT_VERSION >= 0x050200
+			if (usePackBuffers)
+			{
+				QOpenGLBuffer& buffer = packBuffers[count % 2];
+				buffer.bind();
+				glPixelStorei(GL_PACK_ALIGNMENT, 4);
+				glReadPixels(0, 0, renderSize.width(), renderSize.height(), GL_RGBA, GL_UNSIGNED_BYTE, 0);
+				glPixelStorei(GL_PACK_ALIGNMENT, previousPackAlignment);
+				buffer.release();
+				fbo.release();
+
+				// Previous tile is ready by now
+				if (pending >= 0)
+				{
+					QOpenGLBuffer& previous = packBuffers[pending % 2];
+					previous.bind();
+					const uchar* data = static_cast<const uchar*>(previous.map(QOpenGLBuffer::ReadOnly));
+					if (data)
+						pool->start(new SnapshotTileTask(snapshot, QImage(data, renderSize.width(), renderSize.height(), QImage::Format_RGBA8888).copy(), pendingTarget, true));
+					previous.unmap();
+					previous.release();
+				}
+				pending = count;
+				pendingTarget = target;
+				continue;
+			}
+#endif
+			fbo.release();
+			pool->start(new SnapshotTileTask(snapshot, fbo.toImage(), target, false));
+		}
+
+#if QT_VERSION >= 0x050200
+	if (usePackBuffers && (pending >= 0))
+	{
+		QOpenGLBuffer& previous = packBuffers[pending % 2];
+		previous.bind();
+		const uchar* data = static_cast<const uchar*>(previous.map(QOpenGLBuffer::ReadOnly));
+		if (data)
+			pool->start(new SnapshotTileTask(snapshot, QImage(data, renderSize.width(), renderSize.height(), QImage::Format_RGBA8888).copy(), pendingTarget, true));
+		previous.unmap();
+		previous.release();
+	}
+	for (int b=0; b<2; ++b)
+		packBuffers[b].destroy();
+#endif
+
+	glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+	if (coreProfile)
+	{
+		camera()->setScreenWidthAndHeight(width(), height());
+		camera()->setFieldOfView(previousFieldOfView);
+	}
+
+	delete tileRegion_;
+	tileRegion_ = NULL;
+
+	pool->start(new SnapshotWriteTask(snapshot));
+	return true;
+}
+
+/*! Called in the viewer thread when a saveImageSnapshotOffscreen() image has been written. */
+void QGLViewer::imageSnapshotWritten(const QString& fileName, bool ok)
+{
+	if (!ok)
+		QMessageBox::warning(this, "Snapshot problem", "Unable to save snapshot in\n"+fileName);
+	Q_EMIT snapshotSaved(fileName, ok);
+}
+
+/*! Returns the maximum number of frames of an image sequence (see saveSnapshot()) that can be
+ waiting to be written at the same time. Bounds the memory used by the capture. The few frames
+ whose read back is still in progress on the GPU are not counted.
+
+ When this number is reached, the captureBackpressure() policy is applied. Default value is 8. Set
+ using setCaptureQueueSize(). */
+int QGLViewer::captureQueueSize() const
+{
+	return frameCapture_->queueSize();
+}
+
+/*! Sets the captureQueueSize(). Values smaller than 1 are clamped to 1. */
+void QGLViewer::setCaptureQueueSize(int size)
+{
+	frameCapture_->setQueueSize(size);
+}
+
+/*! Returns the policy applied when captureQueueSize() frames of an image sequence are already
+ waiting to be written.
+
+ With \c CAPTURE_WAIT (default), saveSnapshot() blocks until an encoder thread has written a frame:
+ no frame is lost but the rendering is slowed down to the encoding speed. With \c CAPTURE_DROP, the
+ new frame is not captured (its snapshotCounter() number is skipped) and droppedFrameCount() is
+ incremented: the rendering rate is preserved, use this mode for interactive recordings. */
+QGLViewer::CaptureBackpressure QGLViewer::captureBackpressure() const
+{
+	return (frameCapture_->backpressure() == qglviewer::FrameCapture::DROP) ? CAPTURE_DROP : CAPTURE_WAIT;
+}
+
+/*! Sets the captureBackpressure() policy. */
+void QGLViewer::setCaptureBackpressure(CaptureBackpressure policy)
+{
+	frameCapture_->setBackpressure((policy == CAPTURE_DROP) ? qglviewer::FrameCapture::DROP : qglviewer::FrameCapture::WAIT);
+}
+
+/*! Returns the number of threads that encode and write the frames of an image sequence. Default
+ value is the number of cores minus one (at least one). Set using setCaptureEncoderCount(). */
+int QGLViewer::captureEncoderCount() const
+{
+	return frameCapture_->encoderCount();
+}
+
+/*! Sets the captureEncoderCount(). */
+void QGLViewer::setCaptureEncoderCount(int count)
+{
+	frameCapture_->setEncoderCount(count);
+}
+
+/*! Returns the number of image sequence frames written since the last resetCaptureStatistics().
+ See also droppedFrameCount() and failedFrameCount(). */
+int QGLViewer::capturedFrameCount() const
+{
+	return frameCapture_->writtenFrameCount();
+}
+
+/*! Returns the number of image sequence frames dropped by the \c CAPTURE_DROP captureBackpressure()
+ since the last resetCaptureStatistics(). */
+int QGLViewer::droppedFrameCount() const
+{
+	return frameCapture_->droppedFrameCount();
+}
+
+/*! Returns the number of image sequence frames that could not be read back or written since the
+ last resetCaptureStatistics(). */
+int QGLViewer::failedFrameCount() const
+{
+	return frameCapture_->failedFrameCount();
+}
+
+/*! Resets capturedFrameCount(), droppedFrameCount() and failedFrameCount() to 0. */
+void QGLViewer::resetCaptureStatistics()
+{
+	frameCapture_->resetStatistics();
+}
+
+/*! Blocks until all the frames of the image sequence captured so far by saveSnapshot() are written.
+ Call this method before using the files, or before the application exits. */
+void QGLViewer::waitForCapturedFrames()
+{
+	captureFlushTimer_.stop();
+	flushCapture();
+	frameCapture_->waitForEncoders();
+}
+
+// The last frames of a sequence stay in the pixel pack buffers until the capture pauses
+void QGLViewer::flushCapture()
+{
+	makeCurrent();
+	frameCapture_->flush();
+}
+
 // Pops-up an image settings dialog box and save to fileName.
 // Returns false in case of problem.
 bool QGLViewer::saveImageSnapshot(const QString& fileName)
@@ -365,6 +774,20 @@ bool QGLViewer::saveImageSnapshot(const QString& fileName)
 			yMin = xMin / newAspectRatio;
 	}
 
+	// Offscreen rendering at the final resolution, encoded in a background thread
+	const bool fitHeight = (expand && (newAspectRatio>aspectRatio)) || (!expand && (newAspectRatio<aspectRatio));
+	if (QGLFramebufferObject::hasOpenGLFramebufferObjects())
+	{
+		makeCurrent();
+		if (saveImageSnapshotOffscreen(fileName, finalSize, oversampling, xMin, yMin, fitHeight))
+		{
+			if (imageInterface->whiteBackground->isChecked())
+				setBackgroundColor(previousBGColor);
+			return true;
+		}
+	}
+
+	// Fallback: tiles of the on screen frame buffer
 	QImage image(finalSize.width(), finalSize.height(), QImage::Format_ARGB32);
 
 	if (image.isNull())
@@ -470,7 +893,7 @@ bool QGLViewer::saveImageSnapshot(const QString& fileName)
 			count++;
 		}
 
-	bool saveOK = image.save(fileName, snapshotFormat().toLatin1().constData(), snapshotQuality());
+	bool saveOK = qglviewer::FrameCapture::writeImage(image, fileName, snapshotFormat(), snapshotQuality());
 
 	// ProgressDialog::hideProgressDialog();
 	// setCursor(QCursor(Qt::ArrowCursor));
@@ -521,9 +944,17 @@ bool QGLViewer::saveImageSnapshot(const QString& fileName)
  }
  \endcode
 
+ Such an image sequence is captured asynchronously: the frame buffer read back goes through a ring
+ of pixel pack buffers and the images are written by background encoder threads, so that the
+ rendering loop is not slowed down by the disk. The files hence appear some frames later. Use
+ captureQueueSize() and captureBackpressure() to bound the memory used by frames waiting to be
+ written, capturedFrameCount() and droppedFrameCount() to monitor the capture and
+ waitForCapturedFrames() to wait until all the files are written. The \c "RAW" snapshotFormat()
+ writes the bare RGBA pixels, which is the fastest option for long sequences.
+
  If snapshotCounter() is negative, no number is appended to snapshotFileName() and the
  snapshotCounter() is not incremented. This is useful to force the creation of a file, overwriting
- the previous one.
+ the previous one. This file is written synchronously.
 
  When \p overwrite is set to \c false (default), a window asks for confirmation if the file already
  exists. In \p automatic mode, the snapshotCounter() is incremented (if positive) until a
@@ -580,10 +1011,23 @@ void QGLViewer::saveSnapshot(bool automatic, bool overwrite)
 		saveOK = (saveVectorialSnapshot(fileInfo.filePath(), this, snapshotFormat()) <= 0);
 	else
 #endif
-		if (automatic)
+		if (automatic && (snapshotCounter() >= 0))
+		{
+			// Image sequence: asynchronous read back and encoding, see captureQueueSize()
+			makeCurrent();
+#if QT_VERSION >= 0x050000
+			const int ratio = int(devicePixelRatio());
+#else
+			const int ratio = 1;
+#endif
+			frameCapture_->capture(ratio * width(), ratio * height(), fileInfo.filePath(), snapshotFormat(), snapshotQuality());
+			captureFlushTimer_.start();
+			return;
+		}
+		else if (automatic)
 		{
 			QImage snapshot = frameBufferSnapshot();
-			saveOK = snapshot.save(fileInfo.filePath(), snapshotFormat().toLatin1().constData(), snapshotQuality());
+			saveOK = qglviewer::FrameCapture::writeImage(snapshot, fileInfo.filePath(), snapshotFormat(), snapshotQuality());
 		}
 		else
 			saveOK = saveImageSnapshot(fileInfo.filePath());
@@ -0,0 +1,429 @@
+/****************************************************************************
+
+ Copyright (C) 2002-2014 Gilles Debunne. All rights reserved.
+
+ This file is part of the QGLViewer library version 2.6.3.
+
+ http://www.libqglviewer.com - contact@libqglviewer.com
+
+ This file may be used under the terms of the GNU General Public License
+ versions 2.0 or 3.0 as published by the Free Software Foundation and
+ appearing in the LICENSE file included in the packaging of this file.
+ In addition, as a special exception, Gilles Debunne gives you certain
+ additional rights, described in the file GPL_EXCEPTION in this package.
+
+ libQGLViewer uses dual licensing. Commercial/proprietary software must
+ purchase a libQGLViewer Commercial License.
+
+ This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+
+*****************************************************************************/
+
+#include "textRenderer.h"
+#include "retainedGeometry.h"
+
+#include <QFontMetricsF>
+#include <QPainter>
+
+#if QT_VERSION >= 0x050100
+# include <QOpenGLBuffer>
+# include <QOpenGLShaderProgram>
+# include <QOpenGLVertexArrayObject>
+#endif
+
+#include <math.h>
+
+using namespace qglviewer;
+
+// Interleaved vertex: position (3), texture coordinates in atlas pixels (2), color (4)
+static const int vertexSize = 9;
+// Atlas image width, its height grows as needed
+static const int atlasWidth = 512;
+// Transparent border around each glyph, avoids bleeding with linear filtering
+static const int glyphPadding = 1;
+
+#if QT_VERSION >= 0x050100
+namespace {
+const char* const vertexShaderSource =
+	"#version 150\n"
+	"in vec3 position;\n"
+	"in vec2 texCoord;\n"
+	"in vec4 color;\n"
+	"uniform mat4 projection;\n"
+	"uniform vec2 textureScale;\n"
+	"out vec2 glyphCoord;\n"
+	"out vec4 glyphColor;\n"
+	"void main()\n"
+	"{\n"
+	"	glyphCoord = texCoord * textureScale;\n"
+	"	glyphColor = color;\n"
+	"	gl_Position = projection * vec4(position, 1.0);\n"
+	"}\n";
+
+const char* const fragmentShaderSource =
+	"#version 150\n"
+	"in vec2 glyphCoord;\n"
+	"in vec4 glyphColor;\n"
+	"uniform sampler2D glyphs;\n"
+	"out vec4 fragColor;\n"
+	"void main()\n"
+	"{\n"
+	"	fragColor = vec4(glyphColor.rgb, glyphColor.a * texture(glyphs, glyphCoord).a);\n"
+	"}\n";
+}
+#endif
+
+TextRenderer::TextRenderer()
+	: nbQuads_(0), context_(NULL)
+#if QT_VERSION >= 0x050100
+	, program_(NULL), buffer_(NULL), vertexArray_(NULL)
+#endif
+{}
+
+/*! Textures and buffers are released if their context is current. */
+TextRenderer::~TextRenderer()
+{
+	resetTextures();
+	qDeleteAll(atlases_);
+}
+
+/*! Forgets the textures and core profile objects. They are deleted if their context is current, and
+  lost otherwise. */
+void TextRenderer::resetTextures()
+{
+	const bool contextIsCurrent = context_ && (context_ == QGLContext::currentContext());
+	Q_FOREACH (Atlas* atlas, atlases_)
+	{
+		if (atlas->texture && contextIsCurrent)
+			glDeleteTextures(1, &atlas->texture);
+		atlas->texture = 0;
+		atlas->textureIsValid = false;
+	}
+
+#if QT_VERSION >= 0x050100
+	delete program_;
+	delete buffer_;
+	if (contextIsCurrent)
+		delete vertexArray_;
+	program_ = NULL;
+	buffer_ = NULL;
+	vertexArray_ = NULL;
+#endif
+	context_ = NULL;
+}
+
+/*! Returns the atlas of \p font, created with the printable ASCII glyphs when needed. */
+TextRenderer::Atlas* TextRenderer::atlas(const QFont& font)
+{
+	const QString key = font.key();
+	QHash<QString, Atlas*>::const_iterator it = atlases_.constFind(key);
+	if (it != atlases_.constEnd())
+		return it.value();
+
+	Atlas* atlas = new Atlas();
+	atlas->font = font;
+	atlas->image = QImage(atlasWidth, 128, QImage::Format_ARGB32_Premultiplied);
+	atlas->image.fill(0);
+	atlas->shelfX = atlas->shelfY = atlas->shelfHeight = 0;
+	atlas->texture = 0;
+	atlas->textureIsValid = false;
+	atlases_.insert(key, atlas);
+
+	for (ushort c=32; c<127; ++c)
+		glyph(atlas, QChar(c));
+
+	return atlas;
+}
+
+/*! Returns the glyph of \p c in \p atlas, rasterized in the atlas image the first time. */
+const TextRenderer::Glyph& TextRenderer::glyph(Atlas* atlas, QChar c)
+{
+	QHash<ushort, Glyph>::const_iterator it = atlas->glyphs.constFind(c.unicode());
+	if (it != atlas->glyphs.constEnd())
+		return it.value();
+
+	const QFontMetricsF metrics(atlas->font);
+	const QRectF bounds = metrics.boundingRect(c);
+
+	Glyph g;
+	g.advance = metrics.width(c);
+
+	const int w = int(ceil(bounds.width())) + 2*glyphPadding;
+	const int h = int(ceil(bounds.height())) + 2*glyphPadding;
+	if (bounds.isEmpty() || w > atlas->image.width())
+		// Blank (space) or too large: advance only
+		return *atlas->glyphs.insert(c.unicode(), g);
+
+	// Next shelf when the current one is full
+	if (atlas->shelfX + w > atlas->image.width())
+	{
+		atlas->shelfY += atlas->shelfHeight;
+		atlas->shelfX = 0;
+		atlas->shelfHeight = 0;
+	}
+	// Grow the image, previous glyphs keep their pixel coordinates
+	while (atlas->shelfY + h > atlas->image.height())
+		atlas->image = atlas->image.copy(0, 0, atlas->image.width(), 2*atlas->image.height());
+
+	const QPointF origin(atlas->shelfX + glyphPadding - bounds.left(), atlas->shelfY + glyphPadding - bounds.top());
+	QPainter painter(&atlas->image);
+	painter.setFont(atlas->font);
+	painter.setPen(Qt::white);
+	painter.drawText(origin, QString(c));
+	painter.end();
+
+	g.texture = QRectF(atlas->shelfX, atlas->shelfY, w, h);
+	g.quad = QRectF(bounds.left() - glyphPadding, bounds.top() - glyphPadding, w, h);
+
+	atlas->shelfX += w;
+	atlas->shelfHeight = qMax(atlas->shelfHeight, h);
+	atlas->textureIsValid = false;
+
+	return *atlas->glyphs.insert(c.unicode(), g);
+}
+
+/*! Adds \p text to the batch. (\p x, \p y) is the start of the baseline of the first line, in pixels.
+  See the class documentation for \p depth. */
+void TextRenderer::addText(qreal x, qreal y, qreal depth, const QString& text, const QFont& font, const QColor& color)
+{
+	if (text.isEmpty())
+		return;
+
+	Atlas* const a = atlas(font);
+	const GLfloat z = GLfloat(depth);
+	const GLfloat r = GLfloat(color.redF()), g = GLfloat(color.greenF());
+	const GLfloat b = GLfloat(color.blueF()), alpha = GLfloat(color.alphaF());
+	const qreal lineSpacing = QFontMetricsF(a->font).lineSpacing();
+
+	// Pixel aligned pen for crisp glyphs
+	const qreal startX = floor(x + 0.5);
+	qreal penX = startX;
+	qreal penY = floor(y + 0.5);
+
+	a->vertices.reserve(a->vertices.size() + 6*vertexSize*text.size());
+	for (int i=0; i<text.size(); ++i)
+	{
+		const QChar c = text.at(i);
+		if (c == QLatin1Char('\n'))
+		{
+			penX = startX;
+			penY += lineSpacing;
+			continue;
+		}
+
+		const Glyph& gl = glyph(a, c);
+		if (!gl.quad.isEmpty())
+		{
+			const GLfloat x0 = GLfloat(penX + gl.quad.left()), x1 = GLfloat(penX + gl.quad.right());
+			const GLfloat y0 = GLfloat(penY + gl.quad.top()),  y1 = GLfloat(penY + gl.quad.bottom());
+			const GLfloat u0 = GLfloat(gl.texture.left()), u1 = GLfloat(gl.texture.right());
+			const GLfloat v0 = GLfloat(gl.texture.top()),  v1 = GLfloat(gl.texture.bottom());
+
+			a->vertices << x0 << y0 << z << u0 << v0 << r << g << b << alpha
+						<< x1 << y0 << z << u1 << v0 << r << g << b << alpha
+						<< x1 << y1 << z << u1 << v1 << r << g << b << alpha
+						<< x0 << y0 << z << u0 << v0 << r << g << b << alpha
+						<< x1 << y1 << z << u1 << v1 << r << g << b << alpha
+						<< x0 << y1 << z << u0 << v1 << r << g << b << alpha;
+			++nbQuads_;
+		}
+		penX += gl.advance;
+	}
+}
+
+/*! Uploads the atlas image in its texture, created if needed. */
+void TextRenderer::uploadTexture(Atlas* atlas)
+{
+	if (!atlas->texture)
+		glGenTextures(1, &atlas->texture);
+
+	// White glyphs: premultiplied color is the coverage, only alpha matters
+	const QImage& image = atlas->image;
+	QVector<uchar> pixels(4 * image.width() * image.height(), 255);
+	for (int y=0; y<image.height(); ++y)
+	{
+		const QRgb* line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+		uchar* dest = pixels.data() + 4 * y * image.width();
+		for (int x=0; x<image.width(); ++x)
+			dest[4*x+3] = uchar(qAlpha(line[x]));
+	}
+
+	glBindTexture(GL_TEXTURE_2D, atlas->texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+#ifdef GL_CLAMP_TO_EDGE
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+#endif
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width(), image.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.constData());
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	atlas->textureIsValid = true;
+}
+
+/*! Draws the batched texts in a \p width x \p height pixels viewport and clears the batch. The
+  OpenGL state is preserved. */
+void TextRenderer::draw(int width, int height)
+{
+	if (isEmpty())
+		return;
+
+	if (context_ != QGLContext::currentContext())
+	{
+		resetTextures();
+		context_ = QGLContext::currentContext();
+	}
+
+	Q_FOREACH (Atlas* atlas, atlases_)
+		if (!atlas->vertices.isEmpty() && !atlas->textureIsValid)
+			uploadTexture(atlas);
+
+	if (RetainedGeometry::isCoreProfile())
+		drawCore(width, height);
+	else
+		drawFixed(width, height);
+
+	Q_FOREACH (Atlas* atlas, atlases_)
+		atlas->vertices.clear();
+	nbQuads_ = 0;
+}
+
+void TextRenderer::drawFixed(int width, int height)
+{
+	glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_TEXTURE_BIT | GL_TRANSFORM_BIT | GL_CURRENT_BIT);
+	glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	glOrtho(0, width, height, 0, 0.0, -1.0);
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+	glMatrixMode(GL_TEXTURE);
+	glPushMatrix();
+
+	glDisable(GL_LIGHTING);
+	glEnable(GL_TEXTURE_2D);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	// Screen texts have a 0.0 depth: always drawn when the depth test is enabled
+	glDepthFunc(GL_LEQUAL);
+	glDepthMask(GL_FALSE);
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_NORMAL_ARRAY);
+
+	const GLsizei stride = vertexSize * sizeof(GLfloat);
+	Q_FOREACH (Atlas* atlas, atlases_)
+	{
+		if (atlas->vertices.isEmpty())
+			continue;
+
+		glBindTexture(GL_TEXTURE_2D, atlas->texture);
+		// Texture coordinates are atlas pixels
+		glLoadIdentity();
+		glScaled(1.0 / atlas->image.width(), 1.0 / atlas->image.height(), 1.0);
+
+		const GLfloat* data = atlas->vertices.constData();
+		glVertexPointer(3, GL_FLOAT, stride, data);
+		glTexCoordPointer(2, GL_FLOAT, stride, data + 3);
+		glColorPointer(4, GL_FLOAT, stride, data + 5);
+		glDrawArrays(GL_TRIANGLES, 0, atlas->vertices.size() / vertexSize);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	glPopMatrix();
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+
+	glPopClientAttrib();
+	glPopAttrib();
+}
+
+void TextRenderer::drawCore(int width, int height)
+{
+#if QT_VERSION >= 0x050100
+	if (!program_)
+	{
+		program_ = new QOpenGLShaderProgram();
+		program_->addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShaderSource);
+		program_->addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShaderSource);
+		program_->bindAttributeLocation("position", 0);
+		program_->bindAttributeLocation("texCoord", 1);
+		program_->bindAttributeLocation("color", 2);
+		if (!program_->link())
+			qWarning("TextRenderer: unable to link the core profile program: %s", qPrintable(program_->log()));
+
+		buffer_ = new QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+		buffer_->setUsagePattern(QOpenGLBuffer::StreamDraw);
+		buffer_->create();
+
+		vertexArray_ = new QOpenGLVertexArrayObject();
+		vertexArray_->create();
+	}
+	if (!program_->isLinked() || !buffer_->isCreated() || !program_->bind())
+		return;
+
+	// Saved OpenGL state
+	const GLboolean blend = glIsEnabled(GL_BLEND);
+	GLint blendSrc, blendDst, depthFunc;
+	GLboolean depthMask;
+	glGetIntegerv(GL_BLEND_SRC_RGB, &blendSrc);
+	glGetIntegerv(GL_BLEND_DST_RGB, &blendDst);
+	glGetIntegerv(GL_DEPTH_FUNC, &depthFunc);
+	glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDepthFunc(GL_LEQUAL);
+	glDepthMask(GL_FALSE);
+
+	QMatrix4x4 projection;
+	projection.ortho(0.0f, float(width), float(height), 0.0f, 0.0f, -1.0f);
+	program_->setUniformValue("projection", projection);
+	program_->setUniformValue("glyphs", 0);
+
+	vertexArray_->bind();
+	buffer_->bind();
+	const int stride = vertexSize * sizeof(GLfloat);
+	program_->enableAttributeArray(0);
+	program_->enableAttributeArray(1);
+	program_->enableAttributeArray(2);
+	program_->setAttributeBuffer(0, GL_FLOAT, 0, 3, stride);
+	program_->setAttributeBuffer(1, GL_FLOAT, 3 * sizeof(GLfloat), 2, stride);
+	program_->setAttributeBuffer(2, GL_FLOAT, 5 * sizeof(GLfloat), 4, stride);
+
+	Q_FOREACH (Atlas* atlas, atlases_)
+	{
+		if (atlas->vertices.isEmpty())
+			continue;
+
+		buffer_->allocate(atlas->vertices.constData(), atlas->vertices.size() * int(sizeof(GLfloat)));
+		glBindTexture(GL_TEXTURE_2D, atlas->texture);
+		program_->setUniformValue("textureScale", 1.0f / atlas->image.width(), 1.0f / atlas->image.height());
+		glDrawArrays(GL_TRIANGLES, 0, atlas->vertices.size() / vertexSize);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	buffer_->release();
+	vertexArray_->release();
+	program_->release();
+
+	if (!blend)
+		glDisable(GL_BLEND);
+	glBlendFunc(GLenum(blendSrc), GLenum(blendDst));
+	glDepthFunc(GLenum(depthFunc));
+	glDepthMask(depthMask);
+#else
+	Q_UNUSED(width);
+	Q_UNUSED(height);
+#endif
+}
@@ -0,0 +1,120 @@
+/****************************************************************************
+
+ Copyright (C) 2002-2014 Gilles Debunne. All rights reserved.
+
+ This file is part of the QGLViewer library version 2.6.3.
+
+ http://www.libqglviewer.com - contact@libqglviewer.com
+
+ This file may be used under the terms of the GNU General Public License
+ versions 2.0 or 3.0 as published by the Free Software Foundation and
+ appearing in the LICENSE file included in the packaging of this file.
+ In addition, as a special exception, Gilles Debunne gives you certain
+ additional rights, described in the file GPL_EXCEPTION in this package.
+
+ libQGLViewer uses dual licensing. Commercial/proprietary software must
+ purchase a libQGLViewer Commercial License.
+
+ This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+
+*****************************************************************************/
+
+#ifndef QGLVIEWER_TEXT_RENDERER_H
+#define QGLVIEWER_TEXT_RENDERER_H
+
+#include "config.h"
+#include <QColor>
+#include <QFont>
+#include <QHash>
+#include <QImage>
+#include <QRectF>
+#include <QVector>
+
+#if QT_VERSION >= 0x050100
+class QOpenGLBuffer;
+class QOpenGLShaderProgram;
+class QOpenGLVertexArrayObject;
+#endif
+
+namespace qglviewer {
+
+/*! \brief Batched text drawing from glyph atlas textures, used by QGLViewer::drawText().
+  \class TextRenderer textRenderer.h QGLViewer/textRenderer.h
+
+  addText() only lays out the text: each character is a textured quad referencing a glyph of the
+  atlas of its font. A font atlas is rasterized with QPainter the first time the font is used
+  (printable ASCII characters, other characters are added when first met) and is then kept in a
+  texture. draw() draws all the texts added since the previous draw() with one \c glDrawArrays per
+  font, and clears the batch.
+
+  Coordinates are widget pixels, origin in the upper left corner. The depth is a window depth in
+  [0,1]: 0.0 is always on top, projected depths (see Camera::projectedCoordinatesOf()) are hidden by
+  closer geometry when the depth test is enabled.
+
+  Textures are created in the current context of the first draw(). They are recreated (the previous
+  ones are lost) if draw() is called from an other context.
+
+  Internal class used by QGLViewer, not installed. */
+class TextRenderer
+{
+public:
+	TextRenderer();
+	~TextRenderer();
+
+	void addText(qreal x, qreal y, qreal depth, const QString& text, const QFont& font, const QColor& color);
+	/*! Returns \c true when no text was added since the last draw(). */
+	bool isEmpty() const { return nbQuads_ == 0; }
+
+	void draw(int width, int height);
+
+private:
+	// Copy would share the textures
+	TextRenderer(const TextRenderer&);
+	TextRenderer& operator=(const TextRenderer&);
+
+	struct Glyph
+	{
+		// Texture coordinates of the glyph in the atlas image
+		QRectF texture;
+		// Quad, relative to the pen position on the baseline
+		QRectF quad;
+		qreal advance;
+	};
+
+	struct Atlas
+	{
+		QFont font;
+		QImage image;
+		QHash<ushort, Glyph> glyphs;
+		// Shelf packing state
+		int shelfX, shelfY, shelfHeight;
+		GLuint texture;
+		bool textureIsValid;
+		// Batched quads: interleaved x, y, z, u, v, r, g, b, a
+		QVector<GLfloat> vertices;
+	};
+
+	Atlas* atlas(const QFont& font);
+	const Glyph& glyph(Atlas* atlas, QChar c);
+	void uploadTexture(Atlas* atlas);
+	void resetTextures();
+
+	void drawFixed(int width, int height);
+	void drawCore(int width, int height);
+
+	QHash<QString, Atlas*> atlases_;
+	int nbQuads_;
+	// Context of the textures, only compared
+	const void* context_;
+
+#if QT_VERSION >= 0x050100
+	QOpenGLShaderProgram* program_;
+	QOpenGLBuffer* buffer_;
+	QOpenGLVertexArrayObject* vertexArray_;
+#endif
+};
+
+} // namespace qglviewer
+
+#endif // QGLVIEWER_TEXT_RENDERER_H
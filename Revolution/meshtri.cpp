@@ -1,16 +1,29 @@
 #include "meshtri.h"
 #include "matrices.h"
+#include <OGLRender/batchmath.h>
+
+MeshTri::MeshTri():
+	m_shader_flat(NULL),
+	m_shader_phong(NULL),
+	m_batch(NULL),
+	m_batch_id(-1),
+	m_batch_dirty(false)
+{
+}
+
 
-MeshTri::MeshTri()
+MeshTri::~MeshTri()
 {
+	ShaderProgramRegistry::release(m_shader_flat);
+	ShaderProgramRegistry::release(m_shader_phong);
 }
 
 
 
 void MeshTri::gl_init()
 {
-	m_shader_flat = new ShaderProgramFlat();
-	m_shader_phong = new ShaderProgramPhong();
+	m_shader_flat = ShaderProgramRegistry::acquire<ShaderProgramFlat>();
+	m_shader_phong = ShaderProgramRegistry::acquire<ShaderProgramPhong>();
 
 	//VBO
 	glGenBuffers(1, &m_vbo);
@@ -63,6 +76,8 @@ void MeshTri::gl_update()
         glBufferData(GL_ELEMENT_ARRAY_BUFFER,m_indices.size() * sizeof(int), &(m_indices[0]), GL_STATIC_DRAW);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     }
+
+    m_batch_dirty = true;
 }
 
 
@@ -77,38 +92,85 @@ void MeshTri::set_matrices(const Mat4& view, const Mat4& projection)
 void MeshTri::draw(const Vec3& color)
 {
 	m_shader_flat->startUseProgram();
+	GLState::bindVertexArray(m_vao);
+	draw_flat(color);
+	m_shader_flat->stopUseProgram();
+}
 
-	m_shader_flat->sendViewMatrix(viewMatrix);
-	m_shader_flat->sendProjectionMatrix(projectionMatrix);
 
-	glUniform3fv(m_shader_flat->idOfColorUniform, 1, glm::value_ptr(color));
+void MeshTri::draw_smooth(const Vec3& color)
+{
+	m_shader_phong->startUseProgram();
+	GLState::bindVertexArray(m_vao2);
+	draw_phong(color);
+	m_shader_phong->stopUseProgram();
+}
 
-	glBindVertexArray(m_vao);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,m_ebo);
-	glDrawElements(GL_TRIANGLES, m_indices.size(),GL_UNSIGNED_INT,0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,0);
-	glBindVertexArray(0);
 
-	m_shader_flat->stopUseProgram();
+void MeshTri::submit(RenderQueue& queue, const Vec3& color)
+{
+	RenderQueue::Command cmd = RenderQueue::command(m_shader_flat->programId(), m_vao, &MeshTri::queued_flat, this);
+	cmd.color = color;
+	queue.push(cmd);
 }
 
 
-void MeshTri::draw_smooth(const Vec3& color)
+void MeshTri::submit_smooth(RenderQueue& queue, const Vec3& color)
 {
-	m_shader_phong->startUseProgram();
+	RenderQueue::Command cmd = RenderQueue::command(m_shader_phong->programId(), m_vao2, &MeshTri::queued_phong, this);
+	cmd.color = color;
+	queue.push(cmd);
+}
 
-	m_shader_phong->sendViewMatrix(viewMatrix);
-	m_shader_phong->sendProjectionMatrix(projectionMatrix);
 
-	glUniform3fv(m_shader_phong->idOfColorUniform, 1, glm::value_ptr(color));
+void MeshTri::queued_flat(void* mesh, const RenderQueue::Command& cmd)
+{
+	static_cast<MeshTri*>(mesh)->draw_flat(cmd.color);
+}
 
-	glBindVertexArray(m_vao2);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,m_ebo);
-	glDrawElements(GL_TRIANGLES, m_indices.size(),GL_UNSIGNED_INT,0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,0);
-	glBindVertexArray(0);
 
-	m_shader_phong->stopUseProgram();
+void MeshTri::queued_phong(void* mesh, const RenderQueue::Command& cmd)
+{
+	static_cast<MeshTri*>(mesh)->draw_phong(cmd.color);
+}
+
+
+void MeshTri::submit(MeshBatch& batch, const Vec3& color)
+{
+	if (m_batch != &batch)
+	{
+		m_batch = &batch;
+		m_batch_id = batch.add_mesh(m_points, m_indices);
+	}
+	else if (m_batch_dirty)
+		batch.set_mesh(m_batch_id, m_points, m_indices);
+	m_batch_dirty = false;
+
+	batch.draw(m_batch_id, Mat4(), color);
+}
+
+
+void MeshTri::draw_flat(const Vec3& color)
+{
+	m_shader_flat->sendCamera(viewMatrix, projectionMatrix);
+	m_shader_flat->sendModelMatrix(Mat4());
+
+	GLState::uniform3fv(m_shader_flat->idOfColorUniform, glm::value_ptr(color));
+
+	GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER,m_ebo);
+	GLState::drawElements(GL_TRIANGLES, m_indices.size(),GL_UNSIGNED_INT,0);
+}
+
+
+void MeshTri::draw_phong(const Vec3& color)
+{
+	m_shader_phong->sendCamera(viewMatrix, projectionMatrix);
+	m_shader_phong->sendModelMatrix(Mat4());
+
+	GLState::uniform3fv(m_shader_phong->idOfColorUniform, glm::value_ptr(color));
+
+	GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER,m_ebo);
+	GLState::drawElements(GL_TRIANGLES, m_indices.size(),GL_UNSIGNED_INT,0);
 }
 
 // wipe out (sort of)
@@ -262,19 +324,12 @@ void MeshTri::revolution(const std::vector<Vec3>& poly)
 
     int n = poly.size();
 
-    int m = 0;
+    int m = 360;
 
-    for (int alpha = 0; alpha < 360; alpha += 1)
-    {
-        Mat4 R = rotateY(alpha);
-        // c++ 11 : "for range" for(var container)
-        for (const Vec3& P: poly)
-        {
-            Vec3 Q = Vec3(R*Vec4(P,1));
-            add_vertex(Q);
-        }
-        m++;
-    }
+    // une rangee de n points par angle, tournee d'un bloc
+    m_points.resize(m*n);
+    for (int alpha = 0; alpha < m; alpha += 1)
+        BatchMath::transform_points(rotateY(alpha), poly.data(), m_points.data() + alpha*n, n);
 
     // les triangles
     for (int j = 0; j < m-1; ++j)
@@ -4,6 +4,9 @@
 #include <vector>
 #include <OGLRender/shaderprogramflat.h>
 #include <OGLRender/shaderprogramphong.h>
+#include <OGLRender/shaderprogramregistry.h>
+#include <OGLRender/renderqueue.h>
+#include <OGLRender/meshbatch.h>
 
 #include <matrices.h>
 
@@ -31,6 +34,12 @@ class MeshTri
 	GLuint m_vao2;
 	GLuint m_vbo2;
 
+	/// lot partage ou le maillage est range (submit(MeshBatch&))
+	MeshBatch* m_batch;
+	int m_batch_id;
+	/// maillage modifie depuis le dernier envoi au lot
+	bool m_batch_dirty;
+
 
 	/**
 	 * @brief tourne un polygone autour de  l'axe Y
@@ -39,11 +48,24 @@ class MeshTri
 	 */
 	std::vector<Vec3> tourne(const std::vector<Vec3>& poly);
 
+	/// dessin facetise (programme flat et m_vao lies)
+	void draw_flat(const Vec3& color);
+
+	/// dessin lisse (programme phong et m_vao2 lies)
+	void draw_phong(const Vec3& color);
+
+	/// draws de la file de rendu (cmd.color: couleur)
+	static void queued_flat(void* mesh, const RenderQueue::Command& cmd);
+	static void queued_phong(void* mesh, const RenderQueue::Command& cmd);
+
 
 
 public:
 	MeshTri();
 
+	/// rend les programmes au registre (contexte GL courant)
+	~MeshTri();
+
 	/**
 	 * @brief init openGL
 	 */
@@ -73,6 +95,28 @@ public:
 	 */
 	void draw_smooth(const Vec3& color);
 
+	/**
+	 * @brief ajoute le dessin facetise a une file de rendu
+	 * @param queue file de rendu de la frame
+	 * @param color couleur de rendu
+	 */
+	void submit(RenderQueue& queue, const Vec3& color);
+
+	/**
+	 * @brief ajoute le dessin lisse a une file de rendu
+	 * @param queue file de rendu de la frame
+	 * @param color couleur de rendu
+	 */
+	void submit_smooth(RenderQueue& queue, const Vec3& color);
+
+	/**
+	 * @brief dessin facetise a travers un lot partage
+	 * (le maillage y est range au 1er appel et apres chaque modification)
+	 * @param batch lot de la scene
+	 * @param color couleur de rendu
+	 */
+	void submit(MeshBatch& batch, const Vec3& color);
+
 	/**
 	 * @brief nettoyage des donnees
 	 */
@@ -1,16 +1,23 @@
 #include "polygon.h"
 #include <cstdint>
 
-PolygonEditor::PolygonEditor()
+PolygonEditor::PolygonEditor():
+	m_shader_color(NULL)
 {
 
 }
 
 
+PolygonEditor::~PolygonEditor()
+{
+	ShaderProgramRegistry::release(m_shader_color);
+}
+
+
 void PolygonEditor::gl_init()
 {
 	// SHADER
-	m_shader_color = new ShaderProgramColor();
+	m_shader_color = ShaderProgramRegistry::acquire<ShaderProgramColor>();
 
 	//VBO
 	glGenBuffers(1, &m_vbo);
@@ -29,21 +36,19 @@ void PolygonEditor::draw(const Vec3& color)
 {
 	Mat4 id;
 
-	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, m_vbo);
 	glBufferData(GL_ARRAY_BUFFER, m_points.size()*sizeof(Vec3), m_points.data(), GL_STATIC_DRAW);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
 	m_shader_color->startUseProgram();
-	m_shader_color->sendViewMatrix(id);
-	m_shader_color->sendProjectionMatrix(id);
+	m_shader_color->sendCamera(id, id);
+	m_shader_color->sendModelMatrix(id);
 
-	glUniform3fv(m_shader_color->idOfColorUniform, 1, glm::value_ptr(color));
+	GLState::uniform3fv(m_shader_color->idOfColorUniform, glm::value_ptr(color));
 
-	glBindVertexArray(m_vao);
+	GLState::bindVertexArray(m_vao);
 	glPointSize(4.0);
-	glDrawArrays(GL_POINTS, 0, m_points.size());
-	glDrawArrays(GL_LINE_STRIP, 0, m_points.size());
-	glBindVertexArray(0);
+	GLState::drawArrays(GL_POINTS, 0, m_points.size());
+	GLState::drawArrays(GL_LINE_STRIP, 0, m_points.size());
 	m_shader_color->stopUseProgram();
 }
 
@@ -3,6 +3,7 @@
 
 #include <GL/glew.h>
 #include <OGLRender/shaderprogramcolor.h>
+#include <OGLRender/shaderprogramregistry.h>
 #include <vector>
 
 #include <matrices.h>
@@ -18,6 +19,9 @@ class PolygonEditor
 public:
 	PolygonEditor();
 
+	/// rend le programme au registre (contexte GL courant)
+	~PolygonEditor();
+
 	void draw(const Vec3& color);
 
 	void add_vertex(float x, float y);
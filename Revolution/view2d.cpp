@@ -9,6 +9,11 @@ View2D::View2D(const QGLWidget* widg):
 	QGLWidget(NULL,widg)
 {}
 
+View2D::~View2D()
+{
+	makeCurrent();
+}
+
 void View2D::initializeGL()
 {
 	makeCurrent();
@@ -31,10 +36,12 @@ void View2D::initializeGL()
 void View2D::paintGL()
 {
 	makeCurrent();
+	GLState::begin_frame();
 	glClear(GL_COLOR_BUFFER_BIT);
 
 	m_poly.draw(Vec3(1,1,0));
 
+	GLState::end_frame();
 }
 
 void View2D::mousePressEvent(QMouseEvent *event)
@@ -5,6 +5,7 @@
 #include <QGLWidget>
 
 #include <OGLRender/shaderprogramcolor.h>
+#include <OGLRender/glstate.h>
 
 #include "polygon.h"
 
@@ -16,6 +17,9 @@ public:
 
     View2D(const QGLWidget* widg);
 
+	/// contexte GL courant pendant la destruction des membres (programmes partages)
+	~View2D();
+
 	PolygonEditor m_poly;
 
 protected:
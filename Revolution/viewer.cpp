@@ -1,6 +1,7 @@
 #include "viewer.h"
 
 #include <QKeyEvent>
+#include <glm/gtc/type_ptr.hpp>
 #include <iomanip>
 
 Viewer::Viewer(PolygonEditor& poly):
@@ -19,6 +20,12 @@ Viewer::Viewer(PolygonEditor& poly):
 {}
 
 
+Viewer::~Viewer()
+{
+	makeCurrent();
+}
+
+
 void Viewer::init()
 {
 	makeCurrent();
@@ -40,8 +47,13 @@ void Viewer::init()
 
 	// initialisation variables globales
 	m_compteur = 0;
+	// un degre toutes les 40 ms, quel que soit le pas du thread
+	m_anim.start(0.0f, [] (float& compteur, double dt) { compteur += float(dt / 0.04); });
+	m_anim.set_paused(!animationIsStarted());
 
 	m_mesh.gl_init();
+	m_batch.gl_init();
+	m_batch.set_edges(false);
 }
 
 
@@ -50,6 +62,12 @@ void Viewer::init()
 void Viewer::draw()
 {
 	makeCurrent();
+	GLState::begin_frame();
+
+	// etat d'animation: interpolation entre les 2 derniers pas publies
+	float prev, cur;
+	const float alpha = m_anim.snapshot(prev, cur);
+	m_compteur = prev + (cur-prev)*alpha;
 
 	m_mesh.set_matrices(getCurrentModelViewMatrix(),getCurrentProjectionMatrix());
 
@@ -58,6 +76,15 @@ void Viewer::draw()
 
 	if (m_render_mode==1)
 		m_mesh.draw_smooth(ROUGE);
+
+	if (m_render_mode==2)
+	{
+		m_batch.set_matrices(getCurrentModelViewMatrix(),getCurrentProjectionMatrix());
+		m_mesh.submit(m_batch, ROUGE);
+		m_batch.flush();
+	}
+
+	GLState::end_frame();
 }
 
 
@@ -97,7 +124,7 @@ void Viewer::keyPressEvent(QKeyEvent *e)
 		break;
 
 		case Qt::Key_M: // touche 'x'
-				m_render_mode = (m_render_mode+1)%2;
+				m_render_mode = (m_render_mode+1)%3;
 		break;
 		default:
 			break;
@@ -110,36 +137,29 @@ void Viewer::keyPressEvent(QKeyEvent *e)
 
 
 
-void Viewer::animate()
+void Viewer::startAnimation()
+{
+	QGLViewer::startAnimation();
+	m_anim.set_paused(false);
+}
+
+
+void Viewer::stopAnimation()
 {
-	m_compteur += 1;
+	QGLViewer::stopAnimation();
+	m_anim.set_paused(true);
 }
 
 
 
 Mat4 Viewer::getCurrentModelViewMatrix() const
 {
-	GLdouble gl_mvm[16];
-	camera()->getModelViewMatrix(gl_mvm);
-	Mat4 mvm;
-	for(unsigned int i = 0; i < 4; ++i)
-	{
-		for(unsigned int j = 0; j < 4; ++j)
-			mvm[i][j] = float(gl_mvm[i*4+j]);
-	}
-	return mvm;
+	// copie de la matrice float en cache dans la camera (pas de conversion)
+	return glm::make_mat4(camera()->modelViewMatrixf());
 }
 
 
 Mat4 Viewer::getCurrentProjectionMatrix() const
 {
-	GLdouble gl_pm[16];
-	camera()->getProjectionMatrix(gl_pm);
-	Mat4 pm;
-	for(unsigned int i = 0; i < 4; ++i)
-	{
-		for(unsigned int j = 0; j < 4; ++j)
-			pm[i][j] = float(gl_pm[i*4+j]);
-	}
-	return pm;
+	return glm::make_mat4(camera()->projectionMatrixf());
 }
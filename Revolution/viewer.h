@@ -4,9 +4,10 @@
 #include <GL/glew.h>
 #include <QGLViewer/qglviewer.h>
 #include <OGLRender/shaderprogramcolor.h>
+#include <OGLRender/glstate.h>
+#include <OGLRender/animationthread.h>
 
 #include <matrices.h>
-#include <primitives.h>
 #include <meshtri.h>
 #include <polygon.h>
 
@@ -24,6 +25,9 @@ class Viewer : public QGLViewer
 public:
 	Viewer(PolygonEditor& poly);
 
+	/// contexte GL courant pendant la destruction des membres (programmes partages)
+	~Viewer();
+
 protected:
 	/// OpenGL intialisation appelee par la QGLViewer
     void init();
@@ -31,7 +35,9 @@ protected:
 	/// draw callback de la QGLViewer
     void draw();
 
-	void animate();
+	/// le timer de la QGLViewer redessine, m_anim avance l'etat
+	void startAnimation();
+	void stopAnimation();
 
 	/// callback when key pressed
     void keyPressEvent(QKeyEvent *e);
@@ -42,7 +48,7 @@ protected:
 	/// recupere la matrice de modelview de la QGLViewer
 	Mat4 getCurrentProjectionMatrix() const;
 
-    /// 0:flat 1:phong
+    /// 0:flat 1:phong 2:flat par lot partage (MeshBatch)
 	int m_render_mode;
 
     /// raccourcis couleurs
@@ -56,13 +62,19 @@ protected:
 	Vec3 GRIS;
 	Vec3 NOIR;
 
-    /// compteur animation
-	int m_compteur;
+	/// animation a pas fixe (thread): compteur incremente toutes les 20ms
+	AnimationThread<float> m_anim;
+
+    /// compteur animation (interpole a l'instant du rendu)
+	float m_compteur;
 
     /// editeur de polygon
     PolygonEditor& m_poly;
 
 	MeshTri m_mesh;
+
+	/// lot partage (mode de rendu 2: multi-draw indirect)
+	MeshBatch m_batch;
 };
 
 #endif
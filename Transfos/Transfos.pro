@@ -30,9 +30,7 @@ LIBS += -L$$_PRO_FILE_PWD_/../bin -lOGLRender -lQGLViewer33 -lopengl32
 
 
 SOURCES += main.cpp \
-    viewer.cpp \
-primitives.cpp
+    viewer.cpp
 
 HEADERS  += viewer.h \
-primitives.h \
 matrices.h
@@ -1,4 +1,5 @@
 #include <QApplication>
+#include <QStringList>
 #include "viewer.h"
 
 int main(int argc, char *argv[])
@@ -12,6 +13,22 @@ int main(int argc, char *argv[])
 	QGLFormat::setDefaultFormat(glFormat);
 
 	Viewer view;
+
+	// mesure automatique: tp_transfos --stress N [--warmup W] [--frames F] [--json fichier]
+	const QStringList args = a.arguments();
+	int stress = args.indexOf("--stress");
+	if (stress >= 0 && stress+1 < args.size())
+	{
+		auto option = [&] (const char* name, int def) -> int
+		{
+			int i = args.indexOf(name);
+			return (i >= 0 && i+1 < args.size()) ? args[i+1].toInt() : def;
+		};
+		int j = args.indexOf("--json");
+		std::string json = (j >= 0 && j+1 < args.size()) ? args[j+1].toStdString() : std::string();
+		view.set_stress(args[stress+1].toInt(), option("--warmup", 60), option("--frames", 300), json, true);
+	}
+
 	view.show();
 
 	return a.exec();
@@ -1,7 +1,17 @@
 #include "viewer.h"
 
 #include <QKeyEvent>
+#include <glm/gtc/type_ptr.hpp>
+#include <QApplication>
 #include <iomanip>
+#include <fstream>
+#include <algorithm>
+
+/// primitives par repere (sphere + 3 fleches de 2 primitives)
+static const int PRIMS_PAR_REPERE = 7;
+/// bornes du nombre d'instances de primitives du code 2
+static const int MIN_INSTANCES = 10;
+static const int MAX_INSTANCES = 1000000;
 
 
 Viewer::Viewer():
@@ -15,10 +25,94 @@ Viewer::Viewer():
 	BLANC(1,1,1),
 	GRIS(0.5,0.5,0.5),
 	NOIR(0,0,0),
-    m_code(0)   // 1 = draw repère
+    m_code(0),   // 1 = draw repère
+	m_batch(true),
+	m_lod(true),
+	m_frustum_version(0),
+	m_culling(true),
+	m_scene_code(-1),
+	m_nb_instances(100*PRIMS_PAR_REPERE),
+	m_stress_warmup(60),
+	m_stress_frames(300),
+	m_stress_quit(false),
+	m_stress_pending(false),
+	m_period_before_stress(40),
+	m_prof_overlay(false)
 {}
 
 
+Viewer::~Viewer()
+{
+	makeCurrent();
+}
+
+
+void Viewer::set_stress(int instances, int warmup, int frames, const std::string& json_path, bool quit)
+{
+	m_code = 2;
+	m_nb_instances = std::max(MIN_INSTANCES, std::min(MAX_INSTANCES, instances));
+	m_stress_warmup = warmup;
+	m_stress_frames = frames;
+	m_stress_json = json_path;
+	m_stress_quit = quit;
+	m_stress_pending = true;
+}
+
+
+int Viewer::nb_reperes() const
+{
+	return std::max(1, m_nb_instances / PRIMS_PAR_REPERE);
+}
+
+
+void Viewer::start_stress()
+{
+	m_scene_code = -1;
+
+	m_stats.set_info("instances", std::to_string(m_nb_instances));
+	m_stats.set_info("reperes", std::to_string(nb_reperes()));
+	m_stats.set_info("warmup_frames", std::to_string(m_stress_warmup));
+	m_stats.set_info("batch", m_batch ? "true" : "false");
+	m_stats.set_info("lod", m_lod ? "true" : "false");
+	m_stats.set_info("culling", m_culling ? "true" : "false");
+	std::string renderer(reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+	renderer.erase(std::remove_if(renderer.begin(), renderer.end(), [] (char c) { return c == '"' || c == '\\'; }), renderer.end());
+	m_stats.set_info("gl_renderer", "\"" + renderer + "\"");
+	m_stats.start(m_stress_warmup, m_stress_frames);
+	m_prof.reset();
+
+	// redessine en continu, sans attente entre les frames
+	m_period_before_stress = animationPeriod();
+	setAnimationPeriod(0);
+	if (animationIsStarted())
+		stopAnimation();
+	startAnimation();
+
+	std::cout << "stress : " << m_nb_instances << " instances, " << m_stress_warmup << " frames de chauffe, " << m_stress_frames << " frames mesurees" << std::endl;
+}
+
+
+void Viewer::end_stress()
+{
+	m_stats.set_info("profile", m_prof.to_json());
+	const std::string json = m_stats.to_json();
+	if (m_stress_json.empty())
+		std::cout << json << std::endl;
+	else
+	{
+		std::ofstream out(m_stress_json.c_str());
+		out << json << std::endl;
+		std::cout << "stress : resultats dans " << m_stress_json << std::endl;
+	}
+
+	stopAnimation();
+	setAnimationPeriod(m_period_before_stress);
+
+	if (m_stress_quit)
+		QApplication::quit();
+}
+
+
 void Viewer::init()
 {
 	makeCurrent();
@@ -43,75 +137,104 @@ void Viewer::init()
 
 	// initialisation variables globales
 	m_compteur = 0;
+
+	// le timer de la QGLViewer (touche A) ne sert qu'a redessiner,
+	// l'etat est avance a pas fixe par le thread d'animation,
+	// d'un degre toutes les 40 ms quel que soit le pas du thread
+	m_anim.start(0.0f, [] (float& compteur, double dt) { compteur += float(dt / 0.04); });
+	m_anim.set_paused(!animationIsStarted());
 	m_angle1 = 0.0;
 	m_angle2 = 0.0;
 }
 
 
 
-void Viewer::draw_repere(const Mat4& global)
+int Viewer::build_repere(int parent, const Mat4& local)
 {
-	//	// exemple de definition de fonction (lambda) locale
-	//	float b=2.2f;
-	//	auto fonction_locale = [&] (float a)
-	//	{
-	//		std::cout << "param a="<< a << " & global b="<< b <<std::endl;
-	//	};
-
-	//	//appel
-	//	fonction_locale(1.1f);
+	int repere = m_scene.add_node(parent, local);
 
-    auto fleche = [&] (Mat4 tr, Vec3 coul) -> void
-    {
-        m_prim.draw_cylinder(tr*translate(0,0,1.5)*scale(0.5,0.5,2.5), coul);
-        m_prim.draw_cone(tr*translate(0,0,3), coul);
-    };
+	auto fleche = [&] (Mat4 tr, Vec3 coul) -> void
+	{
+		m_scene.add_shape(repere, tr*translate(0,0,1.5)*scale(0.5,0.5,2.5), Primitives::CYLINDER, coul);
+		m_scene.add_shape(repere, tr*translate(0,0,3), Primitives::CONE, coul);
+	};
 
-    m_prim.draw_sphere(global, BLANC);
-    fleche(global, BLEU);
-    fleche(global*rotateY(90), ROUGE);
-    fleche(global*rotateX(-90), VERT);
+	m_scene.add_shape(repere, Mat4(), Primitives::SPHERE, BLANC);
+	fleche(Mat4(), BLEU);
+	fleche(rotateY(90), ROUGE);
+	fleche(rotateX(-90), VERT);
 
-    // axe X
-    //m_prim.draw_cylinder(rotateY(90)*translate(0,0,1.5)*scale(0.5,0.5,2.5), ROUGE);
-    //m_prim.draw_cone(rotateY(90)*translate(0,0,3), ROUGE);
-    // axe Y
-    //m_prim.draw_cylinder(rotateX(-90)*translate(0,0,1.5)*scale(0.5,0.5,2.5), VERT);
-    //m_prim.draw_cone(rotateX(-90)*translate(0,0,3), VERT);
-    // axe Z
-    //m_prim.draw_cylinder(translate(0,0,1.5)*scale(0.5,0.5,2.5), BLEU);
-    //m_prim.draw_cone(translate(0,0,3), BLEU);
+	return repere;
 }
 
 
 
-void Viewer::draw_main()
+void Viewer::build_main()
 {
-    // cvommencer par faire un doigt -> 3 phalanges (+ articulations)
-    float a = m_compteur;
+	// un doigt: 3 phalanges, chacune tourne (rotateZ) autour de son articulation
+	auto doigt = [&] ( Mat4 trf ) -> void
+	{
+		const float longueur[3] = { 2.0f, 2.0f, 1.5f };
+		const Vec3 couleur[3] = { ROUGE, VERT, BLEU };
+
+		int node = m_scene.add_node(-1, trf);
+		for (int p = 0; p < 3; ++p)
+		{
+			if (p > 0)
+				node = m_scene.add_node(node, translate(3,0,0));
+			m_scene.add_shape(node, Mat4(), Primitives::SPHERE, BLANC);    // articulation
+			node = m_scene.add_node(node, Mat4());
+			m_joints.push_back(node);
+			m_scene.add_shape(node, translate(1.5,0,0)*scale(longueur[p],0.5,0.8), Primitives::CUBE, couleur[p]);
+		}
+	};
+
+	doigt(Mat4());
+	doigt(translate(0,0,2));
+	doigt(translate(0,0,4));
+}
 
-    auto doigt = [&] ( Mat4 trf ) -> void
-    {
-        m_prim.draw_sphere(trf, BLANC);    // articulation de base
-        m_prim.draw_cube(trf*rotateZ(a)*translate(1.5,0,0)*scale(2,0.5,0.8), ROUGE);
 
-        trf *= rotateZ(a)*translate(3,0,0);
 
-        m_prim.draw_sphere(trf, BLANC);
-        m_prim.draw_cube(trf*rotateZ(a)*translate(1.5,0,0)*scale(2.0,0.5,0.8), VERT);
+void Viewer::build_scene()
+{
+	m_scene.clear();
+	m_orbits.clear();
+	m_joints.clear();
+
+	switch(m_code)
+	{
+		case 1:
+			build_repere(-1, Mat4());
+		break;
+		case 2:
+			build_repere(-1, Mat4());  // grand repère
+			// les petits reperes qui tournent autour du grand (positionnes par animate_scene)
+			for(int i = 0; i < nb_reperes(); i++)
+				m_orbits.push_back(build_repere(-1, Mat4()));
+		break;
+		case 3:
+			build_main();
+		break;
+	}
+
+	m_scene_code = m_code;
+	animate_scene();
+}
 
-        trf *= rotateZ(a)*translate(3,0,0);
 
-        m_prim.draw_sphere(trf, BLANC);
-        m_prim.draw_cube(trf*rotateZ(a)*translate(1.5,0,0)*scale(1.5,0.5,0.8), BLEU);
-    };
 
-    doigt(Mat4());
-    doigt(translate(0,0,2));
-    doigt(translate(0,0,4));
+void Viewer::animate_scene()
+{
+	for(int i = 0; i < int(m_orbits.size()); i++)
+		m_scene.set_local(m_orbits[i], rotateZ(10)*rotateY(-m_compteur-(i*360.0f/m_orbits.size()))*translate(6,0,0)*rotateY(-90)*scale(0.5,0.5,0.5)*rotateX(5*m_compteur));
 
+	for (int j : m_joints)
+		m_scene.set_local(j, rotateZ(m_compteur));
 }
 
+
+
 void Viewer::draw_basic()
 {
 	m_prim.draw_sphere(Mat4(), BLANC);
@@ -124,33 +247,85 @@ void Viewer::draw_basic()
 void Viewer::draw()
 {
 	makeCurrent();
+	if (m_stress_pending)
+	{
+		m_stress_pending = false;
+		start_stress();
+	}
+	m_stats.begin_frame();
+	m_prof.begin_frame();
+	m_prof.begin("frame");
+	GLState::begin_frame();
 	m_prim.set_matrices(getCurrentModelViewMatrix(),getCurrentProjectionMatrix());
+	m_prim.set_profiler(&m_prof);
 
-	Mat4 glob;
+	// primitives hors champ ignorees (plans recalcules si la camera a bouge)
+	if (camera()->matricesVersion() != m_frustum_version)
+	{
+		m_frustum_version = camera()->matricesVersion();
+		GLdouble coef[6][4];
+		camera()->getFrustumPlanesCoefficients(coef);
+		m_frustum.set_planes(coef);
+	}
+	m_prim.set_culling(m_culling ? &m_frustum : NULL);
+
+	// les draw_* sont regroupes en 1 draw instancie par primitive
+	if (m_batch)
+		m_prim.begin_batch();
+
+	// etat d'animation: interpolation entre les 2 derniers pas publies
+	float prev, cur;
+	const float alpha = m_anim.snapshot(prev, cur);
+	const float compteur = prev + (cur-prev)*alpha;
+	if (compteur != m_compteur)
+	{
+		m_compteur = compteur;
+		if (m_scene_code == m_code)
+			animate_scene();
+	}
 
 	switch(m_code)
 	{
 		case 0:
 			draw_basic();
 		break;
-		case 1:
-			draw_repere(glob);
+		default:
+			// reperes et main: graphe de scene, seuls les sous-arbres animes sont recalcules
+			if (m_scene_code != m_code)
+			{
+				Profiler::Scope prof(&m_prof, "scene.build");
+				build_scene();
+			}
+			{
+				Profiler::Scope prof(&m_prof, "scene.update");
+				m_scene.update();
+			}
+			{
+				Profiler::Scope prof(&m_prof, "scene.draw");
+				m_scene.draw(m_prim);
+			}
 		break;
-		case 2:
-			// coder ici les petits reperes qui tournet autour du grand repere
-            draw_repere(glob);  // grand repère
-            // le nombre de repères tounant  autour du grand
-            #define NB 100
-            for(int i = 0; i < NB; i++)
-            {
-                glob = rotateZ(10)*rotateY(-m_compteur-(i*360/NB))*translate(6,0,0)*rotateY(-90)*scale(0.5,0.5,0.5)*rotateX(5*m_compteur);
-                draw_repere(glob);  // un petit repère
-            }
+	}
 
-		break;
-        case 3:
-            draw_main();
-		break;
+	if (m_batch)
+		m_prim.end_batch();
+
+	GLState::end_frame();
+	m_prof.end();
+	m_prof.end_frame();
+
+	if (m_prof_overlay)
+	{
+		const std::vector<std::string> lines = m_prof.to_text();
+		for (std::size_t i=0; i<lines.size(); ++i)
+			drawText(10, 40 + 15*int(i), QString::fromStdString(lines[i]));
+	}
+
+	if (m_stats.running())
+	{
+		m_stats.end_frame();
+		if (!m_stats.running())
+			end_stress();
 	}
 }
 
@@ -184,6 +359,47 @@ void Viewer::keyPressEvent(QKeyEvent *e)
 		case Qt::Key_M:  // change le code execute dans draw()
 			m_code = (m_code+1)%4;
 			break;
+
+		case Qt::Key_Plus:  // code 2: x10 instances
+		case Qt::Key_Minus: // code 2: /10 instances
+			m_nb_instances = (e->key() == Qt::Key_Plus) ? std::min(MAX_INSTANCES, m_nb_instances*10) : std::max(MIN_INSTANCES, m_nb_instances/10);
+			m_scene_code = -1;
+			std::cout << "instances : " << m_nb_instances << " (" << nb_reperes() << " reperes)" << std::endl;
+			break;
+
+		case Qt::Key_P:  // mesure du code 2 (chauffe + fenetre de mesure, JSON)
+			if (!m_stats.running())
+			{
+				m_code = 2;
+				m_stress_pending = true;
+			}
+			break;
+
+		case Qt::Key_T:  // temps par zone: affichage on/off (JSON en sortie standard)
+			m_prof_overlay = !m_prof_overlay;
+			if (!m_prof_overlay)
+				std::cout << m_prof.to_json() << std::endl;
+			break;
+
+		case Qt::Key_B:  // rendu instancie on/off
+			m_batch = !m_batch;
+			std::cout << "batch : " << (m_batch ? "on" : "off") << std::endl;
+			break;
+
+		case Qt::Key_L:  // niveaux de detail on/off
+			m_lod = !m_lod;
+			m_prim.set_lod(m_lod);
+			std::cout << "lod : " << (m_lod ? "on" : "off") << std::endl;
+			break;
+
+		case Qt::Key_C:  // culling on/off
+		{
+			m_culling = !m_culling;
+			const GLState::Stats& st = GLState::stats();
+			std::cout << "culling : " << (m_culling ? "on" : "off") << " (" << st.frustumCulled << "/" << st.objectsTested << " rejetes)" << std::endl;
+			GLState::resetStats();
+		}
+			break;
 		default:
 			break;
 	}
@@ -196,39 +412,29 @@ void Viewer::keyPressEvent(QKeyEvent *e)
 
 
 
-void Viewer::animate()
+void Viewer::startAnimation()
 {
-	m_compteur += 1;
-
-	// faire varier les angles ici pour animer
+	QGLViewer::startAnimation();
+	m_anim.set_paused(false);
 }
 
 
+void Viewer::stopAnimation()
+{
+	QGLViewer::stopAnimation();
+	m_anim.set_paused(true);
+}
+
 
 
 Mat4 Viewer::getCurrentModelViewMatrix() const
 {
-	GLdouble gl_mvm[16];
-	camera()->getModelViewMatrix(gl_mvm);
-	Mat4 mvm;
-	for(unsigned int i = 0; i < 4; ++i)
-	{
-		for(unsigned int j = 0; j < 4; ++j)
-			mvm[i][j] = float(gl_mvm[i*4+j]);
-	}
-	return mvm;
+	// copie de la matrice float en cache dans la camera (pas de conversion)
+	return glm::make_mat4(camera()->modelViewMatrixf());
 }
 
 
 Mat4 Viewer::getCurrentProjectionMatrix() const
 {
-	GLdouble gl_pm[16];
-	camera()->getProjectionMatrix(gl_pm);
-	Mat4 pm;
-	for(unsigned int i = 0; i < 4; ++i)
-	{
-		for(unsigned int j = 0; j < 4; ++j)
-			pm[i][j] = float(gl_pm[i*4+j]);
-	}
-	return pm;
+	return glm::make_mat4(camera()->projectionMatrixf());
 }
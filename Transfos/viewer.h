@@ -4,9 +4,16 @@
 #include <GL/glew.h>
 #include <QGLViewer/qglviewer.h>
 #include <OGLRender/shaderprogramcolor.h>
+#include <OGLRender/glstate.h>
+#include <OGLRender/primitives.h>
+#include <OGLRender/scenegraph.h>
+#include <OGLRender/animationthread.h>
+#include <OGLRender/framestats.h>
+#include <OGLRender/profiler.h>
+
+#include <string>
 
 #include <matrices.h>
-#include <primitives.h>
 
 
 
@@ -23,6 +30,19 @@ class Viewer : public QGLViewer
 public:
 	Viewer();
 
+	/// contexte GL courant pendant la destruction des membres (programmes partages)
+	~Viewer();
+
+	/**
+	 * @brief mesure du code 2 lancee a la 1ere frame
+	 * @param instances nombre d'instances de primitives (10 a 10^6)
+	 * @param warmup nombre de frames de chauffe
+	 * @param frames nombre de frames mesurees
+	 * @param json_path fichier de resultats (vide: sortie standard)
+	 * @param quit quitte l'application a la fin de la mesure
+	 */
+	void set_stress(int instances, int warmup, int frames, const std::string& json_path, bool quit);
+
 protected:
 	/// intialisation OpenGL, appelee  a l'ouverture de la fenetre
     void init();
@@ -30,8 +50,9 @@ protected:
 	/// appelee pour afficher le contenu
     void draw();
 
-	/// appelee ~50x/s (voir startAnimation()/stopAnimation() dans keyPressEvent)
-	void animate();
+	/// le timer de la QGLViewer redessine, m_anim avance l'etat (touche A)
+	void startAnimation();
+	void stopAnimation();
 
 	/// appele si une touche est enfoncee
     void keyPressEvent(QKeyEvent *e);
@@ -54,8 +75,11 @@ protected:
 	Vec3 GRIS;
 	Vec3 NOIR;
 
-	/// compteur (incremente dans animate
-	int m_compteur;
+	/// animation a pas fixe (thread): compteur incremente toutes les 20ms
+	AnimationThread<float> m_anim;
+
+	/// compteur interpole a l'instant du rendu (lu dans m_anim par draw)
+	float m_compteur;
 	float m_angle1;
 	float m_angle2;
 
@@ -65,16 +89,73 @@ protected:
 	//
 	int m_code;
 
-	 /**
-	 * @brief dessine un repere
-	 * @param global matrice de positionnement du repere
+	/// dessin des primitives en mode batch (instancie)
+	bool m_batch;
+
+	/// choix du niveau de detail des primitives selon leur taille a l'ecran
+	bool m_lod;
+
+	/// pyramide de vision de la frame (culling des primitives)
+	Frustum m_frustum;
+	/// version des matrices de la camera lors du calcul de m_frustum
+	unsigned long m_frustum_version;
+	bool m_culling;
+
+	/// graphe de scene des codes 1 a 3 (reperes, main)
+	SceneGraph m_scene;
+	/// code pour lequel m_scene a ete construite (-1: aucun)
+	int m_scene_code;
+	/// noeuds animes: petits reperes (code 2), articulations (code 3)
+	std::vector<int> m_orbits;
+	std::vector<int> m_joints;
+
+	/// nombre d'instances de primitives du code 2 (touches +/-)
+	int m_nb_instances;
+
+	/// mesure de performances (touche P ou set_stress)
+	FrameStats m_stats;
+	int m_stress_warmup;
+	int m_stress_frames;
+	std::string m_stress_json;
+	bool m_stress_quit;
+	bool m_stress_pending;
+	int m_period_before_stress;
+
+	/// temps CPU/GPU par zone de draw(), affiches par la touche T
+	Profiler m_prof;
+	bool m_prof_overlay;
+
+	/// nombre de petits reperes du code 2
+	int nb_reperes() const;
+
+	/// debut de mesure: reconstruit la scene, redessine en continu
+	void start_stress();
+
+	/// fin de mesure: ecrit le JSON
+	void end_stress();
+
+	/**
+	 * @brief ajoute un repere a la scene
+	 * @param parent noeud parent (-1: racine)
+	 * @param local matrice de positionnement du repere
+	 * @return noeud du repere
+	 */
+	int build_repere(int parent, const Mat4& local);
+
+	/**
+	 * @brief ajoute une main a la scene (3 doigts de 3 phalanges)
+	 */
+	void build_main();
+
+	/**
+	 * @brief construit la scene du code m_code
 	 */
-	void draw_repere(const Mat4& global);
+	void build_scene();
 
 	/**
-	 * @brief dessine une main
+	 * @brief met a jour les transfos locales animees (m_compteur)
 	 */
-	void draw_main();
+	void animate_scene();
 
 	/**
 	 * @brief dessine qq primitives
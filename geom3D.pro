@@ -1,6 +1,6 @@
 TEMPLATE = subdirs
 
-SUBDIRS = QGLViewer OGLRender Transfos Revolution Projet_modeling 
+SUBDIRS = QGLViewer OGLRender Transfos Revolution Projet_modeling BatchMathBench CullingTest
 
  # what subproject depends on others
 Transfos.depends = QGLViewer OGLRender